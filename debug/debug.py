@@ -7,6 +7,7 @@ import matplotlib.animation as anim
 import matplotlib.gridspec as gridspec
 import argparse
 import serial
+import struct
 import time
 import sys
 import os
@@ -19,6 +20,121 @@ warnings.filterwarnings('ignore')
 
 UART_PACKET_FOOTER = b'\x00\x01\x02\x03\x04\x05\x06\x07'
 
+# Continuous audio stream, see audio_stream_packet_t in target/main/debug.h.
+# Packets hold 100ms of audio.
+AUDIO_STREAM_PACKET_MS = 100
+# Sequence number, sample index, predictor, step index and a reserved byte.
+AUDIO_STREAM_HEADER = struct.Struct('<HIhBB')
+
+# Quantizer step sizes and step index changes of the IMA ADPCM standard, see
+# target/main/adpcm.cc.
+IMA_STEP_TABLE = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41,
+    45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209,
+    230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876,
+    963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749,
+    3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630,
+    9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385,
+    24623, 27086, 29794, 32767]
+IMA_INDEX_TABLE = [-1, -1, -1, -1, 2, 4, 6, 8] * 2
+
+
+def decode_adpcm(data, num_samples, predictor, step_index):
+    """Decodes IMA ADPCM samples, two per byte with the first one in the lower
+    nibble, starting from the given decoder state."""
+    samples = np.zeros(num_samples, dtype=np.int16)
+    for i in range(num_samples):
+        nibble = (data[i // 2] >> (4 * (i % 2))) & 0xf
+        step = IMA_STEP_TABLE[step_index]
+        delta = step >> 3
+        if nibble & 4:
+            delta += step
+        if nibble & 2:
+            delta += step >> 1
+        if nibble & 1:
+            delta += step >> 2
+        predictor = predictor - delta if nibble & 8 else predictor + delta
+        predictor = min(max(predictor, -32768), 32767)
+        step_index = min(max(step_index + IMA_INDEX_TABLE[nibble], 0), 88)
+        samples[i] = predictor
+    return samples
+
+
+def read_packets(source):
+    """Yields the packets from a serial port, or from a file with a raw
+    capture of the serial data. An empty packet means that nothing has arrived
+    for a while."""
+    if isinstance(source, serial.Serial):
+        while True:
+            yield source.read_until(UART_PACKET_FOOTER)
+    with open(source, 'rb') as f:
+        packets = f.read().split(UART_PACKET_FOOTER)
+    # The last part is incomplete, as it lacks its footer.
+    for packet in packets[:-1]:
+        yield packet + UART_PACKET_FOOTER
+
+
+def receive_audio_stream(args, source):
+    """Receives the continuous audio stream of CONFIG_MICRO_KWS_DEBUG_AUDIO_STREAM
+    and returns it as one array. Lost packets are replaced by silence."""
+    packet_samples = args.sample_rate * AUDIO_STREAM_PACKET_MS // 1000
+    payload_bytes = packet_samples // 2
+    packet_bytes = AUDIO_STREAM_HEADER.size + payload_bytes + \
+        len(UART_PACKET_FOOTER)
+    total_samples = int(args.sample_rate * args.audio_total_length)
+    chunks = []
+    num_samples = 0
+    next_sequence = None
+    next_sample_index = None
+    received_packets = 0
+    lost_packets = 0
+    last_packet_time = 0
+    print('Waiting for audio stream...')
+    try:
+        for raw_data in read_packets(source):
+            if total_samples > 0 and num_samples >= total_samples:
+                break
+            if len(raw_data) != packet_bytes:
+                if last_packet_time != 0 and \
+                        time.perf_counter() - last_packet_time > 2:
+                    break
+                if len(raw_data) > 0:
+                    print('Wrong packet size:', len(raw_data),
+                          'but expected', packet_bytes)
+                continue
+            last_packet_time = time.perf_counter()
+            sequence, sample_index, predictor, step_index, _ = \
+                AUDIO_STREAM_HEADER.unpack_from(raw_data)
+
+            # The sample index tells how much audio the missing packets held.
+            if next_sequence is not None and sequence != next_sequence:
+                missing = (sequence - next_sequence) & 0xffff
+                missing_samples = (sample_index - next_sample_index) & \
+                    0xffffffff
+                print('Lost', missing, 'packets, inserting',
+                      missing_samples, 'samples of silence.')
+                lost_packets += missing
+                chunks.append(np.zeros(missing_samples, dtype=np.int16))
+                num_samples += missing_samples
+            next_sequence = (sequence + 1) & 0xffff
+            next_sample_index = (sample_index + packet_samples) & 0xffffffff
+
+            chunks.append(decode_adpcm(
+                raw_data[AUDIO_STREAM_HEADER.size:], packet_samples,
+                predictor, step_index))
+            num_samples += packet_samples
+            received_packets += 1
+            if received_packets % 10 == 0:
+                print('Received %.1fs of audio.' %
+                      (num_samples / args.sample_rate))
+    except KeyboardInterrupt:
+        pass
+
+    print('Received %d packets, lost %d.' % (received_packets, lost_packets))
+    if len(chunks) == 0:
+        return np.array([], dtype=np.int16)
+    return np.concatenate(chunks)
+
 class LoopRunner():
 
     def __init__(self, args: argparse.Namespace, ser: serial.Serial):
@@ -230,10 +346,31 @@ def main():
                         default=0.1, help='Length of each audio packet transmitted via the serial connection [in seconds].')
     parser.add_argument('-afn', '--audio-file-name', type=str,
                         default='audio_test.wav', help='Name of the audio file to create (needs to end in .wav).')
+    parser.add_argument('-as', '--audio-stream', default=False,
+                        action='store_true', help='Receive the continuous audio stream instead (needs CONFIG_MICRO_KWS_DEBUG_AUDIO_STREAM). Runs until --audio-total-length, use 0 to run until CTRL+C.')
+    parser.add_argument('-ai', '--audio-input', type=str, default=None,
+                        help='Read the audio stream from a raw capture of the serial data in this file instead of from the serial port.')
+
+    parser.add_argument('-sr', '--sample-rate', type=int, default=16000,
+                        help='Sample rate of the audio (8000 with CONFIG_MICRO_KWS_AUDIO_SAMPLE_RATE_8000).')
 
     # Parse arguments
     args = parser.parse_args()
 
+    if args.audio_stream:
+        source = args.audio_input
+        if source is None:
+            print('Starting UART connection on %s with %d baud.' %
+                  (args.port, args.baudrate))
+            source = serial.Serial(args.port, args.baudrate, timeout=0.75)
+            source.reset_input_buffer()
+        audio_buffer = receive_audio_stream(args, source)
+        scipy.io.wavfile.write(args.audio_file_name,
+                               args.sample_rate, audio_buffer)
+        print('Wrote %.1fs of audio to %s' %
+              (len(audio_buffer) / args.sample_rate, args.audio_file_name))
+        sys.exit(0)
+
     # Initalize UART connection
     print('Starting UART connection on %s with %d baud.' %
           (args.port, args.baudrate))
@@ -243,8 +380,9 @@ def main():
     if args.audio:
         audio_buffer = np.array([], dtype=np.int16)
         audio_received_bytes = 0
-        audio_total_bytes = int(2 * 16000 * args.audio_total_length)
-        audio_payload_bytes = int(2 * 16000 * args.audio_packet_length)
+        audio_total_bytes = int(2 * args.sample_rate * args.audio_total_length)
+        audio_payload_bytes = int(
+            2 * args.sample_rate * args.audio_packet_length)
         audio_packet_bytes = audio_payload_bytes + len(UART_PACKET_FOOTER)
         last_packet_time = 0
         print('Waiting for audio data...')
@@ -271,7 +409,8 @@ def main():
         else:
             print('Received full', audio_received_bytes, 'bytes.')
 
-        scipy.io.wavfile.write(args.audio_file_name, 16000, audio_buffer)
+        scipy.io.wavfile.write(args.audio_file_name,
+                               args.sample_rate, audio_buffer)
         print('Wrote', audio_received_bytes, 'bytes to', args.audio_file_name)
 
         sys.exit(0)
@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmark of the IMA ADPCM codec of main/adpcm.h, see README.md. Measures the
+// time per sample and the signal-to-noise ratio for a few test signals. Can
+// also write a test signal as audio stream packets, like the device sends them
+// with CONFIG_MICRO_KWS_DEBUG_AUDIO_STREAM, to check the decoder of the
+// debugger.
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC 1
+#endif
+
+#include "adpcm.h"
+#include "debug.h"
+#include "model_settings.h"
+
+// Chunk size for encoding. It is odd, like the spans the device gets where the
+// audio queue wraps around, so that every chunk after the first one starts in
+// the middle of a byte.
+constexpr size_t chunk_samples = 255;
+
+// Every that many packets, the capture leaves one out, like a packet the
+// device had to drop. Never the last one, the debugger can not notice that.
+constexpr size_t dropped_packet_interval = 25;
+
+// `seconds` of a logarithmic sweep from 100 Hz to 7 kHz with the level
+// `level_db` relative to full scale, plus white noise at `noise_db`.
+static std::vector<int16_t> GenerateInput(double seconds, double level_db,
+                                          double noise_db) {
+  std::vector<int16_t> input((size_t)(seconds * audio_sample_frequency));
+  const double amplitude = 32767 * pow(10, level_db / 20);
+  // The RMS of uniform noise is a third of its peak squared.
+  const double noise = 32767 * pow(10, noise_db / 20) * sqrt(3);
+  const double ratio = log(7000.0 / 100.0);
+  srand(1);
+  double phase = 0.0;
+  for (size_t i = 0; i < input.size(); i++) {
+    phase += 2 * M_PI * 100 * exp(ratio * i / input.size()) /
+             audio_sample_frequency;
+    const double value =
+        amplitude * sin(phase) + noise * (2.0 * rand() / RAND_MAX - 1.0);
+    input[i] = (int16_t)std::clamp<long>(lround(value), INT16_MIN, INT16_MAX);
+  }
+  return input;
+}
+
+// Runs `function` and returns the time per sample in ns and cycles.
+template <typename Function>
+static void Measure(Function function, size_t num_samples, double* ns,
+                    double* cycles) {
+  const auto start = std::chrono::steady_clock::now();
+#ifdef HAVE_RDTSC
+  const uint64_t start_cycles = __rdtsc();
+#endif
+  function();
+#ifdef HAVE_RDTSC
+  *cycles = (double)(__rdtsc() - start_cycles) / num_samples;
+#else
+  *cycles = NAN;
+#endif
+  *ns = std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - start)
+            .count() /
+        num_samples;
+}
+
+// Encodes all of `input` in chunks and decodes it again.
+static void Benchmark(const char* name, const std::vector<int16_t>& input) {
+  std::vector<uint8_t> data((input.size() + 1) / 2);
+  std::vector<int16_t> output(input.size());
+  adpcm_state_t state;
+
+  double encode_ns = 0.0;
+  double encode_cycles = 0.0;
+  ResetAdpcm(&state);
+  Measure(
+      [&] {
+        for (size_t pos = 0; pos < input.size(); pos += chunk_samples) {
+          const size_t count = std::min(chunk_samples, input.size() - pos);
+          EncodeAdpcm(&state, &input[pos], count, data.data(), pos);
+        }
+      },
+      input.size(), &encode_ns, &encode_cycles);
+
+  double decode_ns = 0.0;
+  double decode_cycles = 0.0;
+  ResetAdpcm(&state);
+  Measure([&] { DecodeAdpcm(&state, data.data(), 0, input.size(),
+                            output.data()); },
+          input.size(), &decode_ns, &decode_cycles);
+
+  double signal = 0.0;
+  double noise = 0.0;
+  for (size_t i = 0; i < input.size(); i++) {
+    const double error = input[i] - output[i];
+    signal += (double)input[i] * input[i];
+    noise += error * error;
+  }
+  printf("%-22s %10.2f %9.2f %10.2f %9.2f %8.1f\n", name, encode_ns,
+         encode_cycles, decode_ns, decode_cycles, 10 * log10(signal / noise));
+}
+
+static void WriteWav(FILE* file, const std::vector<int16_t>& samples) {
+  const uint32_t data_size = samples.size() * sizeof(int16_t);
+  const uint32_t riff_size = 36 + data_size;
+  const uint32_t fmt_size = 16;
+  const uint16_t format = 1;
+  const uint16_t channels = 1;
+  const uint32_t rate = audio_sample_frequency;
+  const uint32_t byte_rate = rate * sizeof(int16_t);
+  const uint16_t block_align = sizeof(int16_t);
+  const uint16_t bits = 16;
+  fwrite("RIFF", 1, 4, file);
+  fwrite(&riff_size, sizeof(riff_size), 1, file);
+  fwrite("WAVEfmt ", 1, 8, file);
+  fwrite(&fmt_size, sizeof(fmt_size), 1, file);
+  fwrite(&format, sizeof(format), 1, file);
+  fwrite(&channels, sizeof(channels), 1, file);
+  fwrite(&rate, sizeof(rate), 1, file);
+  fwrite(&byte_rate, sizeof(byte_rate), 1, file);
+  fwrite(&block_align, sizeof(block_align), 1, file);
+  fwrite(&bits, sizeof(bits), 1, file);
+  fwrite("data", 1, 4, file);
+  fwrite(&data_size, sizeof(data_size), 1, file);
+  fwrite(samples.data(), sizeof(int16_t), samples.size(), file);
+}
+
+// Writes `input` as audio stream packets to `capture_path`, leaving out some
+// packets, and what the debugger should decode from them to `reference_path`.
+static int WriteCapture(const std::vector<int16_t>& input,
+                        const char* capture_path, const char* reference_path) {
+  FILE* capture = fopen(capture_path, "wb");
+  FILE* reference = fopen(reference_path, "wb");
+  if (capture == NULL || reference == NULL) {
+    fprintf(stderr, "Could not open %s or %s.\n", capture_path,
+            reference_path);
+    return EXIT_FAILURE;
+  }
+
+  const uint8_t packet_footer[] = {0x00, 0x01, 0x02, 0x03,
+                                   0x04, 0x05, 0x06, 0x07};
+  const size_t num_packets = input.size() / AUDIO_STREAM_PACKET_SAMPLES;
+  std::vector<int16_t> expected(num_packets * AUDIO_STREAM_PACKET_SAMPLES);
+  adpcm_state_t state;
+  ResetAdpcm(&state);
+  for (size_t i = 0; i < num_packets; i++) {
+    const size_t start = i * AUDIO_STREAM_PACKET_SAMPLES;
+    audio_stream_packet_t packet;
+    memset(&packet, 0, sizeof(packet));
+    packet.sequence = i;
+    packet.sample_index = start;
+    packet.predictor = state.predictor;
+    packet.step_index = state.step_index;
+    for (size_t pos = 0; pos < AUDIO_STREAM_PACKET_SAMPLES;
+         pos += chunk_samples) {
+      const size_t count =
+          std::min(chunk_samples, AUDIO_STREAM_PACKET_SAMPLES - pos);
+      EncodeAdpcm(&state, &input[start + pos], count, packet.data, pos);
+    }
+
+    // The debugger replaces a lost packet by silence.
+    if (i % dropped_packet_interval == dropped_packet_interval / 2) {
+      continue;
+    }
+    adpcm_state_t decoder = {packet.predictor, packet.step_index};
+    DecodeAdpcm(&decoder, packet.data, 0, AUDIO_STREAM_PACKET_SAMPLES,
+                &expected[start]);
+    fwrite(&packet, sizeof(packet), 1, capture);
+    fwrite(packet_footer, sizeof(packet_footer), 1, capture);
+  }
+  WriteWav(reference, expected);
+  fclose(capture);
+  fclose(reference);
+  printf("Wrote %zu packets to %s, leaving out every %zuth.\n", num_packets,
+         capture_path, dropped_packet_interval);
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char* argv[]) {
+  if (argc != 1 && argc != 3) {
+    fprintf(stderr,
+            "Usage: %s [CAPTURE REFERENCE]\n"
+            "\n"
+            "Benchmarks the IMA ADPCM codec at %" PRId32
+            " Hz. The test signals are\n"
+            "sweeps from 100 Hz to 7 kHz, some with white noise.\n"
+            "\n"
+            "With CAPTURE and REFERENCE, writes 10s of a sweep as audio\n"
+            "stream packets to CAPTURE, like the device sends them, and what\n"
+            "the debugger should decode from them as WAV file to REFERENCE.\n",
+            argv[0], audio_sample_frequency);
+    return EXIT_FAILURE;
+  }
+
+  if (argc == 3) {
+    return WriteCapture(GenerateInput(10.0, -6.0, -60.0), argv[1], argv[2]);
+  }
+
+  printf("Signal                 Encode ns  cycles    Decode ns  cycles    "
+         "SNR dB\n");
+  Benchmark("sweep -6 dBFS", GenerateInput(5.0, -6.0, -200.0));
+  Benchmark("sweep -30 dBFS", GenerateInput(5.0, -30.0, -200.0));
+  Benchmark("sweep -20 dBFS, noise", GenerateInput(5.0, -20.0, -30.0));
+  Benchmark("noise -20 dBFS", GenerateInput(5.0, -200.0, -20.0));
+  return EXIT_SUCCESS;
+}
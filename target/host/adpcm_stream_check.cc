@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Check of the audio stream of CONFIG_MICRO_KWS_DEBUG_AUDIO_STREAM, see
+// README.md. Encodes a test signal into packets like StreamAudio() of
+// debug.cc, leaves some of them out like packets the device had to drop, and
+// receives the rest like receive_audio_stream() of debug/debug.py. The
+// sequence numbers and the sample indices of the packets wrap around during
+// the stream, one loss right across the wrap of the sequence numbers. Checks
+// that every loss is detected with the right number of packets and samples of
+// silence, and that all other samples match a decoder that got every packet.
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <random>
+#include <vector>
+
+#include "adpcm.h"
+#include "debug.h"
+#include "model_settings.h"
+
+constexpr size_t packet_samples = AUDIO_STREAM_PACKET_SAMPLES;
+constexpr size_t num_packets = 40;
+
+// The sample indices wrap around at packet 10, the sequence numbers at packet
+// 20.
+constexpr uint32_t first_sample_index = (uint32_t)(0 - 10 * packet_samples);
+constexpr uint16_t first_sequence = (uint16_t)(0 - 20);
+
+// Runs of packets the device drops, as first packet and number of packets.
+// Never the first or the last packet, the receiver can not notice those.
+struct Loss {
+  size_t first;
+  size_t count;
+};
+constexpr Loss losses[] = {{5, 1}, {19, 3}, {30, 1}};
+
+// A loss as the receiver sees it, with the number of samples of silence it
+// inserts in place of the lost packets.
+struct DetectedLoss {
+  size_t first;
+  size_t count;
+  size_t num_samples;
+};
+
+// Spans of the audio queue have any length, and odd ones make the encoder
+// start in the middle of a byte, see adpcm_bench.cc.
+constexpr size_t span_samples[] = {255, 256, 1, 1000, 77};
+
+// A sweep with noise, close to full scale at times, so that the predictor
+// saturates as well.
+static std::vector<int16_t> GenerateInput() {
+  std::vector<int16_t> input(num_packets * packet_samples);
+  std::mt19937 generator(1);
+  std::uniform_real_distribution<double> noise(-2000.0, 2000.0);
+  double phase = 0.0;
+  for (size_t i = 0; i < input.size(); i++) {
+    phase += 2 * M_PI * (100 + 6900.0 * i / input.size()) /
+             audio_sample_frequency;
+    const double value = 34000 * sin(phase) * sin(M_PI * i / input.size()) +
+                         noise(generator);
+    input[i] = (int16_t)std::clamp<long>(lround(value), INT16_MIN, INT16_MAX);
+  }
+  return input;
+}
+
+static bool IsLost(size_t packet) {
+  for (const Loss& loss : losses) {
+    if (packet >= loss.first && packet < loss.first + loss.count) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Encodes `input` into packets, in spans of varying length.
+static std::vector<audio_stream_packet_t> EncodePackets(
+    const std::vector<int16_t>& input) {
+  std::vector<audio_stream_packet_t> packets(num_packets);
+  adpcm_state_t state;
+  ResetAdpcm(&state);
+  size_t span = 0;
+  for (size_t i = 0; i < num_packets; i++) {
+    audio_stream_packet_t* packet = &packets[i];
+    memset(packet, 0, sizeof(*packet));
+    packet->sequence = (uint16_t)(first_sequence + i);
+    packet->sample_index = (uint32_t)(first_sample_index + i * packet_samples);
+    packet->predictor = state.predictor;
+    packet->step_index = state.step_index;
+    for (size_t pos = 0; pos < packet_samples;) {
+      const size_t count = std::min(span_samples[span++ % 5],
+                                    packet_samples - pos);
+      EncodeAdpcm(&state, &input[i * packet_samples + pos], count,
+                  packet->data, pos);
+      pos += count;
+    }
+  }
+  return packets;
+}
+
+// Like receive_audio_stream() of debug.py: decodes every packet on its own
+// from the state in its header, and replaces lost packets by silence, as many
+// samples as the sample index says are missing.
+static std::vector<int16_t> ReceivePackets(
+    const std::vector<audio_stream_packet_t>& packets,
+    std::vector<DetectedLoss>* detected_losses) {
+  std::vector<int16_t> output;
+  uint16_t next_sequence = 0;
+  uint32_t next_sample_index = 0;
+  bool first = true;
+  for (const audio_stream_packet_t& packet : packets) {
+    if (!first && packet.sequence != next_sequence) {
+      const uint16_t missing = packet.sequence - next_sequence;
+      const uint32_t missing_samples = packet.sample_index - next_sample_index;
+      printf("Lost %" PRIu16 " packets, inserting %" PRIu32
+             " samples of silence.\n",
+             missing, missing_samples);
+      detected_losses->push_back(
+          {(size_t)(uint16_t)(next_sequence - first_sequence), missing,
+           missing_samples});
+      output.resize(output.size() + missing_samples, 0);
+    }
+    first = false;
+    next_sequence = packet.sequence + 1;
+    next_sample_index = packet.sample_index + packet_samples;
+
+    adpcm_state_t state = {packet.predictor, packet.step_index};
+    output.resize(output.size() + packet_samples);
+    DecodeAdpcm(&state, packet.data, 0, packet_samples,
+                &output[output.size() - packet_samples]);
+  }
+  return output;
+}
+
+int main() {
+  const std::vector<int16_t> input = GenerateInput();
+  const std::vector<audio_stream_packet_t> packets = EncodePackets(input);
+
+  // A decoder that gets all packets runs through the whole stream with one
+  // state, and the lost packets become silence.
+  std::vector<int16_t> reference(input.size());
+  adpcm_state_t state;
+  ResetAdpcm(&state);
+  for (size_t i = 0; i < num_packets; i++) {
+    DecodeAdpcm(&state, packets[i].data, 0, packet_samples,
+                &reference[i * packet_samples]);
+  }
+  double signal = 0.0;
+  double noise = 0.0;
+  for (size_t i = 0; i < input.size(); i++) {
+    const double error = input[i] - reference[i];
+    signal += (double)input[i] * input[i];
+    noise += error * error;
+  }
+  for (size_t i = 0; i < num_packets; i++) {
+    if (IsLost(i)) {
+      std::fill_n(&reference[i * packet_samples], packet_samples, 0);
+    }
+  }
+
+  std::vector<audio_stream_packet_t> received;
+  for (size_t i = 0; i < num_packets; i++) {
+    if (!IsLost(i)) {
+      received.push_back(packets[i]);
+    }
+  }
+  std::vector<DetectedLoss> detected_losses;
+  const std::vector<int16_t> output =
+      ReceivePackets(received, &detected_losses);
+
+  // Every loss has to be found at the right packet, with silence of the
+  // length of the lost packets.
+  bool losses_exact = detected_losses.size() == std::size(losses);
+  bool silence_exact = losses_exact;
+  size_t num_lost_packets = 0;
+  for (size_t i = 0; i < std::size(losses); i++) {
+    num_lost_packets += losses[i].count;
+    if (i >= detected_losses.size()) {
+      continue;
+    }
+    losses_exact &= detected_losses[i].first == losses[i].first &&
+                    detected_losses[i].count == losses[i].count;
+    silence_exact &=
+        detected_losses[i].num_samples == losses[i].count * packet_samples;
+  }
+  size_t num_mismatches = 0;
+  if (output.size() != reference.size()) {
+    printf("Received %zu samples, expected %zu.\n", output.size(),
+           reference.size());
+    num_mismatches = reference.size();
+  } else {
+    for (size_t i = 0; i < output.size(); i++) {
+      num_mismatches += output[i] != reference[i];
+    }
+  }
+
+  printf("%zu packets, %zu lost in %zu runs, SNR %.1f dB\n", num_packets,
+         num_lost_packets, std::size(losses), 10 * log10(signal / noise));
+  printf("Losses detected: %s, silence inserted: %s, samples exact: %s\n",
+         losses_exact ? "yes" : "no", silence_exact ? "yes" : "no",
+         num_mismatches == 0 ? "yes" : "no");
+  return losses_exact && silence_exact && num_mismatches == 0 ? EXIT_SUCCESS
+                                                              : EXIT_FAILURE;
+}
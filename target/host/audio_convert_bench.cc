@@ -0,0 +1,405 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmark of the sample conversion of main/audio_convert.h, see README.md.
+// For every gain, measures the time per sample with and without the DC
+// blocker and compares the results with a floating point reference. Then
+// checks the exact output for the alignment of 24 bit samples, saturation,
+// the settling of the DC blocker and blocks of every length, and fails on a
+// mismatch.
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC 1
+#endif
+
+#include "audio_convert.h"
+#include "model_settings.h"
+
+// Size of the DMA buffers of the I2S source, see audio_source_i2s.cc.
+constexpr size_t chunk_samples = 300;
+
+// One second of a 24 bit, 1 kHz sine, which only reaches half of full scale
+// with the largest gain, plus a DC offset of a quarter of full scale, in 32
+// bit slots.
+static std::vector<int32_t> GenerateInput(uint32_t rate) {
+  std::vector<int32_t> input(rate);
+  for (size_t i = 0; i < input.size(); i++) {
+    const double value =
+        0.25 + 0.5 / (1 << max_convert_gain_shift) *
+                   sin(2 * M_PI * 1000 * i / rate);
+    input[i] = (int32_t)lround(value * (1 << 23)) * 256;
+  }
+  return input;
+}
+
+// Converts all of `input` in chunks like the I2S source does, and returns the
+// time per sample in ns and cycles.
+static void Convert(const std::vector<int32_t>& input,
+                    std::vector<int16_t>* output, uint32_t gain_shift,
+                    dc_blocker_t* dc_blocker, double* ns, double* cycles) {
+  const auto start = std::chrono::steady_clock::now();
+#ifdef HAVE_RDTSC
+  const uint64_t start_cycles = __rdtsc();
+#endif
+  for (size_t pos = 0; pos < input.size(); pos += chunk_samples) {
+    const size_t count = std::min(chunk_samples, input.size() - pos);
+    if (dc_blocker != NULL) {
+      ConvertAudioSamplesDcBlocked(&input[pos], &(*output)[pos], count, 1,
+                                   gain_shift, dc_blocker);
+    } else {
+      ConvertAudioSamples(&input[pos], &(*output)[pos], count, gain_shift);
+    }
+  }
+#ifdef HAVE_RDTSC
+  *cycles = (double)(__rdtsc() - start_cycles) / input.size();
+#else
+  *cycles = NAN;
+#endif
+  *ns = std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - start)
+            .count() /
+        input.size();
+}
+
+// Largest difference to the same filter in floating point, in 16 bit LSBs,
+// and the mean of the output after the filter has settled.
+static void Compare(const std::vector<int32_t>& input,
+                    const std::vector<int16_t>& output, uint32_t gain_shift,
+                    const dc_blocker_t* dc_blocker, double* max_error,
+                    double* mean) {
+  const double scale = (double)(1 << gain_shift) / 65536;
+  const double pole =
+      dc_blocker != NULL ? 1 - 1.0 / (1 << dc_blocker->shift) : 0;
+  double last_input = 0.0;
+  double filtered = 0.0;
+  double sum = 0.0;
+  *max_error = 0.0;
+  for (size_t i = 0; i < input.size(); i++) {
+    double expected = input[i] * scale;
+    if (dc_blocker != NULL) {
+      filtered = expected - last_input + pole * filtered;
+      last_input = expected;
+      expected = filtered;
+    }
+    expected = std::clamp(expected, (double)INT16_MIN, (double)INT16_MAX);
+    *max_error = std::max(*max_error, fabs(output[i] - expected));
+    if (i >= input.size() / 2) {
+      sum += output[i];
+    }
+  }
+  *mean = sum / (input.size() - input.size() / 2);
+}
+
+// Like audio_convert.cc.
+constexpr uint32_t dc_fraction_bits = 5;
+
+// Exact output of ConvertAudioSamples() by its definition: the sample times
+// 2^gain_shift, rounded half up to its upper 16 bits and saturated.
+static int16_t ReferenceConvert(int32_t input, uint32_t gain_shift) {
+  const int64_t scaled = (int64_t)input * (1 << gain_shift);
+  return (int16_t)std::clamp<int64_t>((scaled + 32768) >> 16, INT16_MIN,
+                                      INT16_MAX);
+}
+
+// Exact output of ConvertAudioSamplesDcBlocked() by its definition: the filter
+// runs on the upper 24 bits with dc_fraction_bits extra bits, its decay and
+// the output are rounded half up, in 64 bit so that nothing overflows.
+static std::vector<int16_t> ReferenceConvertDcBlocked(
+    const std::vector<int32_t>& input, size_t num_channels,
+    uint32_t gain_shift, uint32_t shift) {
+  const uint32_t output_shift = dc_fraction_bits + 8 - gain_shift;
+  std::vector<int16_t> output(input.size());
+  for (size_t channel = 0; channel < num_channels; channel++) {
+    int64_t last_input = 0;
+    int64_t filtered = 0;
+    for (size_t i = channel; i < input.size(); i += num_channels) {
+      const int64_t sample = input[i] >> 8;
+      filtered += (sample - last_input) * (1 << dc_fraction_bits) -
+                  ((filtered + (1 << (shift - 1))) >> shift);
+      last_input = sample;
+      output[i] = (int16_t)std::clamp<int64_t>(
+          (filtered + (1 << (output_shift - 1))) >> output_shift, INT16_MIN,
+          INT16_MAX);
+    }
+  }
+  return output;
+}
+
+// Converts `input` with `num_channels` interleaved channels in blocks of 1, 2,
+// 3, ... samples per channel, so that every remainder of a vectorized loop
+// occurs. Also fails if a block writes past its end.
+static bool ConvertInBlocks(const std::vector<int32_t>& input,
+                            size_t num_channels, uint32_t gain_shift,
+                            dc_blocker_t* dc_blockers,
+                            std::vector<int16_t>* output) {
+  constexpr int16_t guard = 0x5a5a;
+  output->assign(input.size() + 1, 0);
+  bool all_inside = true;
+  size_t length = 1;
+  for (size_t pos = 0; pos < input.size();
+       pos += length * num_channels, length = length % 37 + 1) {
+    length = std::min(length, (input.size() - pos) / num_channels);
+    const size_t end = pos + length * num_channels;
+    (*output)[end] = guard;
+    if (dc_blockers != NULL) {
+      ConvertAudioSamplesDcBlocked(&input[pos], &(*output)[pos], length,
+                                   num_channels, gain_shift, dc_blockers);
+    } else {
+      ConvertAudioSamples(&input[pos], &(*output)[pos], length, gain_shift);
+    }
+    all_inside &= (*output)[end] == guard;
+  }
+  output->pop_back();
+  return all_inside;
+}
+
+// Known outputs of the 24 bit samples in the upper bits of their slot without
+// gain, i.e. their upper 16 bits rounded half up.
+static bool CheckAlignment() {
+  static const struct {
+    int32_t input;
+    int16_t output;
+  } cases[] = {
+      {0x00000000, 0},       {0x00000100, 0},
+      {0x00007f00, 0},       {0x00008000, 1},
+      {0x00010000, 1},       {0x12345600, 0x1234},
+      {0x12347f00, 0x1234},  {0x12348000, 0x1235},
+      {0x7fff7f00, 32767},   {0x7fff8000, 32767},
+      {0x7fffff00, 32767},   {-0x00000100, 0},
+      {-0x00008000, 0},      {-0x00008100, -1},
+      {-0x00010000, -1},     {-0x12345600, -0x1234},
+      {-0x12348000, -0x1234}, {-0x12348100, -0x1235},
+      {-0x7fff8000, -32767}, {INT32_MIN, -32768},
+  };
+  bool exact = true;
+  for (const auto& c : cases) {
+    int16_t output = 0;
+    ConvertAudioSamples(&c.input, &output, 1, 0);
+    if (output != c.output || ReferenceConvert(c.input, 0) != c.output) {
+      printf("0x%08" PRIx32 " converted to %d, expected %d\n",
+             (uint32_t)c.input, output, c.output);
+      exact = false;
+    }
+  }
+  return exact;
+}
+
+// Samples just below and above full scale at every gain, which have to
+// saturate exactly there, with and without the DC blocker. The DC blocker
+// passes a step from silence and a step between both ends unchanged, so these
+// saturate as well.
+static bool CheckSaturation(uint32_t rate) {
+  bool exact = true;
+  for (uint32_t gain_shift = 0; gain_shift <= max_convert_gain_shift;
+       gain_shift++) {
+    // One step of the 16 bit output.
+    const int64_t step = 65536 >> gain_shift;
+    const struct {
+      int64_t input;
+      int16_t output;
+    } cases[] = {
+        {32766 * step, 32766},
+        {32767 * step, 32767},
+        {32767 * step + step / 2 - 1, 32767},
+        {32767 * step + step / 2, 32767},
+        {32768 * step, 32767},
+        {INT32_MAX, 32767},
+        {-32767 * step, -32767},
+        {-32768 * step, -32768},
+        {-32768 * step - step / 2 - 1, -32768},
+        {-32769 * step, -32768},
+        {INT32_MIN, -32768},
+    };
+    for (const auto& c : cases) {
+      if (c.input < INT32_MIN || c.input > INT32_MAX) {
+        continue;
+      }
+      const int32_t input = (int32_t)c.input;
+      int16_t output = 0;
+      ConvertAudioSamples(&input, &output, 1, gain_shift);
+      if (output != c.output) {
+        printf("Gain %" PRIu32 ": 0x%08" PRIx32 " converted to %d, expected "
+               "%d\n",
+               gain_shift, (uint32_t)input, output, c.output);
+        exact = false;
+      }
+    }
+
+    const std::vector<int32_t> steps = {INT32_MAX, INT32_MIN, INT32_MAX,
+                                        INT32_MIN};
+    const int16_t expected[] = {32767, -32768, 32767, -32768};
+    dc_blocker_t dc_blocker;
+    InitializeDcBlocker(&dc_blocker, rate);
+    std::vector<int16_t> output(steps.size());
+    ConvertAudioSamplesDcBlocked(steps.data(), output.data(), steps.size(), 1,
+                                 gain_shift, &dc_blocker);
+    for (size_t i = 0; i < steps.size(); i++) {
+      if (output[i] != expected[i]) {
+        printf("Gain %" PRIu32 ": step %zu of the DC blocker is %d, expected "
+               "%d\n",
+               gain_shift, i, output[i], expected[i]);
+        exact = false;
+      }
+    }
+  }
+  return exact;
+}
+
+// A constant input at every gain. The first output is the whole step, after
+// which the DC blocker settles once its rounded decay no longer changes its
+// state. This happens at 2^(shift - 1) - 1 for a positive input and at
+// -2^(shift - 1) for a negative one, which leaves a few LSBs at high gains.
+static bool CheckDcSettling(uint32_t rate) {
+  bool exact = true;
+  for (uint32_t gain_shift = 0; gain_shift <= max_convert_gain_shift;
+       gain_shift++) {
+    for (int32_t level : {0x02000000, -0x02000000}) {
+      dc_blocker_t dc_blocker;
+      InitializeDcBlocker(&dc_blocker, rate);
+      const uint32_t output_shift = dc_fraction_bits + 8 - gain_shift;
+      const int32_t settled_state = level > 0
+                                        ? (1 << (dc_blocker.shift - 1)) - 1
+                                        : -(1 << (dc_blocker.shift - 1));
+      const int16_t settled =
+          (settled_state + (1 << (output_shift - 1))) >> output_shift;
+
+      const std::vector<int32_t> input(rate, level);
+      std::vector<int16_t> output(input.size());
+      ConvertAudioSamplesDcBlocked(input.data(), output.data(), input.size(),
+                                   1, gain_shift, &dc_blocker);
+      const std::vector<int16_t> reference =
+          ReferenceConvertDcBlocked(input, 1, gain_shift, dc_blocker.shift);
+
+      // After half a second, i.e. many time constants of the filter.
+      bool level_exact = output[0] == ReferenceConvert(level, gain_shift) &&
+                         output == reference;
+      for (size_t i = input.size() / 2; i < input.size(); i++) {
+        level_exact &= output[i] == settled;
+      }
+      if (!level_exact) {
+        printf("Gain %" PRIu32 ": DC blocker starts at %d and ends at %d for "
+               "0x%08" PRIx32 ", expected %d and %d\n",
+               gain_shift, output[0], output.back(), (uint32_t)level,
+               ReferenceConvert(level, gain_shift), settled);
+        exact = false;
+      }
+    }
+  }
+  return exact;
+}
+
+// Random samples of one and two channels, converted in blocks of every length
+// up to 37 samples, at every gain. Most are 24 bit samples, but some have the
+// lower bits of a 32 bit microphone, and some are large enough to saturate.
+static bool CheckBlockLengths(uint32_t rate) {
+  std::mt19937 generator(1);
+  std::uniform_int_distribution<int32_t> sample(INT32_MIN, INT32_MAX);
+  std::vector<int32_t> input(2 * 4096);
+  for (size_t i = 0; i < input.size(); i++) {
+    const int32_t value = sample(generator);
+    input[i] = i % 3 == 0 ? value : (value >> 4) & ~0xff;
+  }
+
+  bool exact = true;
+  for (uint32_t gain_shift = 0; gain_shift <= max_convert_gain_shift;
+       gain_shift++) {
+    std::vector<int16_t> output;
+    bool gain_exact = ConvertInBlocks(input, 1, gain_shift, NULL, &output);
+    for (size_t i = 0; i < input.size(); i++) {
+      gain_exact &= output[i] == ReferenceConvert(input[i], gain_shift);
+    }
+
+    for (size_t num_channels : {1, 2}) {
+      dc_blocker_t dc_blockers[2];
+      for (dc_blocker_t& dc_blocker : dc_blockers) {
+        InitializeDcBlocker(&dc_blocker, rate);
+      }
+      gain_exact &= ConvertInBlocks(input, num_channels, gain_shift,
+                                    dc_blockers, &output);
+      gain_exact &= output == ReferenceConvertDcBlocked(
+                                  input, num_channels, gain_shift,
+                                  dc_blockers[0].shift);
+    }
+    if (!gain_exact) {
+      printf("Gain %" PRIu32 ": blocks of every length differ\n", gain_shift);
+      exact = false;
+    }
+  }
+  return exact;
+}
+
+int main(int argc, char* argv[]) {
+  if (argc != 1) {
+    fprintf(stderr,
+            "Usage: %s\n"
+            "\n"
+            "Benchmarks the conversion of 24 or 32 bit I2S samples at\n"
+            "%" PRId32 " Hz for all gains. The input is a 1 kHz sine with a\n"
+            "DC offset, the error is relative to the same conversion in\n"
+            "floating point.\n",
+            argv[0], audio_capture_frequency);
+    return EXIT_FAILURE;
+  }
+
+  const std::vector<int32_t> input = GenerateInput(audio_capture_frequency);
+  std::vector<int16_t> output(input.size());
+
+  printf(
+      "Gain  DC blocker  ns/sample  cycles/sample  Max error  Output mean\n");
+  for (uint32_t gain_shift = 0; gain_shift <= max_convert_gain_shift;
+       gain_shift++) {
+    for (bool dc_block : {false, true}) {
+      dc_blocker_t dc_blocker;
+      InitializeDcBlocker(&dc_blocker, audio_capture_frequency);
+      double ns = 0.0;
+      double cycles = 0.0;
+      Convert(input, &output, gain_shift, dc_block ? &dc_blocker : NULL, &ns,
+              &cycles);
+      double max_error = 0.0;
+      double mean = 0.0;
+      Compare(input, output, gain_shift, dc_block ? &dc_blocker : NULL,
+              &max_error, &mean);
+      printf("%4" PRIu32 " %11s %10.2f %14.2f %10.2f %12.2f\n", gain_shift,
+             dc_block ? "on" : "off", ns, cycles, max_error, mean);
+    }
+  }
+
+  const bool alignment_exact = CheckAlignment();
+  const bool saturation_exact = CheckSaturation(audio_capture_frequency);
+  const bool settling_exact = CheckDcSettling(audio_capture_frequency);
+  const bool blocks_exact = CheckBlockLengths(audio_capture_frequency);
+  printf("\nExact: alignment %s, saturation %s, DC blocker settling %s, block "
+         "lengths %s\n",
+         alignment_exact ? "yes" : "no", saturation_exact ? "yes" : "no",
+         settling_exact ? "yes" : "no", blocks_exact ? "yes" : "no");
+  return alignment_exact && saturation_exact && settling_exact && blocks_exact
+             ? EXIT_SUCCESS
+             : EXIT_FAILURE;
+}
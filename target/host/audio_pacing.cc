@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Host replacement of main/audio_pacing.cc. The audio input waits for the
+// virtual clock instead of the tick count, see host_clock.h.
+
+#include "audio_pacing.h"
+
+#include "host_clock.h"
+
+esp_err_t WaitForAudioCaptureTime(int64_t capture_time_us) {
+  HostClockWaitForAudio(capture_time_us);
+  return ESP_OK;
+}
+
+void EndAudioCapture() {
+  HostClockEndOfAudio();
+  HostClockWaitForAudio(INT64_MAX);
+}
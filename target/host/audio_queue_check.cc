@@ -0,0 +1,400 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Check of the audio queue of audio.cc, see README.md. A test source delivers
+// numbered samples, but only as many blocks as the check has granted, so the
+// check decides how full the audio queue is. It then checks every sample and
+// position returned by AudioPeek():
+//  - With the queue kept full, the consumer advances by one sample per
+//    AudioPeek(), so the spans wrap around the end of the queue at every
+//    offset. The split has to be exactly at the end of the queue.
+//  - The consumer commits random parts of the peeked samples, in several
+//    AudioCommit() calls per AudioPeek().
+//  - The queue overruns, and the lost samples have to show up as a gap where
+//    the overrun policy drops them. The first gap is filled by committing the
+//    silence in parts, the second one is skipped with SkipAudioGap().
+// Built once per overrun policy, i.e. CONFIG_MICRO_KWS_AUDIO_OVERRUN.
+
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "audio.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "host_clock.h"
+#include "sdkconfig.h"
+
+// Like in audio.cc.
+constexpr size_t block_samples = 256;
+constexpr size_t queue_blocks = 64;
+constexpr size_t queue_samples = queue_blocks * block_samples;
+
+constexpr size_t num_random_wraps = 4;
+
+// Samples the source may deliver in total and has delivered so far, and the
+// capture task, which reads from the source.
+static std::atomic<uint64_t> granted_samples{0};
+static uint64_t delivered_samples = 0;
+static std::atomic<TaskHandle_t> source_task{NULL};
+
+// Every sample is numbered by its index in the audio stream. 31 is odd, so the
+// values only repeat every 65536 samples, which is more than the queue holds.
+static int16_t SampleValue(uint64_t index) {
+  return (int16_t)(uint16_t)(index * 31 + 7);
+}
+
+static esp_err_t StartTestSource() { return ESP_OK; }
+
+// Blocks until enough samples have been granted, just like a microphone blocks
+// until enough samples have been captured.
+static esp_err_t ReadTestSource(int16_t* samples, size_t num_samples,
+                                size_t* num_read) {
+  source_task.store(xTaskGetCurrentTaskHandle());
+  while (granted_samples.load() - delivered_samples < num_samples) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  }
+  for (size_t i = 0; i < num_samples; i++) {
+    samples[i] = SampleValue(delivered_samples + i);
+  }
+  delivered_samples += num_samples;
+  *num_read = num_samples;
+  return ESP_OK;
+}
+
+static esp_err_t StopTestSource() { return ESP_OK; }
+
+static const audio_source_t test_source = {
+    "test", StartTestSource, ReadTestSource, StopTestSource, true, 1,
+};
+
+static void GrantBlocks(size_t num_blocks) {
+  granted_samples.store(granted_samples.load() + num_blocks * block_samples);
+  const TaskHandle_t task = source_task.load();
+  if (task != NULL) {
+    xTaskNotifyGive(task);
+  }
+}
+
+// Returns once the capture task has done all it can, i.e. is blocked in the
+// source or waits for a free block. The virtual clock only moves on once all
+// tasks are blocked, see host_clock.h.
+static void Settle() { vTaskDelay(1); }
+
+// Index of the next sample the consumer expects.
+static uint64_t consumer_index = 0;
+static size_t num_errors = 0;
+
+#define CHECK(condition, ...)                                 \
+  do {                                                        \
+    if (!(condition)) {                                       \
+      if (num_errors++ < 10) {                                \
+        printf("%" PRIu64 ": ", consumer_index);              \
+        printf(__VA_ARGS__);                                  \
+        printf("\n");                                         \
+      }                                                       \
+    }                                                         \
+  } while (0)
+
+// Number of blocks that can still be granted without an overrun. The block
+// the consumer is in counts as used until it has been committed completely.
+// The capture task acquires a block before it reads the samples into it, so
+// one block has to stay free for that.
+static size_t FreeBlocks() {
+  const uint64_t waiting = granted_samples.load() - consumer_index;
+  return queue_blocks - 1 - (waiting + block_samples - 1) / block_samples;
+}
+
+static size_t NumSamples(const audio_span_t spans[2]) {
+  return spans[0].num_samples + spans[1].num_samples;
+}
+
+// Checks that `spans` hold the samples from consumer_index on.
+static void CheckSamples(const audio_span_t spans[2]) {
+  uint64_t index = consumer_index;
+  for (size_t s = 0; s < 2; s++) {
+    for (size_t i = 0; i < spans[s].num_samples; i++, index++) {
+      if (spans[s].samples[i] != SampleValue(index)) {
+        CHECK(false, "sample %" PRIu64 " is %d, expected %d", index,
+              spans[s].samples[i], SampleValue(index));
+        return;
+      }
+    }
+  }
+  CHECK(spans[0].num_samples > 0 || spans[1].num_samples == 0,
+        "second span without a first one");
+}
+
+// Keeps the audio queue full and advances by one sample per AudioPeek(), for
+// one whole round through the queue.
+static void CheckEveryOffset() {
+  size_t num_wrapped = 0;
+  for (size_t step = 0; step <= queue_samples; step++) {
+    const size_t free_blocks = FreeBlocks();
+    if (free_blocks > 0) {
+      GrantBlocks(free_blocks);
+      Settle();
+    }
+    const size_t waiting = granted_samples.load() - consumer_index;
+
+    audio_span_t spans[2];
+    audio_position_t position;
+    AudioPeek(waiting + 1, spans, &position);
+    CHECK(NumSamples(spans) == 0, "got %zu samples, fewer than requested",
+          NumSamples(spans));
+    AudioPeek(waiting, spans, &position);
+    CHECK(NumSamples(spans) == waiting, "got %zu of %zu samples",
+          NumSamples(spans), waiting);
+    CHECK(position.sample_index == consumer_index && position.gap_samples == 0,
+          "position %" PRIu64 ", gap %" PRIu32, position.sample_index,
+          position.gap_samples);
+    CheckSamples(spans);
+
+    // No samples have been dropped yet, so the samples at the end of the
+    // queue are those whose index is a multiple of its length.
+    const size_t until_end = queue_samples - consumer_index % queue_samples;
+    if (waiting > until_end) {
+      CHECK(spans[0].num_samples == until_end,
+            "first span has %zu samples, the queue ends after %zu",
+            spans[0].num_samples, until_end);
+      num_wrapped++;
+    } else {
+      CHECK(spans[1].num_samples == 0, "second span without wrapping");
+    }
+
+    // Nothing to skip, so the samples stay where they are.
+    SkipAudioGap();
+    AudioPeek(0, spans, &position);
+    CHECK(position.sample_index == consumer_index,
+          "SkipAudioGap() without a gap moved to %" PRIu64,
+          position.sample_index);
+    CHECK(AudioCommit(1) == ESP_OK, "AudioCommit(1) failed");
+    consumer_index++;
+  }
+  CHECK(num_wrapped >= queue_samples - 2 * block_samples,
+        "only %zu of the spans wrapped around", num_wrapped);
+}
+
+// Grants random numbers of blocks and commits random parts of the peeked
+// samples, in up to three AudioCommit() calls.
+static void CheckRandomCommits() {
+  std::mt19937 generator(1);
+  const uint64_t end_index = consumer_index + num_random_wraps * queue_samples;
+  while (consumer_index < end_index) {
+    GrantBlocks(std::uniform_int_distribution<size_t>(0, FreeBlocks())(
+        generator));
+    Settle();
+
+    audio_span_t spans[2];
+    audio_position_t position;
+    AudioPeek(0, spans, &position);
+    const size_t num_samples = NumSamples(spans);
+    CHECK(num_samples == granted_samples.load() - consumer_index,
+          "got %zu of %" PRIu64 " samples", num_samples,
+          granted_samples.load() - consumer_index);
+    // The position is only set if there are samples.
+    CHECK(num_samples == 0 || (position.sample_index == consumer_index &&
+                               position.gap_samples == 0),
+          "position %" PRIu64 ", gap %" PRIu32, position.sample_index,
+          position.gap_samples);
+    CheckSamples(spans);
+
+    size_t left = num_samples;
+    for (size_t part = 0; part < 3 && left > 0; part++) {
+      const size_t size =
+          std::uniform_int_distribution<size_t>(0, left)(generator);
+      CHECK(AudioCommit(size) == ESP_OK, "AudioCommit(%zu) failed", size);
+      consumer_index += size;
+      left -= size;
+    }
+  }
+}
+
+// What the consumer got for every sample of the audio stream.
+enum SampleState : uint8_t { NOT_SEEN, CAPTURED, GAP };
+static std::vector<SampleState> sample_states;
+
+static void SetSampleStates(size_t num_samples, SampleState state) {
+  if (sample_states.size() < consumer_index + num_samples) {
+    sample_states.resize(consumer_index + num_samples, NOT_SEEN);
+  }
+  for (size_t i = 0; i < num_samples; i++) {
+    sample_states[consumer_index + i] = state;
+  }
+}
+
+// Consumes all samples in the audio queue, committing at most `commit_size`
+// samples at once. Gaps are either filled with their silence or skipped.
+static void ConsumeAll(size_t commit_size, bool skip_gaps) {
+  while (true) {
+    Settle();
+    audio_span_t spans[2];
+    audio_position_t position;
+    AudioPeek(0, spans, &position);
+    size_t num_samples = NumSamples(spans);
+    if (num_samples == 0) {
+      return;
+    }
+    CHECK(position.sample_index == consumer_index,
+          "position %" PRIu64 ", expected %" PRIu64, position.sample_index,
+          consumer_index);
+
+    if (position.gap_samples > 0) {
+      CHECK(spans[0].num_samples ==
+                    std::min((size_t)position.gap_samples, block_samples) &&
+                spans[1].num_samples == 0,
+            "%zu samples of silence for a gap of %" PRIu32, num_samples,
+            position.gap_samples);
+      for (size_t i = 0; i < spans[0].num_samples; i++) {
+        CHECK(spans[0].samples[i] == 0, "silence of the gap is %d",
+              spans[0].samples[i]);
+      }
+      if (skip_gaps) {
+        SkipAudioGap();
+        SetSampleStates(position.gap_samples, GAP);
+        consumer_index += position.gap_samples;
+        continue;
+      }
+      SetSampleStates(num_samples, GAP);
+    } else {
+      CheckSamples(spans);
+      SetSampleStates(num_samples, CAPTURED);
+    }
+
+    while (num_samples > 0) {
+      const size_t size = std::min(num_samples, commit_size);
+      CHECK(AudioCommit(size) == ESP_OK, "AudioCommit(%zu) failed", size);
+      consumer_index += size;
+      num_samples -= size;
+    }
+  }
+}
+
+// Lets the audio queue overrun by `num_extra_blocks` and checks which blocks
+// the consumer gets afterwards. The queue has to be empty.
+static void CheckOverrun(size_t num_extra_blocks, size_t commit_size,
+                         bool skip_gaps) {
+  const audio_stats_t stats = GetAudioStats();
+  const uint64_t start_index = consumer_index;
+  const size_t num_blocks = queue_blocks + num_extra_blocks + 2;
+
+  // The queue runs full while the consumer is away, then two more blocks
+  // arrive after it is back.
+  GrantBlocks(queue_blocks + num_extra_blocks);
+  ConsumeAll(commit_size, skip_gaps);
+  GrantBlocks(2);
+  ConsumeAll(commit_size, skip_gaps);
+
+  // Which blocks have to arrive depends on the policy. The capture task has
+  // already acquired the overflow block for the first block after the
+  // consumer is back, so that one is treated like the extra blocks.
+  //   DROP_NEWEST: the full queue, then the second block after the consumer
+  //                is back.
+  //   DROP_OLDEST: the oldest block is dropped to make room for the newest
+  //                one, which replaced all extra blocks in the overflow block.
+  //   BLOCK:       all of them, the source has to wait.
+  std::vector<SampleState> expected(num_blocks, CAPTURED);
+  size_t num_gaps = 0;
+#if CONFIG_MICRO_KWS_AUDIO_OVERRUN_DROP_NEWEST
+  for (size_t block = queue_blocks; block < num_blocks - 1; block++) {
+    expected[block] = GAP;
+  }
+  num_gaps = 1;
+#elif CONFIG_MICRO_KWS_AUDIO_OVERRUN_DROP_OLDEST
+  expected[0] = GAP;
+  for (size_t block = queue_blocks; block < num_blocks - 2; block++) {
+    expected[block] = GAP;
+  }
+  num_gaps = 2;
+#endif  // CONFIG_MICRO_KWS_AUDIO_OVERRUN_DROP_OLDEST
+
+  CHECK(consumer_index == start_index + num_blocks * block_samples,
+        "consumed %" PRIu64 " samples of %zu blocks",
+        consumer_index - start_index, num_blocks);
+  size_t num_gap_samples = 0;
+  for (size_t block = 0; block < num_blocks; block++) {
+    const uint64_t index = start_index + block * block_samples;
+    for (size_t i = 0; i < block_samples; i++) {
+      const SampleState state =
+          index + i < sample_states.size() ? sample_states[index + i]
+                                           : NOT_SEEN;
+      CHECK(state == expected[block],
+            "sample %" PRIu64 " of block %zu is in state %d, expected %d",
+            index + i, block, state, expected[block]);
+      num_gap_samples += state == GAP;
+    }
+  }
+
+  const audio_stats_t new_stats = GetAudioStats();
+  CHECK(new_stats.overruns > stats.overruns, "no overrun counted");
+  CHECK(new_stats.gaps - stats.gaps == num_gaps,
+        "%" PRIu32 " gaps, expected %zu", new_stats.gaps - stats.gaps,
+        num_gaps);
+  CHECK(new_stats.gap_samples - stats.gap_samples == num_gap_samples,
+        "%" PRIu32 " gap samples, expected %zu",
+        new_stats.gap_samples - stats.gap_samples, num_gap_samples);
+}
+
+int main() {
+  // The main thread takes part in the virtual clock just like a task.
+  HostClockAddTask();
+  // The overruns of CheckOverrun() are deliberate, so their warnings are not
+  // printed.
+  esp_log_level_set("*", ESP_LOG_ERROR);
+
+  if (SetAudioSource(&test_source) != ESP_OK ||
+      InitializeAudio() != ESP_OK) {
+    printf("Could not initialize the audio input.\n");
+    return EXIT_FAILURE;
+  }
+  Settle();
+
+  CheckEveryOffset();
+  CheckRandomCommits();
+  ConsumeAll(SIZE_MAX, false);
+  CheckOverrun(3, 100, false);
+  CheckOverrun(5, 3 * block_samples + 1, true);
+
+  // Committing more than is left of the last AudioPeek() fails. The error it
+  // logs is expected, so it is not printed.
+  GrantBlocks(1);
+  Settle();
+  audio_span_t spans[2];
+  AudioPeek(0, spans);
+  CHECK(AudioCommit(1) == ESP_OK, "AudioCommit(1) failed");
+  consumer_index++;
+  esp_log_level_set("*", ESP_LOG_NONE);
+  const esp_err_t over_commit = AudioCommit(NumSamples(spans));
+  esp_log_level_set("*", ESP_LOG_ERROR);
+  CHECK(over_commit == ESP_ERR_INVALID_ARG,
+        "committed more samples than peeked");
+
+  printf("%" PRIu64 " samples: %s\n", consumer_index,
+         num_errors == 0 ? "ok" : "MISMATCH");
+  fflush(stdout);
+  // The capture task never ends, so do not wait for it.
+  std::_Exit(num_errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmark of the cost of a second microphone, see README.md. Measures the
+// time per sample and channel of the steps that depend on the number of
+// channels: splitting the interleaved frames, the beamformer, which combines
+// them instead, and the frontend, which runs once per channel without the
+// beamformer. Also prints the gain of the beamformer for noise from different
+// directions.
+
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC 1
+#endif
+
+#include "audio_convert.h"
+#include "beamformer.h"
+#include "frontend.h"
+#include "model_settings.h"
+
+// Size of the audio blocks, see audio.cc.
+constexpr size_t block_samples = 256;
+
+// Ten seconds, so that the frontend runs for a while.
+constexpr size_t num_samples = 10 * audio_sample_frequency;
+
+// Whole samples of delay between the channels the gain is measured for.
+constexpr int32_t max_source_delay = 4;
+
+// White noise at about a quarter of full scale.
+static std::vector<int16_t> GenerateNoise(size_t size, uint32_t seed) {
+  std::mt19937 generator(seed);
+  std::uniform_int_distribution<int32_t> distribution(-8192, 8192);
+  std::vector<int16_t> noise(size);
+  for (int16_t& sample : noise) {
+    sample = distribution(generator);
+  }
+  return noise;
+}
+
+// Interleaved frames of noise that reaches the second channel `source_delay`
+// samples later than the first one. Without a delay, the channels get
+// uncorrelated noise instead, like the self-noise of the microphones.
+static std::vector<int16_t> GenerateFrames(const int32_t* source_delay) {
+  const std::vector<int16_t> noise =
+      GenerateNoise(num_samples + 2 * max_source_delay, 1);
+  const std::vector<int16_t> other = GenerateNoise(num_samples, 2);
+  std::vector<int16_t> frames(2 * num_samples);
+  for (size_t i = 0; i < num_samples; i++) {
+    frames[2 * i] = noise[i + max_source_delay];
+    frames[2 * i + 1] = source_delay != NULL
+                            ? noise[i + max_source_delay - *source_delay]
+                            : other[i];
+  }
+  return frames;
+}
+
+// Runs `process` on all blocks of the input and returns the time per sample of
+// each of the `num_channels` channels in ns and cycles.
+static void Measure(size_t num_channels,
+                    const std::function<void(size_t pos)>& process, double* ns,
+                    double* cycles) {
+  const auto start = std::chrono::steady_clock::now();
+#ifdef HAVE_RDTSC
+  const uint64_t start_cycles = __rdtsc();
+#endif
+  for (size_t pos = 0; pos < num_samples; pos += block_samples) {
+    process(pos);
+  }
+#ifdef HAVE_RDTSC
+  *cycles = (double)(__rdtsc() - start_cycles) / (num_samples * num_channels);
+#else
+  *cycles = NAN;
+#endif
+  *ns = std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - start)
+            .count() /
+        (num_samples * num_channels);
+}
+
+static double Power(const int16_t* samples, size_t stride) {
+  double sum = 0.0;
+  for (size_t i = 0; i < num_samples; i++) {
+    sum += (double)samples[i * stride] * samples[i * stride];
+  }
+  return sum / num_samples;
+}
+
+// Output power of the beamformer relative to the power of the first channel,
+// in dB.
+static double BeamformerGain(int32_t delay, const int32_t* source_delay) {
+  const std::vector<int16_t> frames = GenerateFrames(source_delay);
+  std::vector<int16_t> output(num_samples);
+  beamformer_t beamformer;
+  InitializeBeamformer(&beamformer, delay);
+  for (size_t pos = 0; pos < num_samples; pos += block_samples) {
+    Beamform(&beamformer, &frames[2 * pos], block_samples, &output[pos]);
+  }
+  return 10 * log10(Power(output.data(), 1) / Power(frames.data(), 2));
+}
+
+int main(int argc, char* argv[]) {
+  if (argc != 1) {
+    fprintf(stderr,
+            "Usage: %s\n"
+            "\n"
+            "Benchmarks the steps whose cost depends on the number of\n"
+            "microphones, per sample and channel at %" PRId32
+            " Hz, and prints\n"
+            "the gain of the beamformer for noise which reaches the second\n"
+            "microphone up to %" PRId32
+            " samples earlier or later than the first\n"
+            "one, and for uncorrelated noise.\n",
+            argv[0], audio_sample_frequency, max_source_delay);
+    return EXIT_FAILURE;
+  }
+
+  const int32_t no_delay = 0;
+  const std::vector<int16_t> frames = GenerateFrames(&no_delay);
+  std::vector<int16_t> left(num_samples);
+  std::vector<int16_t> right(num_samples);
+  double ns = 0.0;
+  double cycles = 0.0;
+
+  printf("Step                    ns/sample  cycles/sample\n");
+  Measure(
+      2,
+      [&](size_t pos) {
+        int16_t* channels[] = {&left[pos], &right[pos]};
+        DeinterleaveAudioSamples(&frames[2 * pos], 2, block_samples, channels);
+      },
+      &ns, &cycles);
+  printf("%-22s %10.2f %14.2f\n", "split channels", ns, cycles);
+
+  for (int32_t delay : {0, 8, 24, -max_beamformer_delay}) {
+    beamformer_t beamformer;
+    InitializeBeamformer(&beamformer, delay);
+    Measure(
+        2,
+        [&](size_t pos) {
+          Beamform(&beamformer, &frames[2 * pos], block_samples, &left[pos]);
+        },
+        &ns, &cycles);
+    char name[32];
+    snprintf(name, sizeof(name), "beamformer (%+.4g)",
+             (double)delay / (1 << beamformer_delay_fraction_bits));
+    printf("%-22s %10.2f %14.2f\n", name, ns, cycles);
+  }
+
+  if (InitializeFrontend() != ESP_OK) {
+    return EXIT_FAILURE;
+  }
+  int8_t slice[feature_slice_size];
+  Measure(
+      1,
+      [&](size_t pos) {
+        size_t offset = 0;
+        while (offset < block_samples) {
+          size_t num_read = 0;
+          bool ready = false;
+          GenerateFrontendData(0, &frames[2 * pos] + offset,
+                               block_samples - offset, &num_read, slice,
+                               &ready);
+          offset += num_read;
+        }
+      },
+      &ns, &cycles);
+  printf("%-22s %10.2f %14.2f\n", "frontend", ns, cycles);
+
+  printf("\nGain in dB of the beamformer by steering delay (rows, in samples)\n"
+         "and delay of the noise at the second microphone (columns)\n");
+  printf("       ");
+  for (int32_t source_delay = -max_source_delay;
+       source_delay <= max_source_delay; source_delay++) {
+    printf(" %+6" PRId32, source_delay);
+  }
+  printf("  uncorrelated\n");
+  for (int32_t delay : {0, 16, 24, 32, -32}) {
+    printf("%+6.4g ", (double)delay / (1 << beamformer_delay_fraction_bits));
+    for (int32_t source_delay = -max_source_delay;
+         source_delay <= max_source_delay; source_delay++) {
+      printf(" %6.2f", BeamformerGain(delay, &source_delay));
+    }
+    printf(" %13.2f\n", BeamformerGain(delay, NULL));
+  }
+  return EXIT_SUCCESS;
+}
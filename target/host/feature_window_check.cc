@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Check of the feature window, see README.md. Feeds the same random slices
+// into the mirrored ringbuffer of feature_window.cc and into the shifted
+// window the main loop used before, i.e. one memmove and one memcpy per slice,
+// and compares both windows of every channel after every slice. The slices
+// wrap around the ringbuffer several times. Built once per channel count.
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+#include "feature_window.h"
+#include "model_settings.h"
+
+constexpr size_t num_wraps = 5;
+
+int main() {
+  if (InitializeFeatureWindow() != ESP_OK) {
+    printf("InitializeFeatureWindow() failed\n");
+    return EXIT_FAILURE;
+  }
+
+  // Just like the ringbuffer, the old window started with zero slices.
+  static int8_t reference[audio_channels][feature_element_count] = {0};
+
+  std::mt19937 generator(1);
+  std::uniform_int_distribution<int> value(INT8_MIN, INT8_MAX);
+
+  // A few slices more than whole wraps, so the last window does not start at
+  // the first slot.
+  const size_t num_slices = num_wraps * feature_slize_count + 7;
+  size_t num_mismatches = 0;
+  for (size_t slice = 0; slice < num_slices; slice++) {
+    for (size_t channel = 0; channel < audio_channels; channel++) {
+      int8_t new_slice[feature_slice_size];
+      for (int32_t i = 0; i < feature_slice_size; i++) {
+        new_slice[i] = value(generator);
+      }
+      memcpy(GetFeatureSliceBuffer(channel), new_slice, feature_slice_size);
+
+      memmove(reference[channel], reference[channel] + feature_slice_size,
+              feature_element_count - feature_slice_size);
+      memcpy(reference[channel] + feature_element_count - feature_slice_size,
+             new_slice, feature_slice_size);
+    }
+    if (CommitFeatureSlice() != ESP_OK) {
+      printf("CommitFeatureSlice() failed\n");
+      return EXIT_FAILURE;
+    }
+
+    if (GetFeatureWindowPosition() != slice + 1) {
+      printf("slice %zu: position %" PRIu32 ", expected %zu\n", slice,
+             GetFeatureWindowPosition(), slice + 1);
+      num_mismatches++;
+    }
+    for (size_t channel = 0; channel < audio_channels; channel++) {
+      const int8_t* window = GetFeatureWindow(channel);
+      for (int32_t i = 0; i < feature_element_count; i++) {
+        if (window[i] != reference[channel][i]) {
+          printf("slice %zu, channel %zu: window[%" PRId32
+                 "] is %d, expected %d\n",
+                 slice, channel, i, window[i], reference[channel][i]);
+          num_mismatches++;
+          break;
+        }
+      }
+    }
+  }
+
+  printf("%zu slices, %zu channels, %zu windows: %s\n", num_slices,
+         audio_channels, num_slices * audio_channels,
+         num_mismatches == 0 ? "ok" : "MISMATCH");
+  return num_mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmark of the FFT of the microfrontend, see README.md. Compares
+// FftCompute() with kissfft_fixed16::kiss_fftr(), which it replaced, for every
+// supported size and many inputs. Prints the time per FFT of both, and their
+// signal-to-noise ratio against a double precision DFT.
+
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC 1
+#endif
+
+#include "microfrontend/lib/bits.h"
+#include "microfrontend/lib/fft.h"
+#include "microfrontend/lib/fft_util.h"
+#include "microfrontend/lib/kiss_fft_int16.h"
+
+// Random inputs per FFT size and input size.
+constexpr size_t num_inputs = 1000;
+constexpr size_t num_timed_runs = 100000;
+
+// FftCompute() before it replaced kissfft.
+class ReferenceFft {
+ public:
+  explicit ReferenceFft(size_t input_size) : input_size_(input_size) {
+    fft_size_ = 1;
+    while (fft_size_ < input_size_) {
+      fft_size_ <<= 1;
+    }
+    input_.resize(fft_size_);
+    output_.resize(fft_size_ / 2 + 1);
+    size_t scratch_size = 0;
+    kissfft_fixed16::kiss_fftr_alloc(fft_size_, 0, nullptr, &scratch_size);
+    scratch_.resize(scratch_size);
+    kissfft_fixed16::kiss_fftr_alloc(fft_size_, 0, scratch_.data(),
+                                     &scratch_size);
+  }
+
+  const complex_int16_t* Compute(const int16_t* input, int input_scale_shift) {
+    size_t i;
+    for (i = 0; i < input_size_; ++i) {
+      input_[i] = static_cast<int16_t>(static_cast<uint16_t>(input[i])
+                                       << input_scale_shift);
+    }
+    for (; i < fft_size_; ++i) {
+      input_[i] = 0;
+    }
+    kissfft_fixed16::kiss_fftr(
+        reinterpret_cast<kissfft_fixed16::kiss_fftr_cfg>(scratch_.data()),
+        input_.data(),
+        reinterpret_cast<kissfft_fixed16::kiss_fft_cpx*>(output_.data()));
+    return output_.data();
+  }
+
+ private:
+  size_t input_size_;
+  size_t fft_size_;
+  std::vector<int16_t> input_;
+  std::vector<complex_int16_t> output_;
+  std::vector<char> scratch_;
+};
+
+// Noise under a Hann window, like the output of the window of the frontend,
+// with a random peak amplitude, and the shift the frontend would apply to it.
+// Every tenth input is full scale noise without the window, with every
+// hundredth sample at the negative limit.
+static std::vector<int16_t> GenerateInput(std::mt19937* generator,
+                                          size_t input_index, size_t size,
+                                          int* shift) {
+  std::vector<int16_t> input(size);
+  if (input_index % 10 == 0) {
+    std::uniform_int_distribution<int32_t> distribution(-32768, 32767);
+    for (size_t i = 0; i < size; i++) {
+      input[i] = i % 100 == 0 ? -32768 : distribution(*generator);
+    }
+    *shift = 0;
+    return input;
+  }
+
+  std::uniform_real_distribution<double> amplitude_distribution(0.0, 15.0);
+  const double amplitude = pow(2.0, amplitude_distribution(*generator));
+  std::normal_distribution<double> distribution(0.0, amplitude / 3);
+  int16_t max_abs = 0;
+  for (size_t i = 0; i < size; i++) {
+    const double window = 0.5 - 0.5 * cos(2 * M_PI * (i + 0.5) / size);
+    const double value =
+        std::max(-32767.0, std::min(32767.0, distribution(*generator)));
+    input[i] = (int16_t)lround(value * window);
+    max_abs = std::max<int16_t>(max_abs, abs(input[i]));
+  }
+  *shift = 15 - MostSignificantBit32(max_abs);
+  return input;
+}
+
+// Signal-to-noise ratio of `output` against the DFT of the shifted input,
+// divided by the FFT size like the fixed point FFTs.
+static double SignalToNoise(const std::vector<int16_t>& input, int shift,
+                            size_t fft_size, const complex_int16_t* output) {
+  double signal = 0.0;
+  double noise = 0.0;
+  for (size_t k = 0; k <= fft_size / 2; k++) {
+    std::complex<double> sum = 0.0;
+    for (size_t n = 0; n < input.size(); n++) {
+      const int16_t value = (int16_t)((uint16_t)input[n] << shift);
+      sum += std::polar((double)value, -2 * M_PI * k * n / fft_size);
+    }
+    sum /= fft_size;
+    const std::complex<double> error =
+        std::complex<double>(output[k].real, output[k].imag) - sum;
+    signal += std::norm(sum);
+    noise += std::norm(error);
+  }
+  return 10 * log10(signal / noise);
+}
+
+// Returns the time per call of `compute` in ns and cycles.
+template <typename Function>
+static void Time(Function compute, double* ns, double* cycles) {
+  const auto start = std::chrono::steady_clock::now();
+#ifdef HAVE_RDTSC
+  const uint64_t start_cycles = __rdtsc();
+#endif
+  for (size_t run = 0; run < num_timed_runs; run++) {
+    compute();
+  }
+#ifdef HAVE_RDTSC
+  *cycles = (double)(__rdtsc() - start_cycles) / num_timed_runs;
+#else
+  *cycles = NAN;
+#endif
+  *ns = std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - start)
+            .count() /
+        num_timed_runs;
+}
+
+int main() {
+  std::mt19937 generator(1);
+  bool all_exact = true;
+  printf(" size input        kissfft/fft            fft/fft   kissfft SNR"
+         "       SNR  exact\n");
+  for (size_t fft_size = 4; fft_size <= FftMaxSize(); fft_size *= 2) {
+    // The window of the frontend (480 of 512 samples at 16 kHz, 240 of 256 at
+    // 8 kHz), a full and an odd number of samples.
+    std::vector<size_t> input_sizes = {fft_size, fft_size - 1};
+    if (fft_size * 15 / 16 != fft_size - 1) {
+      input_sizes.insert(input_sizes.begin(), fft_size * 15 / 16);
+    }
+    for (const size_t input_size : input_sizes) {
+      struct FftState state;
+      if (!FftPopulateState(&state, input_size) ||
+          state.fft_size != fft_size) {
+        return EXIT_FAILURE;
+      }
+      ReferenceFft reference(input_size);
+
+      bool exact = true;
+      double reference_snr = 0.0;
+      double snr = 0.0;
+      size_t num_snr_inputs = 0;
+      for (size_t i = 0; i < num_inputs; i++) {
+        int shift = 0;
+        const std::vector<int16_t> input =
+            GenerateInput(&generator, i, input_size, &shift);
+        const complex_int16_t* reference_output =
+            reference.Compute(input.data(), shift);
+        FftCompute(&state, input.data(), shift);
+        exact = exact && memcmp(reference_output, state.output,
+                                (fft_size / 2 + 1) *
+                                    sizeof(*state.output)) == 0;
+        // The windowed inputs, on which the frontend works, unless they are
+        // all zero.
+        if (i % 10 != 0 && i < 100 && shift < 15) {
+          reference_snr +=
+              SignalToNoise(input, shift, fft_size, reference_output);
+          snr += SignalToNoise(input, shift, fft_size, state.output);
+          num_snr_inputs++;
+        }
+      }
+      all_exact = all_exact && exact;
+
+      int shift = 0;
+      const std::vector<int16_t> input =
+          GenerateInput(&generator, 1, input_size, &shift);
+      double reference_ns = 0.0;
+      double reference_cycles = 0.0;
+      double ns = 0.0;
+      double cycles = 0.0;
+      Time([&] { reference.Compute(input.data(), shift); }, &reference_ns,
+           &reference_cycles);
+      Time([&] { FftCompute(&state, input.data(), shift); }, &ns, &cycles);
+      printf("%5zu %5zu %7.0f ns %7.0f cyc %7.0f ns %7.0f cyc %10.1f dB "
+             "%6.1f dB  %s\n",
+             fft_size, input_size, reference_ns, reference_cycles, ns, cycles,
+             reference_snr / num_snr_inputs, snr / num_snr_inputs,
+             exact ? "yes" : "NO");
+      FftFreeStateContents(&state);
+    }
+  }
+  return all_exact ? EXIT_SUCCESS : EXIT_FAILURE;
+}
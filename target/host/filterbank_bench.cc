@@ -0,0 +1,444 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmark of the filterbank of the microfrontend, see README.md. Compares
+// FilterbankAccumulateEnergy(), which computes the energy of the FFT output and
+// accumulates the channels in a single pass, with the two passes it replaced,
+// for both rates of the frontend and many FFT outputs. Checks that the results
+// are the same with 32 and 64 bit accumulators and prints the time of each.
+// Also compares FilterbankSqrt() with the bit by bit square roots it replaced,
+// for every 32 bit number and many random 64 bit numbers, and prints the time
+// of both.
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC 1
+#endif
+
+#include "frontend_tables.h"
+#include "microfrontend/lib/bits.h"
+#include "microfrontend/lib/filterbank.h"
+#include "microfrontend/lib/filterbank_util.h"
+#include "model_settings.h"
+
+// Random FFT outputs per sample rate.
+constexpr size_t num_inputs = 10000;
+// Random 64 bit inputs of the square root.
+constexpr size_t num_sqrt_inputs = 100000000;
+constexpr size_t num_timed_runs = 100000;
+
+// FilterbankConvertFftComplexToEnergy() and FilterbankAccumulateChannels()
+// before they were fused. Like the frontend, the energy reuses the buffer of
+// the FFT output, which is why `fft_output` is copied first.
+class ReferenceFilterbank {
+ public:
+  explicit ReferenceFilterbank(size_t spectrum_size) : energy_(spectrum_size) {}
+
+  void Accumulate(struct FilterbankState* state,
+                  const struct complex_int16_t* fft_output) {
+    memcpy(energy_.data(), fft_output, energy_.size() * sizeof(*fft_output));
+    ConvertFftComplexToEnergy(
+        state, reinterpret_cast<struct complex_int16_t*>(energy_.data()),
+        energy_.data());
+    AccumulateChannels(state, energy_.data());
+  }
+
+ private:
+  static void ConvertFftComplexToEnergy(struct FilterbankState* state,
+                                        struct complex_int16_t* fft_output,
+                                        int32_t* energy) {
+    const int end_index = state->end_index;
+    energy += state->start_index;
+    fft_output += state->start_index;
+    for (int i = state->start_index; i < end_index; ++i) {
+      const int32_t real = fft_output->real;
+      const int32_t imag = fft_output->imag;
+      fft_output++;
+      // Computed without overflow, but stored like the original.
+      const uint32_t mag_squared =
+          (uint32_t)(real * real) + (uint32_t)(imag * imag);
+      *energy++ = mag_squared;
+    }
+  }
+
+  static void AccumulateChannels(struct FilterbankState* state,
+                                 const int32_t* energy) {
+    uint64_t* work = state->work;
+    uint64_t weight_accumulator = 0;
+    uint64_t unweight_accumulator = 0;
+
+    const int16_t* channel_frequency_starts = state->channel_frequency_starts;
+    const int16_t* channel_weight_starts = state->channel_weight_starts;
+    const int16_t* channel_widths = state->channel_widths;
+
+    int num_channels_plus_1 = state->num_channels + 1;
+    for (int i = 0; i < num_channels_plus_1; ++i) {
+      const int32_t* magnitudes = energy + *channel_frequency_starts++;
+      const int16_t* weights = state->weights + *channel_weight_starts;
+      const int16_t* unweights = state->unweights + *channel_weight_starts++;
+      const int width = *channel_widths++;
+      for (int j = 0; j < width; ++j) {
+        weight_accumulator += *weights++ * ((uint64_t)*magnitudes);
+        unweight_accumulator += *unweights++ * ((uint64_t)*magnitudes);
+        ++magnitudes;
+      }
+      *work++ = weight_accumulator;
+      weight_accumulator = unweight_accumulator;
+      unweight_accumulator = 0;
+    }
+  }
+
+  std::vector<int32_t> energy_;
+};
+
+// FilterbankSqrt() before the table-driven square roots.
+class ReferenceSqrt {
+ public:
+  static uint32_t* Compute(struct FilterbankState* state,
+                           int scale_down_shift) {
+    const int num_channels = state->num_channels;
+    const uint64_t* work = state->work + 1;
+    uint32_t* output = (uint32_t*)state->work;
+    for (int i = 0; i < num_channels; ++i) {
+      *output++ = Sqrt64(*work++) >> scale_down_shift;
+    }
+    return (uint32_t*)state->work;
+  }
+
+ private:
+  static uint16_t Sqrt32(uint32_t num) {
+    if (num == 0) {
+      return 0;
+    }
+    uint32_t res = 0;
+    int max_bit_number = 32 - MostSignificantBit32(num);
+    max_bit_number |= 1;
+    uint32_t bit = 1U << (31 - max_bit_number);
+    int iterations = (31 - max_bit_number) / 2 + 1;
+    while (iterations--) {
+      if (num >= res + bit) {
+        num -= res + bit;
+        res = (res >> 1U) + bit;
+      } else {
+        res >>= 1U;
+      }
+      bit >>= 2U;
+    }
+    if (num > res && res != 0xFFFF) {
+      ++res;
+    }
+    return res;
+  }
+
+  static uint32_t Sqrt64(uint64_t num) {
+    if ((num >> 32) == 0) {
+      return Sqrt32((uint32_t)num);
+    }
+    uint64_t res = 0;
+    int max_bit_number = 64 - MostSignificantBit64(num);
+    max_bit_number |= 1;
+    uint64_t bit = 1ULL << (63 - max_bit_number);
+    int iterations = (63 - max_bit_number) / 2 + 1;
+    while (iterations--) {
+      if (num >= res + bit) {
+        num -= res + bit;
+        res = (res >> 1U) + bit;
+      } else {
+        res >>= 1U;
+      }
+      bit >>= 2U;
+    }
+    if (num > res && res != 0xFFFFFFFFLL) {
+      ++res;
+    }
+    return res;
+  }
+};
+
+// Whether FilterbankSqrt() and ReferenceSqrt::Compute() give the same roots of
+// `values`, which has num_channels entries.
+static bool CheckSqrt(struct FilterbankState* state, const uint64_t* values) {
+  const size_t num_channels = state->num_channels;
+  memcpy(state->work + 1, values, num_channels * sizeof(*values));
+  std::vector<uint32_t> output(num_channels);
+  memcpy(output.data(), FilterbankSqrt(state, 0),
+         num_channels * sizeof(output[0]));
+  memcpy(state->work + 1, values, num_channels * sizeof(*values));
+  return memcmp(output.data(), ReferenceSqrt::Compute(state, 0),
+                num_channels * sizeof(output[0])) == 0;
+}
+
+// Checks the roots of every 32 bit number and of random 64 bit numbers with a
+// random number of bits, as well as of squares and the numbers around them
+// where the rounding changes.
+static bool CheckAllSqrt(std::mt19937* generator,
+                         struct FilterbankState* state) {
+  const size_t num_channels = state->num_channels;
+  std::vector<uint64_t> values(num_channels);
+  bool exact = true;
+  for (uint64_t start = 0; start <= UINT32_MAX; start += num_channels) {
+    for (size_t i = 0; i < num_channels; i++) {
+      values[i] = std::min<uint64_t>(start + i, UINT32_MAX);
+    }
+    exact = CheckSqrt(state, values.data()) && exact;
+  }
+
+  std::mt19937_64 generator_64((*generator)());
+  std::uniform_int_distribution<int> bits_distribution(33, 64);
+  for (size_t start = 0; start < num_sqrt_inputs; start += num_channels) {
+    for (size_t i = 0; i < num_channels; i++) {
+      const int bits = bits_distribution(*generator);
+      const uint64_t value = generator_64() >> (64 - bits);
+      if (i % 4 == 0) {
+        values[i] = value;
+      } else {
+        // A root, the number around its square given by i and a random
+        // offset in [-2, 2].
+        const uint64_t root = value >> (bits / 2 + 1);
+        const uint64_t offset = (i % 4 == 1 ? 0 : root) + (i % 5) - 2;
+        values[i] = root * root + offset;
+      }
+    }
+    exact = CheckSqrt(state, values.data()) && exact;
+  }
+
+  const uint64_t extremes[] = {UINT64_MAX,
+                               UINT64_MAX - 1,
+                               0xFFFFFFFE00000001ULL,
+                               0xFFFFFFFE00000000ULL,
+                               0xFFFFFFFF00000000ULL,
+                               0xFFFFFFFF7FFFFFFFULL,
+                               0xFFFFFFFF80000000ULL,
+                               1ULL << 32,
+                               (1ULL << 32) + 1,
+                               (1ULL << 62) - 1,
+                               1ULL << 62};
+  for (size_t i = 0; i < num_channels; i++) {
+    values[i] = extremes[i % (sizeof(extremes) / sizeof(extremes[0]))];
+  }
+  return CheckSqrt(state, values.data()) && exact;
+}
+
+// A random FFT output like that of the frontend, whose input is scaled to full
+// scale, with a random peak amplitude. Every tenth output is uniform full scale
+// noise. The first two are all (32767, 32767) and all (-32768, -32768), the
+// largest energies there are.
+static std::vector<struct complex_int16_t> GenerateFftOutput(
+    std::mt19937* generator, size_t input_index, size_t size) {
+  std::vector<struct complex_int16_t> output(size);
+  if (input_index < 2) {
+    const int16_t value = input_index == 0 ? 32767 : -32768;
+    for (size_t i = 0; i < size; i++) {
+      output[i] = {value, value};
+    }
+  } else if (input_index % 10 == 0) {
+    std::uniform_int_distribution<int32_t> distribution(-32768, 32767);
+    for (size_t i = 0; i < size; i++) {
+      output[i] = {(int16_t)distribution(*generator),
+                   (int16_t)distribution(*generator)};
+    }
+  } else {
+    std::uniform_real_distribution<double> amplitude_distribution(0.0, 14.0);
+    const double amplitude = pow(2.0, amplitude_distribution(*generator));
+    std::normal_distribution<double> distribution(0.0, amplitude / 3);
+    for (size_t i = 0; i < size; i++) {
+      output[i] = {
+          (int16_t)std::max(-32768.0,
+                            std::min(32767.0, distribution(*generator))),
+          (int16_t)std::max(-32768.0,
+                            std::min(32767.0, distribution(*generator)))};
+    }
+  }
+  return output;
+}
+
+// Returns the time per call of `compute` in ns and cycles.
+template <typename Function>
+static void Time(Function compute, double* ns, double* cycles) {
+  const auto start = std::chrono::steady_clock::now();
+#ifdef HAVE_RDTSC
+  const uint64_t start_cycles = __rdtsc();
+#endif
+  for (size_t run = 0; run < num_timed_runs; run++) {
+    compute();
+  }
+#ifdef HAVE_RDTSC
+  *cycles = (double)(__rdtsc() - start_cycles) / num_timed_runs;
+#else
+  *cycles = NAN;
+#endif
+  *ns = std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - start)
+            .count() /
+        num_timed_runs;
+}
+
+// Populates `state` with the filterbank of the frontend at `sample_frequency`
+// and returns the size of the spectrum, or 0 on failure.
+static size_t PopulateState(int32_t sample_frequency,
+                            struct FilterbankState* state) {
+  const frontend_tables_t* tables = GetFrontendTables(sample_frequency);
+  size_t fft_size = 4;
+  while (fft_size < tables->window_size) {
+    fft_size <<= 1;
+  }
+  const size_t spectrum_size = fft_size / 2 + 1;
+
+  struct FilterbankConfig config;
+  FilterbankFillConfigWithDefaults(&config);
+  config.num_channels = feature_slice_size;
+  config.tables = &tables->filterbank;
+  if (!FilterbankPopulateState(&config, state, spectrum_size)) {
+    return 0;
+  }
+  return spectrum_size;
+}
+
+// Compares FilterbankAccumulateEnergy() with ReferenceFilterbank and prints
+// their times. Returns whether the results are the same.
+static bool BenchmarkAccumulate(std::mt19937* generator,
+                                int32_t sample_frequency) {
+  struct FilterbankState state;
+  const size_t spectrum_size = PopulateState(sample_frequency, &state);
+  if (spectrum_size == 0) {
+    return false;
+  }
+  const int accumulate_32_bit = state.accumulate_32_bit;
+  const size_t work_size = (state.num_channels + 1) * sizeof(*state.work);
+  ReferenceFilterbank reference(spectrum_size);
+  std::vector<uint64_t> reference_work(state.num_channels + 1);
+
+  bool exact = true;
+  for (size_t i = 0; i < num_inputs; i++) {
+    const std::vector<struct complex_int16_t> fft_output =
+        GenerateFftOutput(generator, i, spectrum_size);
+    reference.Accumulate(&state, fft_output.data());
+    memcpy(reference_work.data(), state.work, work_size);
+    for (const int use_32_bit : {0, accumulate_32_bit}) {
+      state.accumulate_32_bit = use_32_bit;
+      FilterbankAccumulateEnergy(&state, fft_output.data());
+      exact =
+          exact && memcmp(reference_work.data(), state.work, work_size) == 0;
+    }
+  }
+
+  const std::vector<struct complex_int16_t> fft_output =
+      GenerateFftOutput(generator, 2, spectrum_size);
+  double reference_ns = 0.0;
+  double reference_cycles = 0.0;
+  double ns_64 = 0.0;
+  double cycles_64 = 0.0;
+  double ns_32 = NAN;
+  double cycles_32 = NAN;
+  Time([&] { reference.Accumulate(&state, fft_output.data()); },
+       &reference_ns, &reference_cycles);
+  state.accumulate_32_bit = 0;
+  Time([&] { FilterbankAccumulateEnergy(&state, fft_output.data()); }, &ns_64,
+       &cycles_64);
+  if (accumulate_32_bit) {
+    state.accumulate_32_bit = 1;
+    Time([&] { FilterbankAccumulateEnergy(&state, fft_output.data()); },
+         &ns_32, &cycles_32);
+  }
+  printf("%5" PRId32 " Hz %5.0f ns %5.0f cyc %5.0f ns %5.0f cyc %5.0f ns "
+         "%5.0f cyc  %s\n",
+         sample_frequency, reference_ns, reference_cycles, ns_64, cycles_64,
+         ns_32, cycles_32, exact ? "yes" : "NO");
+  FilterbankFreeStateContents(&state);
+  return exact;
+}
+
+// Prints the time of FilterbankSqrt() and ReferenceSqrt::Compute() for the
+// channels of a typical FFT output.
+static bool BenchmarkSqrt(std::mt19937* generator, int32_t sample_frequency) {
+  struct FilterbankState state;
+  const size_t spectrum_size = PopulateState(sample_frequency, &state);
+  if (spectrum_size == 0) {
+    return false;
+  }
+  const std::vector<struct complex_int16_t> fft_output =
+      GenerateFftOutput(generator, 2, spectrum_size);
+  FilterbankAccumulateEnergy(&state, fft_output.data());
+  // FilterbankSqrt() overwrites the channels, so both timings include
+  // restoring them.
+  const std::vector<uint64_t> work(state.work,
+                                   state.work + state.num_channels + 1);
+  const size_t work_size = work.size() * sizeof(work[0]);
+  double reference_ns = 0.0;
+  double reference_cycles = 0.0;
+  double ns = 0.0;
+  double cycles = 0.0;
+  Time(
+      [&] {
+        memcpy(state.work, work.data(), work_size);
+        ReferenceSqrt::Compute(&state, 0);
+      },
+      &reference_ns, &reference_cycles);
+  Time(
+      [&] {
+        memcpy(state.work, work.data(), work_size);
+        FilterbankSqrt(&state, 0);
+      },
+      &ns, &cycles);
+  printf("%5" PRId32 " Hz %5.0f ns %5.0f cyc %5.0f ns %5.0f cyc\n",
+         sample_frequency, reference_ns, reference_cycles, ns, cycles);
+  FilterbankFreeStateContents(&state);
+  return true;
+}
+
+int main() {
+  std::mt19937 generator(1);
+  bool all_exact = true;
+  printf("    rate          two-pass       fused 64 bit       fused 32 bit"
+         "  exact\n");
+  for (const int32_t sample_frequency : {16000, 8000}) {
+    all_exact = BenchmarkAccumulate(&generator, sample_frequency) && all_exact;
+  }
+
+  printf("\n    rate     original sqrt              sqrt\n");
+  for (const int32_t sample_frequency : {16000, 8000}) {
+    all_exact = BenchmarkSqrt(&generator, sample_frequency) && all_exact;
+  }
+
+  struct FilterbankState state;
+  if (PopulateState(16000, &state) == 0) {
+    return EXIT_FAILURE;
+  }
+  const auto start = std::chrono::steady_clock::now();
+  const bool sqrt_exact = CheckAllSqrt(&generator, &state);
+  printf("Roots of all 32 bit and %zu random 64 bit numbers exact: %s "
+         "(%.0f s)\n",
+         num_sqrt_inputs, sqrt_exact ? "yes" : "NO",
+         std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+             .count());
+  FilterbankFreeStateContents(&state);
+  return all_exact && sqrt_exact ? EXIT_SUCCESS : EXIT_FAILURE;
+}
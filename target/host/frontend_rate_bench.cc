@@ -0,0 +1,313 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmark of the low-power 8 kHz pipeline mode, see README.md. Runs the
+// frontend at 16 kHz and at 8 kHz on the same WAV files and feeds the features
+// of both into the model. Prints the time per feature slice of the frontend
+// and of the resampler, which converts the files to the rate of the frontend,
+// as well as how often the model detects the right category at both rates.
+//
+// The files have to be 16 bit mono WAV files at audio_capture_frequency. A
+// file belongs to the category whose label matches the name of the directory
+// it is in, like in the Speech Commands dataset, e.g. `yes/0a7c2a8d_nohash_0
+// .wav`. Files in other directories only count for the agreement of the two
+// rates.
+
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC 1
+#endif
+
+#include "audio_source.h"
+#include "frontend.h"
+#include "microfrontend/lib/frontend.h"
+#include "microfrontend/lib/frontend_util.h"
+#include "model_settings.h"
+#include "resampler.h"
+#include "tvm_wrapper.h"
+
+constexpr int32_t sample_frequencies[] = {16000, 8000};
+constexpr size_t num_rates =
+    sizeof(sample_frequencies) / sizeof(sample_frequencies[0]);
+
+typedef struct {
+  int32_t sample_frequency;
+  FrontendState frontend;
+  resampler_t resampler;
+  bool resample;
+  // Elapsed time and cycles of the resampler and the frontend, and the number
+  // of slices they were spent on.
+  double resampler_ns;
+  double resampler_cycles;
+  double frontend_ns;
+  double frontend_cycles;
+  size_t num_slices;
+  size_t num_correct;
+} rate_t;
+
+typedef struct {
+  std::chrono::steady_clock::time_point start;
+#ifdef HAVE_RDTSC
+  uint64_t start_cycles;
+#endif
+} bench_timer_t;
+
+static bench_timer_t StartTimer() {
+  bench_timer_t timer;
+  timer.start = std::chrono::steady_clock::now();
+#ifdef HAVE_RDTSC
+  timer.start_cycles = __rdtsc();
+#endif
+  return timer;
+}
+
+static void StopTimer(const bench_timer_t& timer, double* ns, double* cycles) {
+#ifdef HAVE_RDTSC
+  *cycles += (double)(__rdtsc() - timer.start_cycles);
+#else
+  *cycles = NAN;
+#endif
+  *ns += std::chrono::duration<double, std::nano>(
+             std::chrono::steady_clock::now() - timer.start)
+             .count();
+}
+
+static bool ReadFile(const char* path, std::vector<uint8_t>* data) {
+  FILE* file = fopen(path, "rb");
+  if (file == NULL) {
+    return false;
+  }
+  uint8_t buffer[4096];
+  size_t size;
+  while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    data->insert(data->end(), buffer, buffer + size);
+  }
+  fclose(file);
+  return true;
+}
+
+// Index of the category named like the directory of `path`, or -1.
+static int32_t GetLabel(const std::string& path) {
+  const size_t end = path.find_last_of('/');
+  if (end == std::string::npos) {
+    return -1;
+  }
+  const size_t start = path.find_last_of('/', end - 1);
+  const std::string directory =
+      path.substr(start == std::string::npos ? 0 : start + 1,
+                  end - (start == std::string::npos ? 0 : start + 1));
+  for (int32_t i = 0; i < category_count; i++) {
+    if (directory == category_labels[i]) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Converts `input` at audio_capture_frequency to the rate of the frontend.
+static std::vector<int16_t> Resample(rate_t* rate,
+                                     const std::vector<int16_t>& input) {
+  if (!rate->resample) {
+    return input;
+  }
+  std::vector<int16_t> output(
+      input.size() * rate->sample_frequency / audio_capture_frequency + 1);
+  ResetResampler(&rate->resampler);
+  size_t read = 0;
+  size_t written = 0;
+  const bench_timer_t timer = StartTimer();
+  while (read < input.size() && written < output.size()) {
+    size_t input_read = 0;
+    size_t output_written = 0;
+    Resample(&rate->resampler, &input[read], input.size() - read, &input_read,
+             &output[written], output.size() - written, &output_written);
+    read += input_read;
+    written += output_written;
+  }
+  StopTimer(timer, &rate->resampler_ns, &rate->resampler_cycles);
+  output.resize(written);
+  return output;
+}
+
+// Runs the frontend over the samples of a file and the model after every
+// slice, once the feature window is full. Files shorter than the window are
+// padded with silence, so a one second clip gets exactly one inference.
+// Returns the category with the highest mean posterior of all inferences and
+// writes the posteriors of the last one to `posteriors`.
+static int32_t Classify(rate_t* rate, const std::vector<int16_t>& input,
+                        uint8_t* posteriors) {
+  const size_t window_samples =
+      rate->sample_frequency / 1000 *
+      ((feature_slize_count - 1) * feature_slice_stride_ms +
+       feature_slice_duration_ms);
+  std::vector<int16_t> samples = Resample(rate, input);
+  if (samples.size() < window_samples) {
+    samples.resize(window_samples, 0);
+  }
+
+  static int8_t window[feature_element_count];
+  memset(window, 0, sizeof(window));
+  model_set_input_ptr(0, window);
+  model_reset_input_position();
+  FrontendReset(&rate->frontend);
+
+  uint32_t posterior_sums[category_count] = {0};
+  size_t num_slices = 0;
+  size_t pos = 0;
+  while (pos < samples.size()) {
+    int8_t slice[feature_slice_size];
+    size_t read = 0;
+    bool ready = false;
+    const bench_timer_t timer = StartTimer();
+    ProcessFrontendSamples(&rate->frontend, &samples[pos], samples.size() - pos,
+                           &read, slice, &ready);
+    StopTimer(timer, &rate->frontend_ns, &rate->frontend_cycles);
+    pos += read;
+    if (!ready) {
+      continue;
+    }
+
+    memmove(window, &window[feature_slice_size],
+            feature_element_count - feature_slice_size);
+    memcpy(&window[feature_element_count - feature_slice_size], slice,
+           feature_slice_size);
+    num_slices++;
+    rate->num_slices++;
+    if (num_slices < (size_t)feature_slize_count) {
+      continue;
+    }
+
+    model_set_input_position(num_slices);
+    model_invoke();
+    for (int32_t i = 0; i < category_count; i++) {
+      posteriors[i] = ((int8_t*)model_output_ptr(0))[i] + 128;
+      posterior_sums[i] += posteriors[i];
+    }
+  }
+
+  int32_t best_category = 0;
+  for (int32_t i = 1; i < category_count; i++) {
+    if (posterior_sums[i] > posterior_sums[best_category]) {
+      best_category = i;
+    }
+  }
+  return best_category;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr,
+            "Usage: %s FILE.wav...\n"
+            "Compares the frontend at 16 kHz and 8 kHz on the files, which "
+            "have to be\nat %" PRId32 " Hz. The label of a file is the name "
+            "of its directory.\n",
+            argv[0], audio_capture_frequency);
+    return EXIT_FAILURE;
+  }
+
+  static rate_t rates[num_rates];
+  for (size_t i = 0; i < num_rates; i++) {
+    rate_t* rate = &rates[i];
+    rate->sample_frequency = sample_frequencies[i];
+    if (PopulateFrontendState(&rate->frontend, rate->sample_frequency) !=
+        ESP_OK) {
+      return EXIT_FAILURE;
+    }
+    rate->resample = rate->sample_frequency != audio_capture_frequency;
+    if (rate->resample &&
+        InitializeResampler(&rate->resampler, audio_capture_frequency,
+                            rate->sample_frequency,
+                            CONFIG_MICRO_KWS_AUDIO_RESAMPLER_TAPS) != ESP_OK) {
+      return EXIT_FAILURE;
+    }
+  }
+
+  size_t num_files = 0;
+  size_t num_labelled = 0;
+  size_t num_agreed = 0;
+  double posterior_error = 0.0;
+  for (int i = 1; i < argc; i++) {
+    std::vector<uint8_t> data;
+    const void* samples = NULL;
+    size_t num_samples = 0;
+    if (!ReadFile(argv[i], &data)) {
+      fprintf(stderr, "Could not read %s.\n", argv[i]);
+      return EXIT_FAILURE;
+    }
+    if (ParseWavData(data.data(), data.size(), &samples, &num_samples) !=
+        ESP_OK) {
+      fprintf(stderr, "Could not parse %s.\n", argv[i]);
+      return EXIT_FAILURE;
+    }
+    std::vector<int16_t> input(num_samples);
+    memcpy(input.data(), samples, num_samples * sizeof(int16_t));
+
+    const int32_t label = GetLabel(argv[i]);
+    int32_t categories[num_rates];
+    uint8_t posteriors[num_rates][category_count];
+    for (size_t j = 0; j < num_rates; j++) {
+      categories[j] = Classify(&rates[j], input, posteriors[j]);
+      if (categories[j] == label) {
+        rates[j].num_correct++;
+      }
+    }
+
+    num_files++;
+    num_labelled += label >= 0;
+    num_agreed += categories[0] == categories[1];
+    for (int32_t j = 0; j < category_count; j++) {
+      posterior_error += std::abs(posteriors[0][j] - posteriors[1][j]);
+    }
+  }
+
+  printf("rate     resampler/slice      frontend/slice   correct\n");
+  for (const rate_t& rate : rates) {
+    const double slices = rate.num_slices;
+    printf("%5" PRId32 " Hz %7.0f ns %7.0f cyc %7.0f ns %7.0f cyc",
+           rate.sample_frequency, rate.resampler_ns / slices,
+           rate.resampler_cycles / slices, rate.frontend_ns / slices,
+           rate.frontend_cycles / slices);
+    if (num_labelled > 0) {
+      printf(" %5.1f %%", 100.0 * rate.num_correct / num_labelled);
+    }
+    printf("\n");
+  }
+  printf("%zu files, %zu labelled, same category at both rates: %.1f %%\n",
+         num_files, num_labelled, 100.0 * num_agreed / num_files);
+  printf("mean difference of the last posteriors: %.2f / 255\n",
+         posterior_error / (num_files * category_count));
+
+  for (rate_t& rate : rates) {
+    FrontendFreeStateContents(&rate.frontend);
+    if (rate.resample) {
+      FreeResampler(&rate.resampler);
+    }
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Check of the lookup tables of the frontend, see README.md. Compares the
+// tables computed at compile time by frontend_tables.cc with those computed by
+// the original code of the microfrontend at startup, with the math library,
+// for both rates of the frontend. Prints the time the original code took and
+// the heap it allocated for the tables.
+
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "frontend_tables.h"
+#include "microfrontend/lib/bits.h"
+#include "microfrontend/lib/filterbank.h"
+#include "microfrontend/lib/pcan_gain_control_util.h"
+#include "microfrontend/lib/window.h"
+#include "model_settings.h"
+
+constexpr size_t num_timed_runs = 1000;
+
+struct ReferenceTables {
+  std::vector<int16_t> window_coefficients;
+  int start_index;
+  int end_index;
+  std::vector<int16_t> channel_frequency_starts;
+  std::vector<int16_t> channel_weight_starts;
+  std::vector<int16_t> channel_widths;
+  std::vector<int16_t> actual_channel_widths;
+  std::vector<int16_t> weights;
+  std::vector<int16_t> unweights;
+  std::vector<int16_t> pcan_gain_lut;
+
+  size_t Size() const {
+    return (window_coefficients.size() + channel_frequency_starts.size() +
+            channel_weight_starts.size() + channel_widths.size() +
+            actual_channel_widths.size() + weights.size() + unweights.size() +
+            pcan_gain_lut.size()) *
+           sizeof(int16_t);
+  }
+};
+
+// WindowPopulateState() before the tables.
+static void ReferenceWindow(size_t size, ReferenceTables* tables) {
+  tables->window_coefficients.resize(size);
+  const float arg = M_PI * 2.0 / ((float)size);
+  for (size_t i = 0; i < size; ++i) {
+    float float_value = 0.5 - (0.5 * cos(arg * (i + 0.5)));
+    tables->window_coefficients[i] =
+        floor(float_value * (1 << kFrontendWindowBits) + 0.5);
+  }
+}
+
+static float FreqToMel(float freq) { return 1127.0 * log1p(freq / 700.0); }
+
+// FilterbankPopulateState() before the tables.
+static void ReferenceFilterbank(int num_channels, float lower_band_limit,
+                                float upper_band_limit, int sample_rate,
+                                int spectrum_size, ReferenceTables* tables) {
+  const int num_channels_plus_1 = num_channels + 1;
+  const int index_alignment = 2;
+  const int block_size = 4;
+  tables->channel_frequency_starts.resize(num_channels_plus_1);
+  tables->channel_weight_starts.resize(num_channels_plus_1);
+  tables->channel_widths.resize(num_channels_plus_1);
+  std::vector<float> center_mel_freqs(num_channels_plus_1);
+  std::vector<int16_t> actual_channel_starts(num_channels_plus_1);
+  tables->actual_channel_widths.resize(num_channels_plus_1);
+
+  const float mel_low = FreqToMel(lower_band_limit);
+  const float mel_hi = FreqToMel(upper_band_limit);
+  const float mel_span = mel_hi - mel_low;
+  const float mel_spacing = mel_span / ((float)num_channels_plus_1);
+  for (int i = 0; i < num_channels_plus_1; ++i) {
+    center_mel_freqs[i] = mel_low + (mel_spacing * (i + 1));
+  }
+
+  const float hz_per_sbin = 0.5 * sample_rate / ((float)spectrum_size - 1);
+  tables->start_index = 1.5 + lower_band_limit / hz_per_sbin;
+  tables->end_index = 0;
+
+  int chan_freq_index_start = tables->start_index;
+  int weight_index_start = 0;
+  int needs_zeros = 0;
+  for (int chan = 0; chan < num_channels_plus_1; ++chan) {
+    int freq_index = chan_freq_index_start;
+    while (FreqToMel((freq_index)*hz_per_sbin) <= center_mel_freqs[chan]) {
+      ++freq_index;
+    }
+
+    const int width = freq_index - chan_freq_index_start;
+    actual_channel_starts[chan] = chan_freq_index_start;
+    tables->actual_channel_widths[chan] = width;
+
+    if (width == 0) {
+      tables->channel_frequency_starts[chan] = 0;
+      tables->channel_weight_starts[chan] = 0;
+      tables->channel_widths[chan] = block_size;
+      if (!needs_zeros) {
+        needs_zeros = 1;
+        for (int j = 0; j < chan; ++j) {
+          tables->channel_weight_starts[j] += block_size;
+        }
+        weight_index_start += block_size;
+      }
+    } else {
+      const int aligned_start =
+          (chan_freq_index_start / index_alignment) * index_alignment;
+      const int aligned_width = (chan_freq_index_start - aligned_start + width);
+      const int padded_width =
+          (((aligned_width - 1) / block_size) + 1) * block_size;
+
+      tables->channel_frequency_starts[chan] = aligned_start;
+      tables->channel_weight_starts[chan] = weight_index_start;
+      tables->channel_widths[chan] = padded_width;
+      weight_index_start += padded_width;
+    }
+    chan_freq_index_start = freq_index;
+  }
+
+  tables->weights.assign(weight_index_start, 0);
+  tables->unweights.assign(weight_index_start, 0);
+  for (int chan = 0; chan < num_channels_plus_1; ++chan) {
+    int frequency = actual_channel_starts[chan];
+    const int num_frequencies = tables->actual_channel_widths[chan];
+    const int frequency_offset =
+        frequency - tables->channel_frequency_starts[chan];
+    const int weight_start = tables->channel_weight_starts[chan];
+    const float denom_val = (chan == 0) ? mel_low : center_mel_freqs[chan - 1];
+    for (int j = 0; j < num_frequencies; ++j, ++frequency) {
+      const float weight =
+          (center_mel_freqs[chan] - FreqToMel(frequency * hz_per_sbin)) /
+          (center_mel_freqs[chan] - denom_val);
+      const int weight_index = weight_start + frequency_offset + j;
+      tables->weights[weight_index] =
+          floor(weight * (1 << kFilterbankBits) + 0.5);
+      tables->unweights[weight_index] =
+          floor((1.0 - weight) * (1 << kFilterbankBits) + 0.5);
+    }
+    if (frequency > tables->end_index) {
+      tables->end_index = frequency;
+    }
+  }
+}
+
+// PcanGainLookupFunction() before the tables.
+static int16_t ReferencePcanGain(int32_t input_bits, uint32_t x) {
+  const float x_as_float = ((float)x) / ((uint32_t)1 << input_bits);
+  const float gain_as_float =
+      ((uint32_t)1 << frontend_pcan_gain_bits) *
+      powf(x_as_float + frontend_pcan_offset, -frontend_pcan_strength);
+
+  if (gain_as_float > INT16_MAX) {
+    return INT16_MAX;
+  }
+  return (int16_t)(gain_as_float + 0.5f);
+}
+
+// PcanGainControlPopulateState() before the tables. The original left the
+// fourth entry of every interval, which is never read, uninitialized.
+static void ReferencePcan(int32_t input_correction_bits,
+                          ReferenceTables* tables) {
+  tables->pcan_gain_lut.assign(kWideDynamicFunctionLUTSize, 0);
+  int16_t* gain_lut = tables->pcan_gain_lut.data();
+  const int32_t input_bits = frontend_smoothing_bits - input_correction_bits;
+  gain_lut[0] = ReferencePcanGain(input_bits, 0);
+  gain_lut[1] = ReferencePcanGain(input_bits, 1);
+  for (int interval = 2; interval <= kWideDynamicFunctionBits; ++interval) {
+    const uint32_t x0 = (uint32_t)1 << (interval - 1);
+    const uint32_t x1 = x0 + (x0 >> 1);
+    const uint32_t x2 =
+        (interval == kWideDynamicFunctionBits) ? x0 + (x0 - 1) : 2 * x0;
+
+    const int16_t y0 = ReferencePcanGain(input_bits, x0);
+    const int16_t y1 = ReferencePcanGain(input_bits, x1);
+    const int16_t y2 = ReferencePcanGain(input_bits, x2);
+
+    const int32_t diff1 = (int32_t)y1 - y0;
+    const int32_t diff2 = (int32_t)y2 - y0;
+    const int32_t a1 = 4 * diff1 - diff2;
+    const int32_t a2 = diff2 - a1;
+
+    gain_lut[4 * interval - 6] = y0;
+    gain_lut[4 * interval - 5] = (int16_t)a1;
+    gain_lut[4 * interval - 4] = (int16_t)a2;
+  }
+}
+
+// The tables of FrontendPopulateState() before they were computed at compile
+// time.
+static void ComputeReferenceTables(int32_t sample_frequency,
+                                   ReferenceTables* tables) {
+  const size_t window_size =
+      feature_slice_duration_ms * sample_frequency / 1000;
+  size_t fft_size = 4;
+  while (fft_size < window_size) {
+    fft_size <<= 1;
+  }
+  ReferenceWindow(window_size, tables);
+  ReferenceFilterbank(feature_slice_size, frontend_lower_band_limit,
+                      FrontendUpperBandLimit(sample_frequency),
+                      sample_frequency, fft_size / 2 + 1, tables);
+  ReferencePcan(MostSignificantBit32(fft_size) - 1 - (kFilterbankBits / 2),
+                tables);
+}
+
+// Counts the entries of `table` that differ from `reference`. Entries for
+// which `used` returns false are skipped.
+template <typename Used>
+static size_t CountMismatches(const char* name,
+                              const std::vector<int16_t>& reference,
+                              const int16_t* table, Used used) {
+  size_t mismatches = 0;
+  for (size_t i = 0; i < reference.size(); i++) {
+    if (used(i) && reference[i] != table[i]) {
+      printf("  %s[%zu]: %" PRId16 " instead of %" PRId16 "\n", name, i,
+             table[i], reference[i]);
+      mismatches++;
+    }
+  }
+  return mismatches;
+}
+
+static size_t CountMismatches(const char* name,
+                              const std::vector<int16_t>& reference,
+                              const int16_t* table) {
+  return CountMismatches(name, reference, table, [](size_t) { return true; });
+}
+
+int main() {
+  bool all_exact = true;
+  printf(" rate  entries  startup   tables  exact\n");
+  for (const int32_t sample_frequency : {16000, 8000}) {
+    const frontend_tables_t* tables = GetFrontendTables(sample_frequency);
+    ReferenceTables reference;
+    ComputeReferenceTables(sample_frequency, &reference);
+
+    size_t mismatches = 0;
+    if (tables->window_size != reference.window_coefficients.size() ||
+        tables->filterbank.start_index != reference.start_index ||
+        tables->filterbank.end_index != reference.end_index ||
+        tables->size != reference.Size()) {
+      printf("  sizes differ\n");
+      mismatches++;
+    } else {
+      mismatches += CountMismatches("window", reference.window_coefficients,
+                                    tables->window_coefficients);
+      mismatches += CountMismatches(
+          "channel_frequency_starts", reference.channel_frequency_starts,
+          tables->filterbank.channel_frequency_starts);
+      mismatches += CountMismatches("channel_weight_starts",
+                                    reference.channel_weight_starts,
+                                    tables->filterbank.channel_weight_starts);
+      mismatches += CountMismatches("channel_widths", reference.channel_widths,
+                                    tables->filterbank.channel_widths);
+      mismatches += CountMismatches("actual_channel_widths",
+                                    reference.actual_channel_widths,
+                                    tables->filterbank.actual_channel_widths);
+      mismatches += CountMismatches("weights", reference.weights,
+                                    tables->filterbank.weights);
+      mismatches += CountMismatches("unweights", reference.unweights,
+                                    tables->filterbank.unweights);
+      mismatches += CountMismatches(
+          "pcan_gain_lut", reference.pcan_gain_lut, tables->pcan_gain_lut,
+          [](size_t i) { return i < 2 || (i - 2) % 4 != 3; });
+    }
+    all_exact = all_exact && mismatches == 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t run = 0; run < num_timed_runs; run++) {
+      ReferenceTables timed;
+      ComputeReferenceTables(sample_frequency, &timed);
+    }
+    const double us = std::chrono::duration<double, std::micro>(
+                          std::chrono::steady_clock::now() - start)
+                          .count() /
+                      num_timed_runs;
+
+    printf("%5" PRId32 " %8zu %6.1f us %6zu B  %s\n", sample_frequency,
+           reference.Size() / sizeof(int16_t), us, tables->size,
+           mismatches == 0 ? "yes" : "NO");
+  }
+  return all_exact ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Host replacement of main/gpio.cc. Instead of driving the RGB LED, every
+// change of its color is printed together with the current time.
+
+#include "gpio.h"
+
+#include <cstdio>
+
+#include "esp_timer.h"
+
+typedef struct {
+  const char* name;
+  uint8_t rgb[3];
+} led_color_t;
+
+static const led_color_t led_colors[] = {
+    {"black", {LED_RGB_BLACK}},     {"white", {LED_RGB_WHITE}},
+    {"red", {LED_RGB_RED}},         {"green", {LED_RGB_GREEN}},
+    {"blue", {LED_RGB_BLUE}},       {"yellow", {LED_RGB_YELLOW}},
+    {"cyan", {LED_RGB_CYAN}},       {"magenta", {LED_RGB_MAGENTA}},
+    {"orange", {LED_RGB_ORANGE}},   {"purple", {LED_RGB_PURPLE}},
+    {"mint", {LED_RGB_MINT}},
+};
+
+static uint8_t led_rgb[3] = {LED_RGB_BLACK};
+
+esp_err_t InitializeGPIO() { return ESP_OK; }
+
+esp_err_t SetLEDColor(uint8_t red, uint8_t green, uint8_t blue) {
+  if (red == led_rgb[0] && green == led_rgb[1] && blue == led_rgb[2]) {
+    return ESP_OK;
+  }
+  led_rgb[0] = red;
+  led_rgb[1] = green;
+  led_rgb[2] = blue;
+
+  const char* name = "";
+  for (size_t i = 0; i < sizeof(led_colors) / sizeof(led_colors[0]); i++) {
+    if (red == led_colors[i].rgb[0] && green == led_colors[i].rgb[1] &&
+        blue == led_colors[i].rgb[2]) {
+      name = led_colors[i].name;
+      break;
+    }
+  }
+  printf("%9.3fs LED %3d %3d %3d %s\n", esp_timer_get_time() / 1e6, red,
+         green, blue, name);
+  return ESP_OK;
+}
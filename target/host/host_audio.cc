@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "host_audio.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "audio.h"
+#include "esp_log.h"
+#include "model_settings.h"
+
+static size_t num_pcm_samples = 0;
+
+static const audio_source_t* inner_source = NULL;
+static size_t tail_samples = 0;
+static bool inner_ended = false;
+
+// Maps the file at `path` into memory. It stays mapped until the program ends.
+static esp_err_t MapFile(const char* path, const uint8_t** data, size_t* size) {
+  const int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    ESP_LOGE(__FILE__, "ERROR: Could not open %s.", path);
+    return ESP_FAIL;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+    ESP_LOGE(__FILE__, "ERROR: %s is empty.", path);
+    close(fd);
+    return ESP_FAIL;
+  }
+  void* mapping =
+      mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    ESP_LOGE(__FILE__, "ERROR: Could not map %s.", path);
+    return ESP_FAIL;
+  }
+  *data = (const uint8_t*)mapping;
+  *size = file_stat.st_size;
+  return ESP_OK;
+}
+
+// Finds the samples of a WAV or raw PCM file.
+static esp_err_t MapAudioFile(const char* path, const void** samples,
+                              size_t* num_samples) {
+  const uint8_t* data = NULL;
+  size_t size = 0;
+  esp_err_t ret = MapFile(path, &data, &size);
+  if (ret != ESP_OK) {
+    return ret;
+  }
+  if (size >= 4 && memcmp(data, "RIFF", 4) == 0) {
+    ret = ParseWavData(data, size, samples, num_samples);
+    if (ret != ESP_OK) {
+      ESP_LOGE(__FILE__, "ERROR: Could not read %s.", path);
+    }
+    return ret;
+  }
+  *samples = data;
+  *num_samples = size / sizeof(int16_t);
+  return ESP_OK;
+}
+
+esp_err_t HostAddAudioFile(const char* path) {
+  const void* samples = NULL;
+  size_t num_samples = 0;
+  esp_err_t ret = MapAudioFile(path, &samples, &num_samples);
+  if (ret != ESP_OK) {
+    return ret;
+  }
+  num_pcm_samples += num_samples;
+  return AddPcmAudioSegment(samples, num_samples);
+}
+
+esp_err_t HostAddAudioSilence(uint32_t duration_ms) {
+  const size_t num_samples =
+      (size_t)audio_capture_frequency * duration_ms / 1000;
+  num_pcm_samples += num_samples;
+  return AddPcmAudioSegment(NULL, num_samples);
+}
+
+size_t HostGetAudioSampleCount() { return num_pcm_samples; }
+
+esp_err_t HostAddAudioClip(const char* path) {
+  const void* samples = NULL;
+  size_t num_samples = 0;
+  esp_err_t ret = MapAudioFile(path, &samples, &num_samples);
+  if (ret != ESP_OK) {
+    return ret;
+  }
+  return AddSynthAudioClip(samples, num_samples);
+}
+
+// Wraps the selected source to append the silence at its end.
+static esp_err_t StartHostAudio() {
+  inner_ended = false;
+  return inner_source->start();
+}
+
+static esp_err_t ReadHostAudio(int16_t* samples, size_t num_samples,
+                               size_t* num_read) {
+  *num_read = 0;
+  if (!inner_ended) {
+    esp_err_t ret = inner_source->read(samples, num_samples, num_read);
+    if (ret != ESP_OK) {
+      return ret;
+    }
+    inner_ended = *num_read < num_samples;
+  }
+  const size_t channels = inner_source->channels;
+  const size_t count = std::min(num_samples - *num_read, tail_samples);
+  memset(&samples[*num_read * channels], 0,
+         count * channels * sizeof(int16_t));
+  *num_read += count;
+  tail_samples -= count;
+  return ESP_OK;
+}
+
+static esp_err_t StopHostAudio() { return inner_source->stop(); }
+
+static audio_source_t host_audio_source = {
+    .name = NULL,
+    .start = StartHostAudio,
+    .read = ReadHostAudio,
+    .stop = StopHostAudio,
+    .paced = false,
+    .channels = 1,
+};
+
+esp_err_t HostSetAudioSource(const audio_source_t* source, uint32_t tail_ms) {
+  inner_source = source;
+  tail_samples = (size_t)audio_capture_frequency * tail_ms / 1000;
+  host_audio_source.name = source->name;
+  host_audio_source.paced = source->paced;
+  host_audio_source.channels = source->channels;
+  return SetAudioSource(&host_audio_source);
+}
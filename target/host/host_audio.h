@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef HOST_AUDIO_H
+#define HOST_AUDIO_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "audio_source.h"
+#include "esp_err.h"
+
+// Audio input of the host build. There is no microphone, so the audio comes
+// from one of the other sources of audio_source.h, which is selected with
+// HostSetAudioSource() before the main loop starts.
+
+// Appends a file to the PCM source (see GetPcmAudioSource()). WAV files have
+// to be 16 bit mono PCM at audio_capture_frequency, all other files are taken
+// as raw 16 bit little-endian mono PCM at that rate. The file is
+// memory-mapped, not copied.
+esp_err_t HostAddAudioFile(const char* path);
+
+// Appends `duration_ms` of silence to the PCM source.
+esp_err_t HostAddAudioSilence(uint32_t duration_ms);
+
+// Total number of samples added to the PCM source so far.
+size_t HostGetAudioSampleCount();
+
+// Registers a file like in HostAddAudioFile() as clip of the synthetic source,
+// see AddSynthAudioClip().
+esp_err_t HostAddAudioClip(const char* path);
+
+// Uses `source` as audio input, followed by `tail_ms` of silence once it has
+// ended, so the end of the audio passes through the model.
+esp_err_t HostSetAudioSource(const audio_source_t* source, uint32_t tail_ms);
+
+#endif  // HOST_AUDIO_H
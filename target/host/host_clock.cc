@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "host_clock.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+// A blocked task, living on the stack of its thread while it sleeps.
+struct Sleeper {
+  int64_t wake_us;
+  const void* wake_id;
+  bool is_audio;
+  bool woken;
+};
+
+static std::mutex clock_mutex;
+static std::condition_variable clock_changed;
+
+static int64_t now_us = 0;
+
+static int running_tasks = 0;
+static std::vector<Sleeper*> sleepers;
+// Ids passed to HostClockWake() while their task was not sleeping.
+static std::unordered_set<const void*> pending_wakes;
+
+static bool audio_ended = false;
+static int64_t audio_end_us = 0;
+static bool clock_ended = false;
+
+static void WakeLocked(Sleeper* sleeper) {
+  sleepers.erase(std::find(sleepers.begin(), sleepers.end(), sleeper));
+  sleeper->woken = true;
+  running_tasks++;
+}
+
+// Moves the clock forward once all tasks are blocked. If the audio input is
+// due, it runs alone first, so that the other tasks find all samples up to the
+// new time once they wake up.
+static void AdvanceLocked() {
+  if (running_tasks > 0 || sleepers.empty() || clock_ended) {
+    return;
+  }
+
+  const Sleeper* next = *std::min_element(
+      sleepers.begin(), sleepers.end(), [](const Sleeper* a, const Sleeper* b) {
+        return a->wake_us < b->wake_us;
+      });
+  if (audio_ended && next->wake_us > audio_end_us) {
+    // Nothing left to do, the main thread terminates the program.
+    clock_ended = true;
+    clock_changed.notify_all();
+    return;
+  }
+  now_us = std::max(now_us, next->wake_us);
+
+  for (Sleeper* sleeper : sleepers) {
+    if (sleeper->is_audio && sleeper->wake_us <= now_us) {
+      WakeLocked(sleeper);
+      clock_changed.notify_all();
+      return;
+    }
+  }
+  const std::vector<Sleeper*> due = sleepers;
+  for (Sleeper* sleeper : due) {
+    if (sleeper->wake_us <= now_us) {
+      WakeLocked(sleeper);
+    }
+  }
+  clock_changed.notify_all();
+}
+
+static void SleepLocked(std::unique_lock<std::mutex>& lock, Sleeper* sleeper) {
+  sleepers.push_back(sleeper);
+  running_tasks--;
+  AdvanceLocked();
+  clock_changed.wait(lock, [sleeper] { return sleeper->woken; });
+}
+
+int64_t HostClockNow() {
+  std::lock_guard<std::mutex> lock(clock_mutex);
+  return now_us;
+}
+
+void HostClockAddTask() {
+  std::lock_guard<std::mutex> lock(clock_mutex);
+  running_tasks++;
+}
+
+void HostClockRemoveTask() {
+  std::lock_guard<std::mutex> lock(clock_mutex);
+  running_tasks--;
+  AdvanceLocked();
+}
+
+void HostClockSleepUntil(int64_t time_us, const void* wake_id) {
+  std::unique_lock<std::mutex> lock(clock_mutex);
+  if (wake_id != NULL && pending_wakes.erase(wake_id) > 0) {
+    return;
+  }
+  Sleeper sleeper = {time_us, wake_id, false, false};
+  SleepLocked(lock, &sleeper);
+}
+
+void HostClockWake(const void* wake_id) {
+  std::lock_guard<std::mutex> lock(clock_mutex);
+  for (Sleeper* sleeper : sleepers) {
+    if (sleeper->wake_id == wake_id) {
+      WakeLocked(sleeper);
+      clock_changed.notify_all();
+      return;
+    }
+  }
+  pending_wakes.insert(wake_id);
+}
+
+void HostClockWaitForAudio(int64_t time_us) {
+  std::unique_lock<std::mutex> lock(clock_mutex);
+  Sleeper sleeper = {time_us, NULL, true, false};
+  SleepLocked(lock, &sleeper);
+}
+
+void HostClockEndOfAudio() {
+  std::lock_guard<std::mutex> lock(clock_mutex);
+  audio_ended = true;
+  audio_end_us = now_us;
+}
+
+int64_t HostClockWaitForEnd() {
+  std::unique_lock<std::mutex> lock(clock_mutex);
+  clock_changed.wait(lock, [] { return clock_ended; });
+  return audio_end_us;
+}
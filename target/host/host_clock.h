@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOST_CLOCK_H
+#define HOST_CLOCK_H
+
+#include <cstddef>
+#include <cstdint>
+
+// The host build runs on a virtual clock instead of the wall clock, so that it
+// runs faster than real time and gives the same results on every run.
+//
+// The clock only moves forward once all tasks are blocked, i.e. all
+// computations take no time at all. It then jumps to the earliest time at
+// which one of the tasks wakes up again. Audio samples become available once
+// the clock has passed their capture time, just like on the device. The audio
+// input always runs first, so a task only wakes up after all samples up to the
+// new time have been delivered. This makes the serial main loop fully
+// deterministic.
+//
+// Tasks have to block through the functions below. A task waiting in any other
+// way, e.g. for a ringbuffer, counts as running and stops the clock until it
+// continues.
+
+// Current virtual time in microseconds.
+int64_t HostClockNow();
+
+// Called by xTaskCreate() for every new task, before it starts running, and
+// by a task that ends.
+void HostClockAddTask();
+void HostClockRemoveTask();
+
+// Blocks the calling task until the clock has reached `time_us`. If `wake_id`
+// is not NULL, HostClockWake() can end the sleep early. Ends the program once
+// the clock would move past the end of the audio input.
+void HostClockSleepUntil(int64_t time_us, const void* wake_id = NULL);
+
+// Wakes the task sleeping with `wake_id`. If it is not sleeping right now, its
+// next sleep with this id returns immediately.
+void HostClockWake(const void* wake_id);
+
+// Blocks the audio input until the clock has reached `time_us`, the time at
+// which the next samples have been captured completely.
+void HostClockWaitForAudio(int64_t time_us);
+
+// Called by the audio input once there are no more samples.
+void HostClockEndOfAudio();
+
+// Blocks until the clock has moved past the end of the audio input. Returns
+// the time at which the audio input ended.
+int64_t HostClockWaitForEnd();
+
+#endif  // HOST_CLOCK_H
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Entry point of the host build. Plays the given audio files, the audio from
+// stdin or synthetic audio through the unmodified MicroKWS main loop, see
+// README.md.
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "audio.h"
+#include "host_audio.h"
+#include "host_clock.h"
+#include "memory_report.h"
+#include "model_settings.h"
+#include "pipeline_stats.h"
+#include "profiler.h"
+#include "sdkconfig.h"
+
+extern "C" void app_main(void);
+
+static void PrintUsage(const char* name) {
+  fprintf(stderr,
+          "Usage: %s [OPTIONS] FILE [FILE ...]\n"
+          "       %s [OPTIONS] --synth SCRIPT\n"
+          "       %s [OPTIONS] -\n"
+          "\n"
+          "Runs the MicroKWS pipeline on %" PRId32 " Hz, 16 bit, mono audio.\n"
+          "Files are played back to back, WAV files are parsed and all\n"
+          "others are taken as raw little-endian PCM. With - the raw PCM is\n"
+          "read from stdin, with --synth the audio is generated following\n"
+          "SCRIPT, see audio_source.h.\n"
+          "\n"
+          "  --gap-ms MS   Silence between two files (default 0).\n"
+          "  --tail-ms MS  Silence after the end of the audio (default 1000),\n"
+          "                so the end passes through the model.\n"
+          "  --clip FILE   Clip for the clip:INDEX segments of SCRIPT,\n"
+          "                numbered from 0 in the given order.\n",
+          name, name, name, audio_capture_frequency);
+}
+
+int main(int argc, char* argv[]) {
+  uint32_t gap_ms = 0;
+  uint32_t tail_ms = 1000;
+  const char* synth_script = NULL;
+  bool use_stdin = false;
+  int num_files = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--gap-ms") == 0 && i + 1 < argc) {
+      gap_ms = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--tail-ms") == 0 && i + 1 < argc) {
+      tail_ms = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--synth") == 0 && i + 1 < argc) {
+      synth_script = argv[++i];
+    } else if (strcmp(argv[i], "--clip") == 0 && i + 1 < argc) {
+      if (HostAddAudioClip(argv[++i]) != ESP_OK) {
+        return EXIT_FAILURE;
+      }
+    } else if (strcmp(argv[i], "-") == 0) {
+      use_stdin = true;
+    } else if (argv[i][0] == '-') {
+      PrintUsage(argv[0]);
+      return EXIT_FAILURE;
+    } else {
+      if (num_files > 0 && HostAddAudioSilence(gap_ms) != ESP_OK) {
+        return EXIT_FAILURE;
+      }
+      const double start_s =
+          (double)HostGetAudioSampleCount() / audio_capture_frequency;
+      if (HostAddAudioFile(argv[i]) != ESP_OK) {
+        return EXIT_FAILURE;
+      }
+      printf("%9.3fs %s (%.3fs)\n", start_s, argv[i],
+             (double)HostGetAudioSampleCount() / audio_capture_frequency -
+                 start_s);
+      num_files++;
+    }
+  }
+
+  // Exactly one kind of source.
+  if ((num_files > 0) + (synth_script != NULL) + use_stdin != 1) {
+    PrintUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const audio_source_t* source = GetPcmAudioSource();
+  if (synth_script != NULL) {
+    if (ParseSynthAudioScript(synth_script) != ESP_OK) {
+      return EXIT_FAILURE;
+    }
+    source = GetSynthAudioSource();
+  } else if (use_stdin) {
+    SetStreamAudioFile(stdin);
+    source = GetStreamAudioSource();
+  }
+  HostSetAudioSource(source, tail_ms);
+
+  const auto start = std::chrono::steady_clock::now();
+  app_main();
+  const int64_t audio_end_us = HostClockWaitForEnd();
+  const double wall_s = std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+
+  const double audio_s = audio_end_us / 1e6;
+  PrintAudioStats();
+  PrintPipelineStats();
+  PrintProfile();
+#ifdef CONFIG_MICRO_KWS_PRINT_MEMORY
+  PrintMemoryReport();
+#endif  // CONFIG_MICRO_KWS_PRINT_MEMORY
+  printf("Processed %.3fs of audio in %.3fs (%.1fx real time).\n", audio_s,
+         wall_s, wall_s > 0 ? audio_s / wall_s : 0.0);
+
+  // The tasks are still running, so skip the destructors of static objects.
+  fflush(NULL);
+  std::_Exit(EXIT_SUCCESS);
+}
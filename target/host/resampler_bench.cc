@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmark of the resampler of main/resampler.h, see README.md. For every
+// supported source rate, measures the time per output sample and the
+// frequency response of the resampling filter.
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC 1
+#endif
+
+#include "model_settings.h"
+#include "resampler.h"
+#include "sdkconfig.h"
+
+static const uint32_t source_rates[] = {44100, 48000};
+
+// Chunk size of the capture task at 48 kHz, see audio.cc.
+constexpr size_t chunk_samples = 768;
+
+// Resamples all of `input` in chunks, like the capture task does.
+static std::vector<int16_t> ResampleAll(resampler_t* resampler,
+                                        const std::vector<int16_t>& input) {
+  std::vector<int16_t> output(input.size() * resampler->up / resampler->down +
+                              1);
+  size_t input_pos = 0;
+  size_t output_pos = 0;
+  while (input_pos < input.size() && output_pos < output.size()) {
+    const size_t chunk = std::min(chunk_samples, input.size() - input_pos);
+    size_t num_read = 0;
+    size_t num_written = 0;
+    Resample(resampler, &input[input_pos], chunk, &num_read,
+             &output[output_pos], output.size() - output_pos, &num_written);
+    input_pos += num_read;
+    output_pos += num_written;
+  }
+  output.resize(output_pos);
+  return output;
+}
+
+static double Rms(const int16_t* samples, size_t num_samples) {
+  double sum = 0.0;
+  for (size_t i = 0; i < num_samples; i++) {
+    sum += (double)samples[i] * samples[i];
+  }
+  return sqrt(sum / num_samples);
+}
+
+// Gain in dB for a sine of `frequency` at the source rate. The output is only
+// measured after the filter has settled.
+static double MeasureGain(resampler_t* resampler, uint32_t rate,
+                          double frequency) {
+  ResetResampler(resampler);
+  std::vector<int16_t> input(rate / 4);
+  for (size_t i = 0; i < input.size(); i++) {
+    input[i] = (int16_t)lround(16384 * sin(2 * M_PI * frequency * i / rate));
+  }
+  const std::vector<int16_t> output = ResampleAll(resampler, input);
+  const size_t settle = output.size() / 4;
+  const double input_rms = Rms(&input[0], input.size());
+  const double output_rms = Rms(&output[settle], output.size() - settle);
+  return 20 * log10(std::max(output_rms, 1e-3) / input_rms);
+}
+
+static void Benchmark(uint32_t rate, uint32_t taps) {
+  resampler_t resampler;
+  if (InitializeResampler(&resampler, rate, audio_sample_frequency, taps) !=
+      ESP_OK) {
+    exit(EXIT_FAILURE);
+  }
+
+  // Ten seconds of white noise.
+  std::vector<int16_t> noise(rate * 10);
+  uint32_t state = 1;
+  for (int16_t& sample : noise) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    sample = (int16_t)(state >> 16);
+  }
+  const auto start = std::chrono::steady_clock::now();
+#ifdef HAVE_RDTSC
+  const uint64_t start_cycles = __rdtsc();
+#endif
+  const size_t num_output = ResampleAll(&resampler, noise).size();
+#ifdef HAVE_RDTSC
+  const double cycles = (double)(__rdtsc() - start_cycles) / num_output;
+#else
+  const double cycles = NAN;
+#endif
+  const double ns = std::chrono::duration<double, std::nano>(
+                        std::chrono::steady_clock::now() - start)
+                        .count() /
+                    num_output;
+
+  // The passband and the stopband, whose aliases would fall into it.
+  double passband_error = 0.0;
+  for (double frequency = 50; frequency <= 7000; frequency += 50) {
+    passband_error = std::max(
+        passband_error, fabs(MeasureGain(&resampler, rate, frequency)));
+  }
+  double stopband_gain = -INFINITY;
+  for (double frequency = 9000; frequency < rate / 2.0; frequency += 50) {
+    stopband_gain =
+        std::max(stopband_gain, MeasureGain(&resampler, rate, frequency));
+  }
+
+  printf("%8" PRIu32 " Hz %5" PRIu32 " %10.1f %14.1f %13.3f dB %17.1f dB\n",
+         rate, resampler.taps, ns, cycles, passband_error, -stopband_gain);
+  FreeResampler(&resampler);
+}
+
+int main(int argc, char* argv[]) {
+  std::vector<uint32_t> taps;
+  for (int i = 1; i < argc; i++) {
+    char* end = NULL;
+    taps.push_back(strtoul(argv[i], &end, 10));
+    if (*end != '\0' || taps.back() == 0) {
+      fprintf(stderr,
+              "Usage: %s [TAPS ...]\n"
+              "\n"
+              "Benchmarks the resampler from all supported source rates to\n"
+              "%" PRId32 " Hz with the given filter lengths (default %d).\n"
+              "The time per output sample is measured on white noise, the\n"
+              "largest deviation from unity gain up to 7 kHz and the smallest\n"
+              "attenuation from 9 kHz up on sines.\n",
+              argv[0], audio_sample_frequency,
+              CONFIG_MICRO_KWS_AUDIO_RESAMPLER_TAPS);
+      return EXIT_FAILURE;
+    }
+  }
+  if (taps.empty()) {
+    taps.push_back(CONFIG_MICRO_KWS_AUDIO_RESAMPLER_TAPS);
+  }
+
+  printf("  Source  Taps  ns/sample  cycles/sample  Passband error"
+         "  Stopband attenuation\n");
+  for (uint32_t rate : source_rates) {
+    for (uint32_t length : taps) {
+      Benchmark(rate, length);
+    }
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "esp_heap_caps.h"
+
+#include <malloc.h>
+
+#include <atomic>
+
+// With one arena per thread, mallinfo2() would only describe the heap of the
+// main thread. The tasks are threads, so make all of them share one arena.
+static const int single_arena = mallopt(M_ARENA_MAX, 1);
+
+static std::atomic<size_t> peak_used_size{0};
+
+// The heap grows on demand, so its total size is what the C library has
+// requested from the system so far.
+static void GetHeapInfo(size_t* total_size, size_t* free_size) {
+  const struct mallinfo2 info = mallinfo2();
+  *total_size = info.arena + info.hblkhd;
+  *free_size = info.fordblks;
+  const size_t used_size = *total_size - *free_size;
+  size_t peak = peak_used_size.load();
+  while (used_size > peak &&
+         !peak_used_size.compare_exchange_weak(peak, used_size)) {
+  }
+}
+
+size_t heap_caps_get_total_size(uint32_t caps) {
+  size_t total_size = 0;
+  size_t free_size = 0;
+  GetHeapInfo(&total_size, &free_size);
+  return total_size;
+}
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+  size_t total_size = 0;
+  size_t free_size = 0;
+  GetHeapInfo(&total_size, &free_size);
+  return free_size;
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps) {
+  size_t total_size = 0;
+  size_t free_size = 0;
+  GetHeapInfo(&total_size, &free_size);
+  const size_t peak = peak_used_size.load();
+  return peak < total_size ? total_size - peak : 0;
+}
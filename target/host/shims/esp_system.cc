@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "host_clock.h"
+
+int64_t esp_timer_get_time() { return HostClockNow(); }
+
+uint32_t esp_log_timestamp() { return (uint32_t)(HostClockNow() / 1000); }
+
+static std::atomic<esp_log_level_t> log_level(ESP_LOG_VERBOSE);
+
+void esp_log_level_set(const char* tag, esp_log_level_t level) {
+  if (strcmp(tag, "*") == 0) {
+    log_level = level;
+  }
+}
+
+void esp_log_write(esp_log_level_t level, const char* tag, const char* format,
+                   ...) {
+  if (level > log_level) {
+    return;
+  }
+  va_list args;
+  va_start(args, format);
+  vfprintf(stderr, format, args);
+  va_end(args);
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <limits.h>
+#include <pthread.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "host_clock.h"
+
+struct tskTaskControlBlock {
+  TaskFunction_t function;
+  void* params;
+  char name[16];
+  std::atomic<uint32_t> notification{0};
+  // The stack of the thread, filled with stack_fill_byte before the start.
+  uint8_t* stack;
+  size_t stack_size;
+  // The stack size requested by xTaskCreate().
+  size_t stack_depth;
+};
+
+// Code compiled for the host usually needs more stack than on the device, and
+// the C library keeps the thread's local storage on its stack as well. So
+// every task gets this much stack on top of what it asked for, and only the
+// part beyond the margin counts as free in uxTaskGetStackHighWaterMark().
+static constexpr size_t stack_margin = 64 * 1024;
+static constexpr uint8_t stack_fill_byte = 0xa5;
+
+// The task running on the calling thread. The main thread, which calls
+// app_main(), gets a control block of its own.
+static tskTaskControlBlock main_task = {NULL, NULL, "main", {0}, NULL, 0, 0};
+static thread_local tskTaskControlBlock* current_task = &main_task;
+
+static constexpr int64_t tick_period_us = portTICK_PERIOD_MS * 1000;
+
+static void* RunTask(void* arg) {
+  tskTaskControlBlock* task = (tskTaskControlBlock*)arg;
+  current_task = task;
+  task->function(task->params);
+  // Just like FreeRTOS, we do not allow a task to simply return. In MicroKWS
+  // this only happens after an error.
+  fprintf(stderr, "Task %s returned, exiting.\n", task->name);
+  fflush(NULL);
+  std::_Exit(EXIT_FAILURE);
+}
+
+BaseType_t xTaskCreate(TaskFunction_t pvTaskCode, const char* pcName,
+                       uint32_t usStackDepth, void* pvParameters,
+                       UBaseType_t uxPriority, TaskHandle_t* pvCreatedTask) {
+  // The control block is never freed, as tasks are only created once.
+  tskTaskControlBlock* task = new tskTaskControlBlock;
+  task->function = pvTaskCode;
+  task->params = pvParameters;
+  strncpy(task->name, pcName, sizeof(task->name) - 1);
+  task->name[sizeof(task->name) - 1] = '\0';
+
+  // The stack is never freed either. The stack grows downwards, so the fill
+  // bytes at its start remain untouched until the stack gets close to full.
+  task->stack_depth = usStackDepth;
+  task->stack_size =
+      std::max((size_t)usStackDepth, (size_t)PTHREAD_STACK_MIN) + stack_margin;
+  if (posix_memalign((void**)&task->stack, 4096, task->stack_size) != 0) {
+    return pdFAIL;
+  }
+  memset(task->stack, stack_fill_byte, task->stack_size);
+
+  // The task counts as running from now on, so that the clock does not move on
+  // before it has started.
+  HostClockAddTask();
+  pthread_attr_t attr;
+  pthread_t thread;
+  pthread_attr_init(&attr);
+  pthread_attr_setstack(&attr, task->stack, task->stack_size);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  const int ret = pthread_create(&thread, &attr, RunTask, task);
+  pthread_attr_destroy(&attr);
+  if (ret != 0) {
+    HostClockRemoveTask();
+    return pdFAIL;
+  }
+  if (pvCreatedTask != NULL) {
+    *pvCreatedTask = task;
+  }
+  return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t xTaskToDelete) {
+  // Threads can not be stopped from the outside, so only the calling task can
+  // be deleted.
+  if (xTaskToDelete == NULL) {
+    HostClockRemoveTask();
+    pthread_exit(NULL);
+  }
+}
+
+TickType_t xTaskGetTickCount() {
+  return (TickType_t)(HostClockNow() / tick_period_us);
+}
+
+void vTaskDelay(TickType_t xTicksToDelay) {
+  if (xTicksToDelay == 0) {
+    std::this_thread::yield();
+    return;
+  }
+  HostClockSleepUntil((int64_t)(xTaskGetTickCount() + xTicksToDelay) *
+                      tick_period_us);
+}
+
+void vTaskDelayUntil(TickType_t* pxPreviousWakeTime,
+                     TickType_t xTimeIncrement) {
+  const TickType_t wake_time = *pxPreviousWakeTime + xTimeIncrement;
+  *pxPreviousWakeTime = wake_time;
+  if (wake_time > xTaskGetTickCount()) {
+    HostClockSleepUntil((int64_t)wake_time * tick_period_us);
+  }
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() { return current_task; }
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify) {
+  xTaskToNotify->notification.fetch_add(1);
+  HostClockWake(xTaskToNotify);
+  return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit,
+                          TickType_t xTicksToWait) {
+  tskTaskControlBlock* task = current_task;
+  const int64_t deadline_us =
+      xTicksToWait == portMAX_DELAY
+          ? INT64_MAX
+          : ((int64_t)xTaskGetTickCount() + xTicksToWait) * tick_period_us;
+  while (true) {
+    uint32_t value = task->notification.load();
+    while (value > 0 && !task->notification.compare_exchange_weak(
+                            value, xClearCountOnExit ? 0 : value - 1)) {
+    }
+    if (value > 0) {
+      return value;
+    }
+    if (HostClockNow() >= deadline_us) {
+      return 0;
+    }
+    // Might also return because of an earlier notification that has already
+    // been taken, so check again.
+    HostClockSleepUntil(deadline_us, task);
+  }
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t xTask) {
+  const tskTaskControlBlock* task = xTask != NULL ? xTask : current_task;
+  if (task->stack == NULL) {
+    return 0;
+  }
+  size_t untouched = 0;
+  while (untouched < task->stack_size &&
+         task->stack[untouched] == stack_fill_byte) {
+    untouched++;
+  }
+  const size_t used = task->stack_size - untouched;
+  return used < task->stack_depth ? task->stack_depth - used : 0;
+}
+
+void vTaskGetRunTimeStats(char* pcWriteBuffer) { pcWriteBuffer[0] = '\0'; }
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "driver/i2s.h"
+
+#include "esp_log.h"
+
+esp_err_t i2s_driver_install(i2s_port_t i2s_num,
+                             const i2s_config_t* i2s_config, int queue_size,
+                             void* i2s_queue) {
+  ESP_LOGE(__FILE__,
+           "ERROR: There is no microphone on the host, use another audio "
+           "source.");
+  return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t i2s_driver_uninstall(i2s_port_t i2s_num) { return ESP_OK; }
+
+esp_err_t i2s_set_pin(i2s_port_t i2s_num, const i2s_pin_config_t* pin) {
+  return ESP_OK;
+}
+
+esp_err_t i2s_zero_dma_buffer(i2s_port_t i2s_num) { return ESP_OK; }
+
+esp_err_t i2s_read(i2s_port_t i2s_num, void* dest, size_t size,
+                   size_t* bytes_read, TickType_t ticks_to_wait) {
+  *bytes_read = 0;
+  return ESP_ERR_NOT_SUPPORTED;
+}
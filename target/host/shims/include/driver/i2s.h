@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Minimal replacement of the ESP-IDF I2S driver for the host build. There is
+// no microphone, so the driver cannot be installed. The host application uses
+// the other audio sources of audio_source.h instead, see host_audio.h.
+
+#ifndef DRIVER_I2S_H
+#define DRIVER_I2S_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_INTR_FLAG_LEVEL1 (1 << 1)
+#define I2S_PIN_NO_CHANGE (-1)
+
+typedef enum {
+  I2S_NUM_0 = 0,
+  I2S_NUM_MAX,
+} i2s_port_t;
+
+typedef enum {
+  I2S_MODE_MASTER = (0x1 << 0),
+  I2S_MODE_SLAVE = (0x1 << 1),
+  I2S_MODE_TX = (0x1 << 2),
+  I2S_MODE_RX = (0x1 << 3),
+} i2s_mode_t;
+
+typedef enum {
+  I2S_BITS_PER_SAMPLE_8BIT = 8,
+  I2S_BITS_PER_SAMPLE_16BIT = 16,
+  I2S_BITS_PER_SAMPLE_24BIT = 24,
+  I2S_BITS_PER_SAMPLE_32BIT = 32,
+} i2s_bits_per_sample_t;
+
+typedef enum {
+  I2S_CHANNEL_FMT_RIGHT_LEFT,
+  I2S_CHANNEL_FMT_ALL_RIGHT,
+  I2S_CHANNEL_FMT_ALL_LEFT,
+  I2S_CHANNEL_FMT_ONLY_RIGHT,
+  I2S_CHANNEL_FMT_ONLY_LEFT,
+} i2s_channel_fmt_t;
+
+typedef enum {
+  I2S_COMM_FORMAT_STAND_I2S = 0x01,
+  I2S_COMM_FORMAT_STAND_MSB = 0x02,
+} i2s_comm_format_t;
+
+// Same member order as the original, as designated initializers have to
+// follow it in C++.
+typedef struct {
+  i2s_mode_t mode;
+  uint32_t sample_rate;
+  i2s_bits_per_sample_t bits_per_sample;
+  i2s_channel_fmt_t channel_format;
+  i2s_comm_format_t communication_format;
+  int intr_alloc_flags;
+  int dma_buf_count;
+  int dma_buf_len;
+  bool use_apll;
+  bool tx_desc_auto_clear;
+  int fixed_mclk;
+} i2s_config_t;
+
+typedef struct {
+  int mck_io_num;
+  int bck_io_num;
+  int ws_io_num;
+  int data_out_num;
+  int data_in_num;
+} i2s_pin_config_t;
+
+esp_err_t i2s_driver_install(i2s_port_t i2s_num,
+                             const i2s_config_t* i2s_config, int queue_size,
+                             void* i2s_queue);
+
+esp_err_t i2s_driver_uninstall(i2s_port_t i2s_num);
+
+esp_err_t i2s_set_pin(i2s_port_t i2s_num, const i2s_pin_config_t* pin);
+
+esp_err_t i2s_zero_dma_buffer(i2s_port_t i2s_num);
+
+esp_err_t i2s_read(i2s_port_t i2s_num, void* dest, size_t size,
+                   size_t* bytes_read, TickType_t ticks_to_wait);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // DRIVER_I2S_H
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Minimal replacement of the ESP-IDF UART driver for the host build. There is
+// no debugger GUI attached, so all data written is discarded.
+
+#ifndef DRIVER_UART_H
+#define DRIVER_UART_H
+
+#include <stddef.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UART_PIN_NO_CHANGE (-1)
+
+typedef enum {
+  UART_NUM_0 = 0,
+  UART_NUM_1,
+  UART_NUM_MAX,
+} uart_port_t;
+
+typedef enum {
+  UART_DATA_5_BITS = 0x0,
+  UART_DATA_6_BITS = 0x1,
+  UART_DATA_7_BITS = 0x2,
+  UART_DATA_8_BITS = 0x3,
+} uart_word_length_t;
+
+typedef enum {
+  UART_PARITY_DISABLE = 0x0,
+  UART_PARITY_EVEN = 0x2,
+  UART_PARITY_ODD = 0x3,
+} uart_parity_t;
+
+typedef enum {
+  UART_STOP_BITS_1 = 0x1,
+  UART_STOP_BITS_1_5 = 0x2,
+  UART_STOP_BITS_2 = 0x3,
+} uart_stop_bits_t;
+
+typedef enum {
+  UART_HW_FLOWCTRL_DISABLE = 0x0,
+  UART_HW_FLOWCTRL_RTS = 0x1,
+  UART_HW_FLOWCTRL_CTS = 0x2,
+  UART_HW_FLOWCTRL_CTS_RTS = 0x3,
+} uart_hw_flowcontrol_t;
+
+typedef enum {
+  UART_SCLK_APB = 0x0,
+  UART_SCLK_RTC = 0x1,
+  UART_SCLK_XTAL = 0x2,
+} uart_sclk_t;
+
+// Same member order as the original, as designated initializers have to
+// follow it in C++.
+typedef struct {
+  int baud_rate;
+  uart_word_length_t data_bits;
+  uart_parity_t parity;
+  uart_stop_bits_t stop_bits;
+  uart_hw_flowcontrol_t flow_ctrl;
+  unsigned char rx_flow_ctrl_thresh;
+  uart_sclk_t source_clk;
+} uart_config_t;
+
+esp_err_t uart_driver_install(uart_port_t uart_num, int rx_buffer_size,
+                              int tx_buffer_size, int queue_size,
+                              void* uart_queue, int intr_alloc_flags);
+
+esp_err_t uart_driver_delete(uart_port_t uart_num);
+
+esp_err_t uart_param_config(uart_port_t uart_num,
+                            const uart_config_t* uart_config);
+
+esp_err_t uart_set_pin(uart_port_t uart_num, int tx_io_num, int rx_io_num,
+                       int rts_io_num, int cts_io_num);
+
+int uart_write_bytes(uart_port_t uart_num, const void* src, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // DRIVER_UART_H
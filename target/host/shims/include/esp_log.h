@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Minimal replacement of the ESP-IDF esp_log.h for the host build. Log
+// messages go to stderr, so that stdout only contains the application output.
+
+#ifndef ESP_LOG_H
+#define ESP_LOG_H
+
+#include <inttypes.h>
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  ESP_LOG_NONE,
+  ESP_LOG_ERROR,
+  ESP_LOG_WARN,
+  ESP_LOG_INFO,
+  ESP_LOG_DEBUG,
+  ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+// Milliseconds since start, in the virtual time of the host build.
+uint32_t esp_log_timestamp(void);
+
+void esp_log_write(esp_log_level_t level, const char* tag, const char* format,
+                   ...);
+
+// Only supports the level of all tags, i.e. `tag` "*". Messages above the
+// configured CONFIG_LOG_DEFAULT_LEVEL are never printed either way.
+void esp_log_level_set(const char* tag, esp_log_level_t level);
+
+#define ESP_LOG_LEVEL(level, letter, tag, format, ...)                         \
+  do {                                                                         \
+    if (CONFIG_LOG_DEFAULT_LEVEL >= level) {                                   \
+      esp_log_write(level, tag, letter " (%" PRIu32 ") %s: " format "\n",      \
+                    esp_log_timestamp(), tag, ##__VA_ARGS__);                  \
+    }                                                                          \
+  } while (0)
+
+#define ESP_LOGE(tag, format, ...) \
+  ESP_LOG_LEVEL(ESP_LOG_ERROR, "E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) \
+  ESP_LOG_LEVEL(ESP_LOG_WARN, "W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) \
+  ESP_LOG_LEVEL(ESP_LOG_INFO, "I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) \
+  ESP_LOG_LEVEL(ESP_LOG_DEBUG, "D", tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) \
+  ESP_LOG_LEVEL(ESP_LOG_VERBOSE, "V", tag, format, ##__VA_ARGS__)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // ESP_LOG_H
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Minimal replacement of the ESP-IDF ringbuffer API for the host build. Byte
+// buffers behave like the original, including the wraparound that splits a
+// read into two parts. No-split buffers only keep the order of the items.
+
+#ifndef RINGBUF_H
+#define RINGBUF_H
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void* RingbufHandle_t;
+
+typedef enum {
+  RINGBUF_TYPE_NOSPLIT = 0,
+  RINGBUF_TYPE_ALLOWSPLIT,
+  RINGBUF_TYPE_BYTEBUF,
+  RINGBUF_TYPE_MAX,
+} RingbufferType_t;
+
+RingbufHandle_t xRingbufferCreate(size_t xBufferSize,
+                                  RingbufferType_t xBufferType);
+
+void vRingbufferDelete(RingbufHandle_t xRingbuffer);
+
+BaseType_t xRingbufferSend(RingbufHandle_t xRingbuffer, const void* pvItem,
+                           size_t xItemSize, TickType_t xTicksToWait);
+
+void* xRingbufferReceive(RingbufHandle_t xRingbuffer, size_t* pxItemSize,
+                         TickType_t xTicksToWait);
+
+void* xRingbufferReceiveUpTo(RingbufHandle_t xRingbuffer, size_t* pxItemSize,
+                             TickType_t xTicksToWait, size_t xMaxSize);
+
+void vRingbufferReturnItem(RingbufHandle_t xRingbuffer, void* pvItem);
+
+size_t xRingbufferGetCurFreeSize(RingbufHandle_t xRingbuffer);
+
+void vRingbufferGetInfo(RingbufHandle_t xRingbuffer, UBaseType_t* uxFree,
+                        UBaseType_t* uxRead, UBaseType_t* uxWrite,
+                        UBaseType_t* uxAcquire, UBaseType_t* uxItemsWaiting);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RINGBUF_H
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Minimal replacement of the FreeRTOS task API for the host build. Tasks are
+// threads, and delays advance the virtual time, see host_clock.h.
+
+#ifndef TASK_H
+#define TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*TaskFunction_t)(void*);
+typedef struct tskTaskControlBlock* TaskHandle_t;
+
+// The priority is ignored. The stack depth is in bytes, like in the ESP-IDF.
+BaseType_t xTaskCreate(TaskFunction_t pvTaskCode, const char* pcName,
+                       uint32_t usStackDepth, void* pvParameters,
+                       UBaseType_t uxPriority, TaskHandle_t* pvCreatedTask);
+
+// Only deleting the calling task (NULL) is supported, other tasks keep running.
+void vTaskDelete(TaskHandle_t xTaskToDelete);
+
+TickType_t xTaskGetTickCount(void);
+
+void vTaskDelay(TickType_t xTicksToDelay);
+
+void vTaskDelayUntil(TickType_t* pxPreviousWakeTime,
+                     TickType_t xTimeIncrement);
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+
+// Task notifications, used as a counting semaphore. A waiting task is blocked
+// until it is notified or the timeout has passed on the virtual clock, see
+// host_clock.h.
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify);
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit,
+                          TickType_t xTicksToWait);
+
+// Minimum amount of free stack in bytes so far, found by looking for the
+// untouched part of the stack, just like FreeRTOS does. Always zero for the
+// main thread.
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t xTask);
+
+// Writes an empty table, there are no run time stats on the host.
+void vTaskGetRunTimeStats(char* pcWriteBuffer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TASK_H
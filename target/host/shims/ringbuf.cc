@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "freertos/ringbuf.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// Blocking calls wait in wall clock time, not in the virtual time of the host
+// build. They only block if one side can not keep up, which does not happen in
+// the virtual time anyway.
+struct Ringbuffer {
+  RingbufferType_t type;
+  std::mutex mutex;
+  std::condition_variable changed;
+
+  // Byte buffers.
+  std::vector<uint8_t> data;
+  size_t read_pos = 0;
+  size_t fill = 0;
+  // Bytes handed out by xRingbufferReceiveUpTo() and not yet returned.
+  size_t acquired = 0;
+
+  // No-split buffers.
+  std::deque<std::vector<uint8_t>> items;
+  size_t capacity = 0;
+  size_t items_size = 0;
+  bool item_acquired = false;
+};
+
+static std::chrono::milliseconds TicksToDuration(TickType_t ticks) {
+  return std::chrono::milliseconds((int64_t)ticks * portTICK_PERIOD_MS);
+}
+
+RingbufHandle_t xRingbufferCreate(size_t xBufferSize,
+                                  RingbufferType_t xBufferType) {
+  if (xBufferType != RINGBUF_TYPE_BYTEBUF &&
+      xBufferType != RINGBUF_TYPE_NOSPLIT) {
+    return NULL;
+  }
+  Ringbuffer* buffer = new Ringbuffer;
+  buffer->type = xBufferType;
+  if (xBufferType == RINGBUF_TYPE_BYTEBUF) {
+    buffer->data.resize(xBufferSize);
+  } else {
+    buffer->capacity = xBufferSize;
+  }
+  return buffer;
+}
+
+void vRingbufferDelete(RingbufHandle_t xRingbuffer) {
+  delete (Ringbuffer*)xRingbuffer;
+}
+
+BaseType_t xRingbufferSend(RingbufHandle_t xRingbuffer, const void* pvItem,
+                           size_t xItemSize, TickType_t xTicksToWait) {
+  Ringbuffer* buffer = (Ringbuffer*)xRingbuffer;
+  std::unique_lock<std::mutex> lock(buffer->mutex);
+
+  if (buffer->type == RINGBUF_TYPE_BYTEBUF) {
+    const size_t size = buffer->data.size();
+    if (!buffer->changed.wait_for(lock, TicksToDuration(xTicksToWait), [&] {
+          return size - buffer->fill >= xItemSize;
+        })) {
+      return pdFALSE;
+    }
+    const uint8_t* src = (const uint8_t*)pvItem;
+    size_t write_pos = (buffer->read_pos + buffer->fill) % size;
+    for (size_t left = xItemSize; left > 0;) {
+      const size_t chunk = left < size - write_pos ? left : size - write_pos;
+      memcpy(&buffer->data[write_pos], src, chunk);
+      src += chunk;
+      left -= chunk;
+      write_pos = (write_pos + chunk) % size;
+    }
+    buffer->fill += xItemSize;
+  } else {
+    if (!buffer->changed.wait_for(lock, TicksToDuration(xTicksToWait), [&] {
+          return buffer->capacity - buffer->items_size >= xItemSize;
+        })) {
+      return pdFALSE;
+    }
+    const uint8_t* src = (const uint8_t*)pvItem;
+    buffer->items.emplace_back(src, src + xItemSize);
+    buffer->items_size += xItemSize;
+  }
+
+  buffer->changed.notify_all();
+  return pdTRUE;
+}
+
+void* xRingbufferReceive(RingbufHandle_t xRingbuffer, size_t* pxItemSize,
+                         TickType_t xTicksToWait) {
+  Ringbuffer* buffer = (Ringbuffer*)xRingbuffer;
+  if (buffer->type == RINGBUF_TYPE_BYTEBUF) {
+    return xRingbufferReceiveUpTo(xRingbuffer, pxItemSize, xTicksToWait,
+                                  buffer->data.size());
+  }
+
+  std::unique_lock<std::mutex> lock(buffer->mutex);
+  if (buffer->item_acquired ||
+      !buffer->changed.wait_for(lock, TicksToDuration(xTicksToWait),
+                                [&] { return !buffer->items.empty(); })) {
+    return NULL;
+  }
+  buffer->item_acquired = true;
+  *pxItemSize = buffer->items.front().size();
+  return buffer->items.front().data();
+}
+
+void* xRingbufferReceiveUpTo(RingbufHandle_t xRingbuffer, size_t* pxItemSize,
+                             TickType_t xTicksToWait, size_t xMaxSize) {
+  Ringbuffer* buffer = (Ringbuffer*)xRingbuffer;
+  if (buffer->type != RINGBUF_TYPE_BYTEBUF || xMaxSize == 0) {
+    return NULL;
+  }
+
+  std::unique_lock<std::mutex> lock(buffer->mutex);
+  // Just like the original, only one read can be outstanding at a time.
+  if (buffer->acquired > 0 ||
+      !buffer->changed.wait_for(lock, TicksToDuration(xTicksToWait),
+                                [&] { return buffer->fill > 0; })) {
+    return NULL;
+  }
+
+  // Stop at the end of the buffer, the rest is returned by the next call.
+  size_t size = buffer->data.size() - buffer->read_pos;
+  if (size > buffer->fill) {
+    size = buffer->fill;
+  }
+  if (size > xMaxSize) {
+    size = xMaxSize;
+  }
+  buffer->acquired = size;
+  *pxItemSize = size;
+  return &buffer->data[buffer->read_pos];
+}
+
+void vRingbufferReturnItem(RingbufHandle_t xRingbuffer, void* pvItem) {
+  Ringbuffer* buffer = (Ringbuffer*)xRingbuffer;
+  std::lock_guard<std::mutex> lock(buffer->mutex);
+
+  if (buffer->type == RINGBUF_TYPE_BYTEBUF) {
+    buffer->read_pos = (buffer->read_pos + buffer->acquired) %
+                       buffer->data.size();
+    buffer->fill -= buffer->acquired;
+    buffer->acquired = 0;
+  } else if (buffer->item_acquired) {
+    buffer->items_size -= buffer->items.front().size();
+    buffer->items.pop_front();
+    buffer->item_acquired = false;
+  }
+
+  buffer->changed.notify_all();
+}
+
+size_t xRingbufferGetCurFreeSize(RingbufHandle_t xRingbuffer) {
+  Ringbuffer* buffer = (Ringbuffer*)xRingbuffer;
+  std::lock_guard<std::mutex> lock(buffer->mutex);
+  if (buffer->type == RINGBUF_TYPE_BYTEBUF) {
+    return buffer->data.size() - buffer->fill;
+  }
+  return buffer->capacity - buffer->items_size;
+}
+
+void vRingbufferGetInfo(RingbufHandle_t xRingbuffer, UBaseType_t* uxFree,
+                        UBaseType_t* uxRead, UBaseType_t* uxWrite,
+                        UBaseType_t* uxAcquire, UBaseType_t* uxItemsWaiting) {
+  Ringbuffer* buffer = (Ringbuffer*)xRingbuffer;
+  std::lock_guard<std::mutex> lock(buffer->mutex);
+  const bool bytebuf = buffer->type == RINGBUF_TYPE_BYTEBUF;
+  if (uxFree != NULL) {
+    *uxFree = 0;
+  }
+  if (uxRead != NULL) {
+    *uxRead = bytebuf ? buffer->read_pos : 0;
+  }
+  if (uxWrite != NULL) {
+    *uxWrite =
+        bytebuf ? (buffer->read_pos + buffer->fill) % buffer->data.size() : 0;
+  }
+  if (uxAcquire != NULL) {
+    *uxAcquire = 0;
+  }
+  // For byte buffers this is the number of bytes waiting.
+  if (uxItemsWaiting != NULL) {
+    *uxItemsWaiting = bytebuf ? buffer->fill : buffer->items.size();
+  }
+}
@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmark of the window of the microfrontend, see README.md. Feeds the same
+// noise through WindowProcessSamples() and through a copy of its original
+// version, which moved the input down by the step size after every window.
+// Checks that both produce the same windows and prints the time per window.
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC 1
+#endif
+
+#include "frontend_tables.h"
+#include "microfrontend/lib/window.h"
+#include "microfrontend/lib/window_util.h"
+#include "model_settings.h"
+
+// A minute of audio, so that the time per window settles.
+constexpr size_t num_seconds = 60;
+
+// WindowProcessSamples() before the input became a ring buffer.
+static int ReferenceWindowProcessSamples(struct WindowState* state,
+                                         const int16_t* samples,
+                                         size_t num_samples,
+                                         size_t* num_samples_read) {
+  const size_t size = state->size;
+  size_t max_samples_to_copy = size - state->input_used;
+  if (max_samples_to_copy > num_samples) {
+    max_samples_to_copy = num_samples;
+  }
+  memcpy(state->input + state->input_used, samples,
+         max_samples_to_copy * sizeof(*samples));
+  *num_samples_read = max_samples_to_copy;
+  state->input_used += max_samples_to_copy;
+  if (state->input_used < size) {
+    return 0;
+  }
+
+  const int16_t* coefficients = state->coefficients;
+  const int16_t* input = state->input;
+  int16_t* output = state->output;
+  int16_t max_abs_output_value = 0;
+  for (size_t i = 0; i < size; ++i) {
+    int16_t new_value =
+        (((int32_t)*input++) * *coefficients++) >> kFrontendWindowBits;
+    *output++ = new_value;
+    if (new_value < 0) {
+      new_value = -new_value;
+    }
+    if (new_value > max_abs_output_value) {
+      max_abs_output_value = new_value;
+    }
+  }
+  memmove(state->input, state->input + state->step,
+          sizeof(*state->input) * (size - state->step));
+  state->input_used -= state->step;
+  state->max_abs_output_value = max_abs_output_value;
+  return 1;
+}
+
+typedef int (*window_function_t)(struct WindowState*, const int16_t*, size_t,
+                                 size_t*);
+
+// Full scale noise, with every hundredth sample at the negative limit, whose
+// absolute value does not fit into 16 bits.
+static std::vector<int16_t> GenerateNoise(size_t size) {
+  std::mt19937 generator(1);
+  std::uniform_int_distribution<int32_t> distribution(-32768, 32767);
+  std::vector<int16_t> noise(size);
+  for (size_t i = 0; i < size; i++) {
+    noise[i] = i % 100 == 0 ? -32768 : distribution(generator);
+  }
+  return noise;
+}
+
+// Feeds `input` to `function` in chunks of `chunk_sizes`, which repeat, and
+// appends every window and its largest absolute value to `windows`, unless it
+// is NULL. Returns the time per window in ns and cycles.
+static void Run(window_function_t function, int32_t sample_frequency,
+                const std::vector<int16_t>& input,
+                const std::vector<size_t>& chunk_sizes,
+                std::vector<int16_t>* windows, double* ns, double* cycles) {
+  struct WindowConfig config;
+  config.size_ms = feature_slice_duration_ms;
+  config.step_size_ms = feature_slice_stride_ms;
+  config.coefficients =
+      GetFrontendTables(sample_frequency)->window_coefficients;
+  struct WindowState state;
+  if (!WindowPopulateState(&config, &state, sample_frequency)) {
+    exit(EXIT_FAILURE);
+  }
+  WindowReset(&state);
+
+  size_t num_windows = 0;
+  size_t pos = 0;
+  const auto start = std::chrono::steady_clock::now();
+#ifdef HAVE_RDTSC
+  const uint64_t start_cycles = __rdtsc();
+#endif
+  for (size_t chunk = 0; pos < input.size(); chunk++) {
+    size_t chunk_end =
+        std::min(input.size(), pos + chunk_sizes[chunk % chunk_sizes.size()]);
+    while (pos < chunk_end) {
+      size_t read = 0;
+      const int ready = function(&state, &input[pos], chunk_end - pos, &read);
+      pos += read;
+      if (!ready) {
+        continue;
+      }
+      num_windows++;
+      if (windows != NULL) {
+        windows->insert(windows->end(), state.output,
+                        state.output + state.size);
+        windows->push_back(state.max_abs_output_value);
+      }
+    }
+  }
+#ifdef HAVE_RDTSC
+  *cycles = (double)(__rdtsc() - start_cycles) / num_windows;
+#else
+  *cycles = NAN;
+#endif
+  *ns = std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - start)
+            .count() /
+        num_windows;
+  WindowFreeStateContents(&state);
+}
+
+int main() {
+  // Blocks of the audio queue, the chunks of the host audio sources and odd
+  // sizes, which split the window at every possible position of the ring.
+  const std::vector<std::vector<size_t>> chunk_patterns = {
+      {256}, {1}, {7, 131, 480, 3}};
+  const int32_t sample_frequencies[] = {16000, 8000};
+
+  bool all_exact = true;
+  printf("rate     chunks         original/window        ring/window  exact\n");
+  for (const int32_t sample_frequency : sample_frequencies) {
+    const std::vector<int16_t> input =
+        GenerateNoise(num_seconds * sample_frequency);
+    for (const std::vector<size_t>& chunk_sizes : chunk_patterns) {
+      std::vector<int16_t> reference_windows;
+      std::vector<int16_t> windows;
+      double reference_ns = 0.0;
+      double reference_cycles = 0.0;
+      double ns = 0.0;
+      double cycles = 0.0;
+      Run(ReferenceWindowProcessSamples, sample_frequency, input, chunk_sizes,
+          &reference_windows, &reference_ns, &reference_cycles);
+      Run(WindowProcessSamples, sample_frequency, input, chunk_sizes, &windows,
+          &ns, &cycles);
+      const bool exact = windows == reference_windows;
+      // Time them again without collecting the windows.
+      Run(ReferenceWindowProcessSamples, sample_frequency, input, chunk_sizes,
+          NULL, &reference_ns, &reference_cycles);
+      Run(WindowProcessSamples, sample_frequency, input, chunk_sizes, NULL, &ns,
+          &cycles);
+      all_exact = all_exact && exact;
+      printf("%5" PRId32 " Hz %-8s %7.0f ns %7.0f cyc %7.0f ns %7.0f cyc  %s\n",
+             sample_frequency,
+             chunk_sizes.size() > 1 ? "mixed"
+             : chunk_sizes[0] == 1  ? "1"
+                                    : "256",
+             reference_ns, reference_cycles, ns, cycles, exact ? "yes" : "NO");
+    }
+  }
+  return all_exact ? EXIT_SUCCESS : EXIT_FAILURE;
+}
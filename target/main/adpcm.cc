@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "adpcm.h"
+
+#include <algorithm>
+
+// Quantizer step sizes and step index changes of the IMA ADPCM standard.
+static const int16_t step_table[89] = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,
+    19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+    337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+    876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+    2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+    5894,  6484,  7132,  7845,  8630,  9493,  10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+static const int8_t index_table[16] = {-1, -1, -1, -1, 2, 4, 6, 8,
+                                       -1, -1, -1, -1, 2, 4, 6, 8};
+constexpr int32_t max_step_index = 88;
+
+// Applies `nibble` to the state, exactly like the decoder does. The encoder
+// has to track the decoded signal, not the input, so that both stay in sync.
+static void UpdateState(int32_t* predictor, int32_t* step_index,
+                        uint32_t nibble, int32_t delta) {
+  *predictor = std::clamp<int32_t>(
+      *predictor + ((nibble & 8) ? -delta : delta), INT16_MIN, INT16_MAX);
+  *step_index = std::clamp<int32_t>(*step_index + index_table[nibble], 0,
+                                    max_step_index);
+}
+
+void ResetAdpcm(adpcm_state_t* state) {
+  state->predictor = 0;
+  state->step_index = 0;
+}
+
+void EncodeAdpcm(adpcm_state_t* state, const int16_t* samples,
+                 size_t num_samples, uint8_t* data, size_t data_index) {
+  int32_t predictor = state->predictor;
+  int32_t step_index = state->step_index;
+  for (size_t i = 0; i < num_samples; i++) {
+    // Quantizes the difference to the prediction in three binary steps. The
+    // delta is built from the same terms as in the decoder, so it matches the
+    // decoded difference exactly instead of the input.
+    int32_t step = step_table[step_index];
+    int32_t diff = samples[i] - predictor;
+    uint32_t nibble = 0;
+    if (diff < 0) {
+      nibble = 8;
+      diff = -diff;
+    }
+    int32_t delta = step >> 3;
+    if (diff >= step) {
+      nibble |= 4;
+      diff -= step;
+      delta += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+      nibble |= 2;
+      diff -= step;
+      delta += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+      nibble |= 1;
+      delta += step;
+    }
+    UpdateState(&predictor, &step_index, nibble, delta);
+
+    const size_t index = data_index + i;
+    if (index % 2 == 0) {
+      data[index / 2] = nibble;
+    } else {
+      data[index / 2] |= nibble << 4;
+    }
+  }
+  state->predictor = predictor;
+  state->step_index = step_index;
+}
+
+void DecodeAdpcm(adpcm_state_t* state, const uint8_t* data, size_t data_index,
+                 size_t num_samples, int16_t* samples) {
+  int32_t predictor = state->predictor;
+  int32_t step_index = state->step_index;
+  for (size_t i = 0; i < num_samples; i++) {
+    const size_t index = data_index + i;
+    const uint32_t nibble = (data[index / 2] >> (4 * (index % 2))) & 0xf;
+    const int32_t step = step_table[step_index];
+    int32_t delta = step >> 3;
+    if (nibble & 4) {
+      delta += step;
+    }
+    if (nibble & 2) {
+      delta += step >> 1;
+    }
+    if (nibble & 1) {
+      delta += step >> 2;
+    }
+    UpdateState(&predictor, &step_index, nibble, delta);
+    samples[i] = predictor;
+  }
+  state->predictor = predictor;
+  state->step_index = step_index;
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ADPCM_H
+#define ADPCM_H
+
+#include <cstddef>
+#include <cstdint>
+
+// IMA ADPCM codec, which compresses 16 bit samples to 4 bits each. Every
+// sample only costs a handful of shifts and additions, on the device and in
+// the Python decoder of the debugger. Two samples share a byte, the first one
+// in the lower nibble, like in IMA ADPCM WAV files.
+
+// The state of the encoder, and of the decoder, after the last sample. Given
+// this state, the decoder can start anywhere in the stream.
+typedef struct {
+  int16_t predictor;
+  uint8_t step_index;
+} adpcm_state_t;
+
+void ResetAdpcm(adpcm_state_t* state);
+
+// Encodes `num_samples` samples into `data`, starting at the `data_index`-th
+// nibble. Can be called several times for one buffer, with any number of
+// samples each time.
+void EncodeAdpcm(adpcm_state_t* state, const int16_t* samples,
+                 size_t num_samples, uint8_t* data, size_t data_index);
+
+// Decodes `num_samples` samples from `data`, starting at the `data_index`-th
+// nibble.
+void DecodeAdpcm(adpcm_state_t* state, const uint8_t* data, size_t data_index,
+                 size_t num_samples, int16_t* samples);
+
+#endif  // ADPCM_H
@@ -20,121 +20,577 @@
 
 #include "audio.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
 #include <cstring>
 
-#include "driver/i2s.h"
+#include "audio_convert.h"
+#include "audio_pacing.h"
+#include "beamformer.h"
 #include "esp_log.h"
 #include "esp_spi_flash.h"
-#include "freertos/ringbuf.h"
-#include "gpio.h"
+#include "esp_timer.h"
+#include "memory_report.h"
+#include "model_settings.h"
+#include "profiler.h"
+#include "resampler.h"
+#include "sdkconfig.h"
+#include "spsc_queue.h"
+
+constexpr size_t capture_task_stack_size = 1024 * 32;
+
+// The captured audio data is passed on in blocks of 512 bytes, i.e. 256
+// samples or 16ms. The audio source, e.g. the I2S driver from its DMA buffers,
+// writes the samples straight into a free block, which is then lent to the
+// consumer by pointer.
+// So this is the only copy on the way to the frontend, unless the samples have
+// to be resampled or come from several microphones. 64 blocks hold about one
+// second of audio.
+constexpr size_t audio_block_size = 512;
+constexpr size_t audio_block_samples = audio_block_size / sizeof(int16_t);
+
+// The blocks of the last CONFIG_MICRO_KWS_AUDIO_PREROLL_MS stay in the audio
+// queue after the consumer has committed them, see HoldAudio(). One block more,
+// as the oldest one only partly lies within the pre-roll. While they are held,
+// the post-roll has to fit into the queue as well, next to at least
+// `min_audio_queue_blocks` for the consumer to fall behind by. Otherwise the
+// queue keeps its `audio_queue_blocks`. The count is not rounded up to a power
+// of two, which would nearly double the memory of a long pre-roll.
+constexpr size_t DivideRoundUp(size_t value, size_t divisor) {
+  return (value + divisor - 1) / divisor;
+}
+constexpr size_t audio_history_blocks =
+    CONFIG_MICRO_KWS_AUDIO_PREROLL_MS > 0
+        ? DivideRoundUp((size_t)audio_sample_frequency *
+                            CONFIG_MICRO_KWS_AUDIO_PREROLL_MS / 1000,
+                        audio_block_samples) +
+              1
+        : 0;
+constexpr size_t audio_postroll_blocks =
+    CONFIG_MICRO_KWS_AUDIO_PREROLL_MS > 0
+        ? DivideRoundUp((size_t)audio_sample_frequency *
+                            CONFIG_MICRO_KWS_AUDIO_POSTROLL_MS / 1000,
+                        audio_block_samples)
+        : 0;
+constexpr size_t audio_queue_blocks = 64;
+constexpr size_t min_audio_queue_blocks = 32;
+constexpr size_t audio_block_count =
+    audio_history_blocks +
+    std::max(audio_queue_blocks,
+             audio_postroll_blocks + min_audio_queue_blocks);
+
+// Blocks are aligned to the 32 byte cache lines and DMA bursts of the ESP32
+// family, so that no block shares a cache line with another one. The blocks lie
+// back to back in the storage of the audio queue, so the samples of
+// consecutive blocks form one contiguous span, except where the queue wraps
+// around (see AudioPeek()).
+typedef struct {
+  alignas(32) int16_t samples[audio_block_samples];
+} audio_block_t;
+static_assert(sizeof(audio_block_t) == audio_block_size,
+              "Audio blocks must not be padded.");
+
+// Where the samples of a block belong in the audio stream.
+typedef struct {
+  // Index of the first sample, counting all samples delivered by the audio
+  // source, including the dropped ones.
+  uint64_t sample_index;
+  // Time at which the last sample of the block was captured.
+  int64_t capture_time_us;
+} audio_block_info_t;
+
+static SpscQueue<audio_block_t, audio_block_count, audio_history_blocks>
+    audio_blocks;
+// The info of every slot of the audio queue, written together with the block.
+static audio_block_info_t audio_block_infos[audio_block_count];
+
+#if CONFIG_MICRO_KWS_AUDIO_CHANNELS > 1
+// The samples of the other channels, in the same slot as the block of the
+// first channel. Just like the info, they are written together with the block.
+static audio_block_t audio_channel_blocks[audio_channels - 1]
+                                         [audio_block_count];
+#endif  // CONFIG_MICRO_KWS_AUDIO_CHANNELS > 1
+
+// Number of bytes of the oldest block that have already been committed by the
+// consumer.
+static std::atomic<size_t> audio_block_offset{0};
+
+// Index of the next sample the consumer expects. If the oldest block starts
+// later, the samples in between have been lost and the consumer gets silence
+// in their place (see AudioPeek()).
+static uint64_t consumer_sample_index = 0;
+static bool in_gap = false;
+static const int16_t gap_silence[audio_block_samples] = {0};
+
+// Number of samples returned by the last AudioPeek() that have not been
+// committed yet, and whether they are silence in place of a gap.
+static size_t audio_samples_peeked = 0;
+static bool gap_peeked = false;
+
+// Whether HoldAudio() has been called and the number of the oldest held block,
+// see SpscQueue::Hold().
+static bool audio_held = false;
+static size_t audio_held_block = 0;
+
+// Read into if there is no free block, so that the capture task keeps up with
+// the audio source.
+static audio_block_t overflow_block;
+static audio_block_info_t overflow_block_info;
+#if CONFIG_MICRO_KWS_AUDIO_CHANNELS > 1
+static audio_block_t overflow_channel_blocks[audio_channels - 1];
+#endif  // CONFIG_MICRO_KWS_AUDIO_CHANNELS > 1
+
+// If the audio source runs at a different rate, the capture task reads chunks
+// of samples at the source rate, enough for a whole block, and resamples them
+// into the blocks. Otherwise the source writes straight into the blocks.
+constexpr bool resample_audio =
+    audio_capture_frequency != audio_sample_frequency;
+constexpr size_t capture_chunk_samples =
+    resample_audio ? (audio_block_samples * audio_capture_frequency +
+                      audio_sample_frequency - 1) /
+                         audio_sample_frequency
+                   : 1;
+static resampler_t resamplers[audio_channels];
+static int16_t capture_chunks[audio_channels][capture_chunk_samples];
+static size_t capture_chunk_size = 0;
+static size_t capture_chunk_offset = 0;
+
+// Sources with several channels deliver interleaved frames, which are read
+// into `capture_frames` first. The copy into the blocks, or into the chunks if
+// resampling, splits them into the channels or combines them with the
+// beamformer.
+constexpr bool interleaved_capture = audio_capture_channels > 1;
+constexpr size_t capture_frames_size =
+    !interleaved_capture ? 1
+    : resample_audio     ? capture_chunk_samples
+                         : audio_block_samples;
+static int16_t capture_frames[capture_frames_size * audio_capture_channels];
+#ifdef CONFIG_MICRO_KWS_AUDIO_CHANNEL_MODE_BEAMFORM
+static beamformer_t beamformer;
+#endif  // CONFIG_MICRO_KWS_AUDIO_CHANNEL_MODE_BEAMFORM
 
-static RingbufHandle_t buf_handle = NULL;
 static TaskHandle_t CaptureAudioSamplesHandle = NULL;
 
+// Selected by SetAudioSource(), or by the configuration if it is NULL.
+static const audio_source_t* audio_source = NULL;
+
+// The task blocked in WaitForAudioData() and the number of bytes it waits for.
+// Only plain atomic loads and stores are used, see spsc_queue.h.
+static std::atomic<TaskHandle_t> audio_waiting_task{NULL};
+static std::atomic<size_t> audio_waiting_size{0};
+
+// Set while the capture task waits for a free block, see
+// CONFIG_MICRO_KWS_AUDIO_OVERRUN_BLOCK.
+static std::atomic<bool> capture_waiting{false};
+
+// Number of blocks the consumer should drop to make room for new samples, see
+// CONFIG_MICRO_KWS_AUDIO_OVERRUN_DROP_OLDEST. Only written by the capture task,
+// the consumer keeps track of how many it has already dropped.
+static std::atomic<uint32_t> drop_requests{0};
+
+// Like the pipeline stats, every counter is only ever written by one task.
+static std::atomic<uint32_t> blocks_captured{0};
+static std::atomic<uint32_t> overruns{0};
+static std::atomic<uint32_t> short_reads{0};
+static std::atomic<uint32_t> read_errors{0};
+static std::atomic<uint32_t> gaps{0};
+static std::atomic<uint32_t> gap_samples{0};
+
+static void Increment(std::atomic<uint32_t>* counter, uint32_t value = 1) {
+  counter->store(counter->load(std::memory_order_relaxed) + value,
+                 std::memory_order_relaxed);
+}
+
+static size_t GetAudioBytesWaiting() {
+  return audio_blocks.Size() * audio_block_size - audio_block_offset.load();
+}
+
+static audio_block_info_t* GetBlockInfo(const audio_block_t* block) {
+  if (block == &overflow_block) {
+    return &overflow_block_info;
+  }
+  return &audio_block_infos[audio_blocks.SlotOf(block)];
+}
+
+// Returns the block of `channel` that belongs to `block` of the first channel.
+static audio_block_t* GetChannelBlock(audio_block_t* block, size_t channel) {
+#if CONFIG_MICRO_KWS_AUDIO_CHANNELS > 1
+  if (channel > 0 && block == &overflow_block) {
+    return &overflow_channel_blocks[channel - 1];
+  }
+  if (channel > 0) {
+    return &audio_channel_blocks[channel - 1][audio_blocks.SlotOf(block)];
+  }
+#endif  // CONFIG_MICRO_KWS_AUDIO_CHANNELS > 1
+  return block;
+}
+
+// Returns the block to capture the next samples into, or `&overflow_block` if
+// they are going to be dropped. `overflow_pending` tells whether the overflow
+// block still holds samples waiting for a free block.
+static audio_block_t* AcquireCaptureBlock(bool overflow_pending) {
+  audio_block_t* block = audio_blocks.AcquireWrite();
+  if (block != NULL) {
+    return block;
+  }
+  Increment(&overruns);
+
+#if CONFIG_MICRO_KWS_AUDIO_OVERRUN_BLOCK
+  // Wait until the consumer has returned a block. Registered before checking
+  // again, just like in WaitForAudioData().
+  while (block == NULL) {
+    capture_waiting.store(true);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    block = audio_blocks.AcquireWrite();
+    if (block == NULL) {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      block = audio_blocks.AcquireWrite();
+    }
+    capture_waiting.store(false);
+  }
+  return block;
+#else   // CONFIG_MICRO_KWS_AUDIO_OVERRUN_BLOCK
+#if CONFIG_MICRO_KWS_AUDIO_OVERRUN_DROP_OLDEST
+  // The oldest block is still owned by the consumer, so ask it to drop the
+  // block the next time it looks for data. The new samples wait in the
+  // overflow block until then. If the consumer has not even dropped a block
+  // for the samples already waiting there, they are replaced instead, as one
+  // request per captured block would make it empty the whole queue after a
+  // long stall.
+  if (!overflow_pending) {
+    drop_requests.store(drop_requests.load() + 1);
+  }
+#endif  // CONFIG_MICRO_KWS_AUDIO_OVERRUN_DROP_OLDEST
+  return &overflow_block;
+#endif  // CONFIG_MICRO_KWS_AUDIO_OVERRUN_BLOCK
+}
+
+// Copies `num_samples` mono samples at the start of `samples` to all
+// channels of interleaved frames, in place. Going backwards, no sample is
+// overwritten before it has been copied.
+static void ExpandMonoSamples(int16_t* samples, size_t num_samples) {
+  for (size_t i = num_samples; i-- > 0;) {
+    const int16_t sample = samples[i];
+    for (size_t channel = 0; channel < audio_capture_channels; channel++) {
+      samples[i * audio_capture_channels + channel] = sample;
+    }
+  }
+}
+
+// Reads `num_samples` samples per channel from the audio source, as
+// interleaved frames if there are several channels. Returns the number of
+// samples read, which is only smaller at the end of a finite source.
+static size_t ReadSourceSamples(int16_t* samples, size_t num_samples) {
+  size_t num_read = 0;
+  while (num_read < num_samples) {
+    int16_t* frames = &samples[num_read * audio_capture_channels];
+    size_t count = 0;
+    const esp_err_t ret =
+        audio_source->read(frames, num_samples - num_read, &count);
+    if (audio_source->channels < audio_capture_channels) {
+      ExpandMonoSamples(frames, count);
+    }
+    num_read += count;
+    if (ret == ESP_ERR_TIMEOUT) {
+      // The source was too slow, the rest of the samples follow.
+      Increment(&short_reads);
+    } else if (ret != ESP_OK) {
+      // Keep capturing, the source might recover. The consumer still gets a
+      // whole block.
+      if (read_errors.load(std::memory_order_relaxed) == 0) {
+        ESP_LOGE(__FILE__, "ERROR: In CaptureAudioSamples() at read().");
+      }
+      Increment(&read_errors);
+      vTaskDelay(1);
+    } else if (num_read < num_samples) {
+      break;
+    }
+  }
+  return num_read;
+}
+
+// Splits the first `num_frames` frames of `capture_frames` into `channels`,
+// or combines them into one channel with the beamformer.
+static void SplitCaptureFrames(size_t num_frames, int16_t* const* channels) {
+  PROFILE_BEGIN(PROFILE_AUDIO_CHANNELS);
+#ifdef CONFIG_MICRO_KWS_AUDIO_CHANNEL_MODE_BEAMFORM
+  Beamform(&beamformer, capture_frames, num_frames, channels[0]);
+#else   // CONFIG_MICRO_KWS_AUDIO_CHANNEL_MODE_BEAMFORM
+  DeinterleaveAudioSamples(capture_frames, audio_capture_channels, num_frames,
+                           channels);
+#endif  // CONFIG_MICRO_KWS_AUDIO_CHANNEL_MODE_BEAMFORM
+  PROFILE_END(PROFILE_AUDIO_CHANNELS);
+}
+
+// Reads `num_samples` samples per channel into `channels`. Returns the number
+// of samples read, which is only smaller at the end of a finite source.
+static size_t ReadCaptureChannels(int16_t* const* channels,
+                                  size_t num_samples) {
+  if (!interleaved_capture) {
+    return ReadSourceSamples(channels[0], num_samples);
+  }
+  const size_t num_read = ReadSourceSamples(capture_frames, num_samples);
+  SplitCaptureFrames(num_read, channels);
+  return num_read;
+}
+
+// Fills a whole block of every channel at audio_sample_frequency. Returns the
+// number of samples written per channel, which is only smaller at the end of a
+// finite source.
+static size_t ReadAudioBlock(int16_t* const* channels) {
+  if (!resample_audio) {
+    return ReadCaptureChannels(channels, audio_block_samples);
+  }
+
+  int16_t* chunks[audio_channels];
+  for (size_t channel = 0; channel < audio_channels; channel++) {
+    chunks[channel] = capture_chunks[channel];
+  }
+  size_t num_written = 0;
+  while (num_written < audio_block_samples) {
+    if (capture_chunk_offset == capture_chunk_size) {
+      capture_chunk_size = ReadCaptureChannels(chunks, capture_chunk_samples);
+      capture_chunk_offset = 0;
+      if (capture_chunk_size == 0) {
+        break;
+      }
+    }
+    // All channels are resampled the same way, so their resamplers always
+    // take and produce the same number of samples.
+    size_t num_read = 0;
+    size_t count = 0;
+    PROFILE_BEGIN(PROFILE_AUDIO_RESAMPLE);
+    for (size_t channel = 0; channel < audio_channels; channel++) {
+      Resample(&resamplers[channel], &chunks[channel][capture_chunk_offset],
+               capture_chunk_size - capture_chunk_offset, &num_read,
+               &channels[channel][num_written],
+               audio_block_samples - num_written, &count);
+    }
+    PROFILE_END(PROFILE_AUDIO_RESAMPLE);
+    capture_chunk_offset += num_read;
+    num_written += count;
+  }
+  return num_written;
+}
+
 static void CaptureAudioSamples(void* arg) {
-  constexpr size_t bytes_to_read = 512;
-  size_t bytes_read = 0;
-  int8_t data_buf[bytes_to_read] = {0};
+  uint64_t sample_index = 0;
+  bool overflow = false;
+  bool overflow_pending = false;
 
   while (1) {
-    i2s_read((i2s_port_t)I2S_PORT_ID, (void*)data_buf, (size_t)bytes_to_read,
-             (size_t*)&bytes_read, pdMS_TO_TICKS(100));
+#if CONFIG_MICRO_KWS_AUDIO_OVERRUN_DROP_OLDEST
+    // Queue the samples waiting in the overflow block as soon as the consumer
+    // has made room. Otherwise they are replaced by the new samples below.
+    if (overflow_pending) {
+      audio_block_t* block = audio_blocks.AcquireWrite();
+      if (block != NULL) {
+        for (size_t channel = 0; channel < audio_channels; channel++) {
+          memcpy(GetChannelBlock(block, channel),
+                 GetChannelBlock(&overflow_block, channel),
+                 sizeof(audio_block_t));
+        }
+        *GetBlockInfo(block) = overflow_block_info;
+        audio_blocks.CommitWrite();
+        overflow_pending = false;
+      }
+    }
+#endif  // CONFIG_MICRO_KWS_AUDIO_OVERRUN_DROP_OLDEST
 
-    if (bytes_read < bytes_to_read) {
-      ESP_LOGE(__FILE__, "ERROR: In i2s_read(). Could ony read %d of %d bytes.",
-               bytes_read, bytes_to_read);
-      return;
+    // If the consumer has fallen behind and all blocks are in use, the
+    // configured overrun policy decides which samples get dropped.
+    audio_block_t* block = AcquireCaptureBlock(overflow_pending);
+    if (block == &overflow_block && !overflow) {
+      ESP_LOGW(__FILE__, "WARNING: Audio queue full, dropping samples.");
     }
+    overflow = block == &overflow_block;
 
-    if (xRingbufferSend(buf_handle, data_buf, bytes_read, pdMS_TO_TICKS(100)) !=
-        pdTRUE) {
-      ESP_LOGE(__FILE__,
-               "ERROR: In xRingbufferSend(). Could not send %d bytes.",
-               bytes_read);
-      return;
+    int16_t* channels[audio_channels];
+    for (size_t channel = 0; channel < audio_channels; channel++) {
+      channels[channel] = GetChannelBlock(block, channel)->samples;
+    }
+    const size_t num_read = ReadAudioBlock(channels);
+    if (num_read == 0) {
+      EndAudioCapture();
+    }
+    // The last block of a finite source is filled up with silence, a
+    // microphone always delivers whole blocks.
+    for (int16_t* samples : channels) {
+      memset(&samples[num_read], 0,
+             (audio_block_samples - num_read) * sizeof(int16_t));
+    }
+
+    // Hold back the samples of sources that are not paced by hardware until
+    // they would have been captured completely.
+    if (!audio_source->paced) {
+      WaitForAudioCaptureTime((int64_t)(sample_index + audio_block_samples) *
+                              1000000 / audio_sample_frequency);
+    }
+
+    audio_block_info_t* info = GetBlockInfo(block);
+    info->sample_index = sample_index;
+    info->capture_time_us = esp_timer_get_time();
+    sample_index += audio_block_samples;
+    Increment(&blocks_captured);
+
+    if (overflow) {
+#if CONFIG_MICRO_KWS_AUDIO_OVERRUN_DROP_OLDEST
+      overflow_pending = true;
+#endif  // CONFIG_MICRO_KWS_AUDIO_OVERRUN_DROP_OLDEST
+      continue;
+    }
+    audio_blocks.CommitWrite();
+    UpdateMemoryQueuePeak(&audio_blocks, GetAudioBytesWaiting());
+
+    // Wake up the task waiting for audio data, if there now is enough. The
+    // fence keeps the new block from becoming visible only after checking for
+    // a waiting task, which could miss a task that has just registered itself,
+    // see WaitForAudioData().
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const TaskHandle_t waiting_task = audio_waiting_task.load();
+    if (waiting_task != NULL &&
+        GetAudioBytesWaiting() >= audio_waiting_size.load()) {
+      xTaskNotifyGive(waiting_task);
     }
   }
 }
 
-esp_err_t InitializeAudio() {
-  i2s_config_t i2s_config = {
-      /* Master should supply clock and we are only receiving data. */
-      .mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX),
-      /* Sample rate of 16KHz */
-      .sample_rate = 16000,
-      /* 16bit per sample, i.e. two bytes. */
-      .bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT,
-      /* We only have a mono microphone which is outputting its audio data into
-         the left channel of the I2S interface (L/R pin connected to GND). Thus,
-         we are only interested in reading the left channel of the I2S
-         interface. */
-      .channel_format = I2S_CHANNEL_FMT_ONLY_LEFT,
-      /* We are using a standard I2S interface. */
-      .communication_format = I2S_COMM_FORMAT_STAND_I2S,
-      /* Interrupt level set to 1 for the I2S hardware interrupt. */
-      .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
-      /* Using 3 internal buffers with 300 samples each. */
-      .dma_buf_count = 3,
-      .dma_buf_len = 300,
-      /* No need for the higher resolution APLL clock. */
-      .use_apll = false,
-      /* No need for the auto clear feature since we are not transmitting. */
-      .tx_desc_auto_clear = false,
-  };
-
-  i2s_pin_config_t pin_config = {
-      /* No master clock needed. We are "only" using the bit clock. */
-      .mck_io_num = I2S_PIN_NO_CHANGE,
-      .bck_io_num = I2S_SCK_PIN,
-      /* Word select line. Selects the left or right channel of the slave
-         device. */
-      .ws_io_num = I2S_WS_PIN,
-      /* Data out is not needed as we are only working with a "data source". */
-      .data_out_num = I2S_PIN_NO_CHANGE,
-      /* Data in from slave device. */
-      .data_in_num = I2S_DATA_IN_PIN};
-
-  esp_err_t ret = ESP_OK;
+esp_err_t SetAudioSource(const audio_source_t* source) {
+  if (CaptureAudioSamplesHandle != NULL) {
+    ESP_LOGE(__FILE__, "ERROR: In SetAudioSource(). Audio already running.");
+    return ESP_ERR_INVALID_STATE;
+  }
+  audio_source = source;
+  return ESP_OK;
+}
 
-  ret = i2s_driver_install((i2s_port_t)I2S_PORT_ID, &i2s_config, 0, NULL);
+static esp_err_t SetConfiguredAudioSource() {
+#if CONFIG_MICRO_KWS_AUDIO_SOURCE_SYNTH
+  esp_err_t ret = ParseSynthAudioScript(CONFIG_MICRO_KWS_AUDIO_SYNTH_SCRIPT);
   if (ret != ESP_OK) {
-    ESP_LOGE(__FILE__, "ERROR: In InitializeAudio() at i2s_driver_install().");
     return ret;
   }
+#ifdef CONFIG_MICRO_KWS_AUDIO_SYNTH_LOOP
+  SetSynthAudioLoop(true);
+#endif  // CONFIG_MICRO_KWS_AUDIO_SYNTH_LOOP
+  audio_source = GetSynthAudioSource();
+#else
+  audio_source = GetI2sAudioSource();
+#endif  // CONFIG_MICRO_KWS_AUDIO_SOURCE_SYNTH
+  return ESP_OK;
+}
+
+esp_err_t InitializeAudio() {
+  esp_err_t ret = ESP_OK;
+
+  if (audio_source == NULL) {
+    ret = SetConfiguredAudioSource();
+    if (ret != ESP_OK) {
+      ESP_LOGE(__FILE__,
+               "ERROR: In InitializeAudio() at SetConfiguredAudioSource().");
+      return ret;
+    }
+  }
 
-  ret = i2s_set_pin((i2s_port_t)I2S_PORT_ID, &pin_config);
-  if (ret != ESP_OK) {
-    ESP_LOGE(__FILE__, "ERROR: In InitializeAudio() at i2s_set_pin().");
-    return ret;
+  if (audio_source->channels != 1 &&
+      audio_source->channels != audio_capture_channels) {
+    ESP_LOGE(__FILE__,
+             "ERROR: In InitializeAudio(). Source %s has %" PRIu32
+             " channels instead of 1 or %" PRIu32 ".",
+             audio_source->name, (uint32_t)audio_source->channels,
+             (uint32_t)audio_capture_channels);
+    return ESP_ERR_NOT_SUPPORTED;
   }
 
-  ret = i2s_zero_dma_buffer((i2s_port_t)I2S_PORT_ID);
+  if (resample_audio) {
+    size_t resampler_size = 0;
+    for (resampler_t& resampler : resamplers) {
+      ret = InitializeResampler(&resampler, audio_capture_frequency,
+                                audio_sample_frequency,
+                                CONFIG_MICRO_KWS_AUDIO_RESAMPLER_TAPS);
+      if (ret != ESP_OK) {
+        ESP_LOGE(__FILE__,
+                 "ERROR: In InitializeAudio() at InitializeResampler().");
+        return ret;
+      }
+      resampler_size += GetResamplerSize(&resampler);
+    }
+    AddMemoryBuffer("resampler", resampler_size + sizeof(capture_chunks));
+  }
+
+  if (interleaved_capture) {
+#ifdef CONFIG_MICRO_KWS_AUDIO_CHANNEL_MODE_BEAMFORM
+    ret = InitializeBeamformer(&beamformer, CONFIG_MICRO_KWS_AUDIO_BEAM_DELAY);
+    if (ret != ESP_OK) {
+      ESP_LOGE(__FILE__,
+               "ERROR: In InitializeAudio() at InitializeBeamformer().");
+      return ret;
+    }
+#endif  // CONFIG_MICRO_KWS_AUDIO_CHANNEL_MODE_BEAMFORM
+    AddMemoryBuffer("capture frames", sizeof(capture_frames));
+  }
+#if CONFIG_MICRO_KWS_AUDIO_CHANNELS > 1
+  AddMemoryBuffer("audio channels", sizeof(audio_channel_blocks));
+#endif  // CONFIG_MICRO_KWS_AUDIO_CHANNELS > 1
+
+  ret = audio_source->start();
   if (ret != ESP_OK) {
-    ESP_LOGE(__FILE__, "ERROR: In InitializeAudio() at i2s_zero_dma_buffer().");
+    ESP_LOGE(__FILE__, "ERROR: In InitializeAudio() at start() of source %s.",
+             audio_source->name);
     return ret;
   }
 
-  buf_handle = xRingbufferCreate(1024 * 32, RINGBUF_TYPE_BYTEBUF);
-  if (buf_handle == NULL) {
-    ESP_LOGE(__FILE__, "ERROR: In InitializeAudio() at xRingbufferCreate().");
-    return ret;
+  // The history of the audio queue is reported separately, as it never fills
+  // up with waiting samples.
+  constexpr size_t history_size = audio_history_blocks * audio_block_size;
+  AddMemoryQueue(&audio_blocks, "audio", sizeof(audio_blocks) - history_size);
+  if (history_size > 0) {
+    AddMemoryBuffer("audio pre-roll", history_size);
   }
 
-  if (xTaskCreate(CaptureAudioSamples, "CaptureAudioSamples", 1024 * 32, NULL,
-                  10, &CaptureAudioSamplesHandle) != pdPASS) {
+  if (xTaskCreate(CaptureAudioSamples, "CaptureAudioSamples",
+                  capture_task_stack_size, NULL, 10,
+                  &CaptureAudioSamplesHandle) != pdPASS) {
     ESP_LOGE(
         __FILE__,
         "ERROR: In InitializeAudio() at xTaskCreate(CaptureAudioSamples).");
     return ESP_FAIL;
   }
+  AddMemoryTask(CaptureAudioSamplesHandle, "CaptureAudioSamples",
+                capture_task_stack_size);
 
   return ret;
 }
 
 esp_err_t StopAudio() {
-  // TODO(fabianpedd): Also free Ringbuffer and deinstall I2S driver
   vTaskDelete(CaptureAudioSamplesHandle);
-  return ESP_OK;
+  CaptureAudioSamplesHandle = NULL;
+  return audio_source->stop();
+}
+
+esp_err_t WaitForAudioData(size_t min_size, TickType_t timeout) {
+  const TickType_t start_ticks = xTaskGetTickCount();
+  // Register before checking the audio queue. Otherwise the capture task could
+  // add the missing data in between without waking us up.
+  audio_waiting_size.store(min_size);
+  audio_waiting_task.store(xTaskGetCurrentTaskHandle());
+
+  esp_err_t ret = ESP_OK;
+  while (GetAudioBytesWaiting() < min_size) {
+    const TickType_t waited_ticks = xTaskGetTickCount() - start_ticks;
+    if (waited_ticks >= timeout) {
+      ret = ESP_ERR_TIMEOUT;
+      break;
+    }
+    // A notification left over from an earlier call only causes another
+    // check of the audio queue.
+    ulTaskNotifyTake(pdTRUE, timeout - waited_ticks);
+  }
+
+  audio_waiting_task.store(NULL);
+  return ret;
 }
 
 esp_err_t GetAudioData(size_t requested_size, size_t* actual_size,
@@ -142,63 +598,296 @@ esp_err_t GetAudioData(size_t requested_size, size_t* actual_size,
   // Set returned number of bytes to zero for now.
   *actual_size = 0;
 
-  // Peak into the Ringbuffer.
-  size_t bytes_waiting = 0;
-  vRingbufferGetInfo(buf_handle, NULL, NULL, NULL, NULL,
-                     (UBaseType_t*)&bytes_waiting);
-
-  // Check if we actually have the requested amount of bytes available. If yes,
-  // get the data. If not, simply return zero.
-  if (bytes_waiting >= requested_size) {
-    // Get the data from the Ringbuffer.
-    size_t bytes_received = 0;
-    int8_t* buf_data =
-        (int8_t*)xRingbufferReceiveUpTo(buf_handle, (size_t*)&bytes_received,
-                                        pdMS_TO_TICKS(100), requested_size);
-
-    // Check whether we have encountered a wraparound in the Ringbuffer. If so,
-    // we need to read a second time in order to retrieve all data. See here
-    // https://docs.espressif.com/projects/esp-idf/en/v4.4/esp32c3/api-reference/system/freertos_additions.html#_CPPv422xRingbufferReceiveUpTo15RingbufHandle_tP6size_t10TickType_t6size_t
-    if (buf_data != NULL && bytes_received < requested_size) {
-      // Copy the data from the Ringbuffer into output buffer and free the
-      // ringbuffer data.
-      memcpy(data, buf_data, bytes_received);
-      vRingbufferReturnItem(buf_handle, (void*)buf_data);
-
-      // Move the data pointer and adjust the amount of data needed accordingly.
-      data += bytes_received;
-      *actual_size += bytes_received;
-      requested_size -= bytes_received;
-
-      // Get the rest of the data from the top of the Ringbuffer.
-      buf_data =
-          (int8_t*)xRingbufferReceiveUpTo(buf_handle, (size_t*)&bytes_received,
-                                          pdMS_TO_TICKS(100), requested_size);
-    }
-
-    if (buf_data != NULL && bytes_received == requested_size) {
-      // Copy the data from the Ringbuffer into output buffer and free the
-      // ringbuffer data.
-      memcpy(data, buf_data, bytes_received);
-      vRingbufferReturnItem(buf_handle, (void*)buf_data);
-
-      *actual_size += bytes_received;
-      return ESP_OK;
-
-    } else {
-      ESP_LOGE(
-          __FILE__,
-          "ERROR: Only read %d of %d bytes from Ringbuffer. Something went "
-          "wrong, as there should be enough data available.",
-          *actual_size, requested_size);
-      // TODO(fabianpedd): Should not be needed here. But maybe reintroduce as a
-      // safety measure?
-      // vRingbufferReturnItem(buf_handle, (void *)buf_data);
+  // Check if we actually have the requested amount of bytes available. If not,
+  // simply return zero. No big deal, so print no error.
+  if (GetAudioBytesWaiting() < requested_size) {
+    return ESP_OK;
+  }
+
+  // The data might wrap around the end of the audio queue, and gaps are copied
+  // as silence.
+  while (*actual_size < requested_size) {
+    audio_span_t spans[2];
+    AudioPeek(0, spans, NULL);
+    if (spans[0].num_samples == 0) {
+      ESP_LOGE(__FILE__,
+               "ERROR: Only read %d of %d bytes from the audio queue. "
+               "Something went wrong, as there should be enough data "
+               "available.",
+               *actual_size, requested_size);
       return ESP_FAIL;
     }
-  } else {
-    // Did not have enough data currently. No big deal, so print no error.
-    data = NULL;
+    size_t num_samples = 0;
+    for (const audio_span_t& span : spans) {
+      const size_t size =
+          std::min(span.num_samples * sizeof(int16_t),
+                   requested_size - *actual_size);
+      memcpy(data + *actual_size, span.samples, size);
+      *actual_size += size;
+      num_samples += size / sizeof(int16_t);
+    }
+    AudioCommit(num_samples);
+  }
+  return ESP_OK;
+}
+
+#if CONFIG_MICRO_KWS_AUDIO_OVERRUN_DROP_OLDEST
+// Number of the drop_requests the consumer has already handled.
+static uint32_t drops_done = 0;
+
+// Drops the blocks requested by the capture task, see AcquireCaptureBlock().
+static void DropRequestedBlocks() {
+  const uint32_t requests = drop_requests.load();
+  for (; drops_done != requests; drops_done++) {
+    if (audio_blocks.Peek() == NULL) {
+      drops_done = requests;
+      break;
+    }
+    audio_block_offset.store(0);
+    audio_blocks.Release();
+  }
+}
+#endif  // CONFIG_MICRO_KWS_AUDIO_OVERRUN_DROP_OLDEST
+
+esp_err_t AudioPeek(size_t min_samples, audio_span_t spans[2],
+                    audio_position_t* position) {
+  spans[0] = {NULL, 0};
+  spans[1] = {NULL, 0};
+  audio_samples_peeked = 0;
+#if CONFIG_MICRO_KWS_AUDIO_OVERRUN_DROP_OLDEST
+  DropRequestedBlocks();
+#endif  // CONFIG_MICRO_KWS_AUDIO_OVERRUN_DROP_OLDEST
+  const audio_block_t* block = audio_blocks.Peek();
+  if (block == NULL) {
+    return ESP_OK;
+  }
+
+  const size_t offset = audio_block_offset.load() / sizeof(int16_t);
+  const audio_block_info_t* info = GetBlockInfo(block);
+  const uint64_t sample_index = info->sample_index + offset;
+  if (sample_index > consumer_sample_index) {
+    // Samples are missing, return silence in their place.
+    const uint64_t missing = sample_index - consumer_sample_index;
+    spans[0] = {gap_silence,
+                (size_t)std::min(missing, (uint64_t)audio_block_samples)};
+    audio_samples_peeked = spans[0].num_samples;
+    gap_peeked = true;
+    if (!in_gap) {
+      in_gap = true;
+      Increment(&gaps);
+    }
+    if (position != NULL) {
+      position->sample_index = consumer_sample_index;
+      position->capture_time_us = info->capture_time_us;
+      position->gap_samples = missing;
+    }
+    return ESP_OK;
+  }
+
+  // Take all following blocks which continue the audio stream without a gap.
+  // Only the wrap around of the audio queue starts the second span.
+  audio_span_t* span = &spans[0];
+  span->samples = &block->samples[offset];
+  span->num_samples = audio_block_samples - offset;
+  size_t num_samples = span->num_samples;
+  uint64_t next_sample_index = info->sample_index + audio_block_samples;
+  for (size_t i = 1;; i++) {
+    const audio_block_t* next_block = audio_blocks.PeekAt(i);
+    if (next_block == NULL ||
+        GetBlockInfo(next_block)->sample_index != next_sample_index) {
+      break;
+    }
+    if (next_block != block + 1) {
+      span = &spans[1];
+      span->samples = next_block->samples;
+    }
+    span->num_samples += audio_block_samples;
+    num_samples += audio_block_samples;
+    next_sample_index += audio_block_samples;
+    block = next_block;
+  }
+
+  if (num_samples < min_samples) {
+    spans[0] = {NULL, 0};
+    spans[1] = {NULL, 0};
+    return ESP_OK;
+  }
+  audio_samples_peeked = num_samples;
+  gap_peeked = false;
+  in_gap = false;
+  if (position != NULL) {
+    position->sample_index = sample_index;
+    position->capture_time_us = info->capture_time_us;
+    position->gap_samples = 0;
+  }
+  return ESP_OK;
+}
+
+const int16_t* GetAudioChannelSamples(const int16_t* samples, size_t channel) {
+#if CONFIG_MICRO_KWS_AUDIO_CHANNELS > 1
+  // The silence in place of a gap is the same for all channels.
+  if (channel == 0 || (samples >= gap_silence &&
+                       samples < gap_silence + audio_block_samples)) {
+    return samples;
+  }
+  // The blocks lie back to back, so the offset from the first one gives both
+  // the slot and the position within the block.
+  const size_t offset = samples - audio_blocks.AtSlot(0)->samples;
+  return &audio_channel_blocks[channel - 1][offset / audio_block_samples]
+              .samples[offset % audio_block_samples];
+#else   // CONFIG_MICRO_KWS_AUDIO_CHANNELS > 1
+  return samples;
+#endif  // CONFIG_MICRO_KWS_AUDIO_CHANNELS > 1
+}
+
+esp_err_t AudioCommit(size_t num_samples) {
+  if (num_samples > audio_samples_peeked) {
+    ESP_LOGE(__FILE__,
+             "ERROR: In AudioCommit(). Only %" PRIu32
+             " samples are left of the last AudioPeek().",
+             (uint32_t)audio_samples_peeked);
+    return ESP_ERR_INVALID_ARG;
+  }
+  audio_samples_peeked -= num_samples;
+  consumer_sample_index += num_samples;
+  if (gap_peeked) {
+    Increment(&gap_samples, num_samples);
+    return ESP_OK;
+  }
+
+  // Store the new offset before freeing the blocks. This way the capture task
+  // never sees less data waiting than there actually is.
+  size_t offset = audio_block_offset.load() + num_samples * sizeof(int16_t);
+  const size_t num_blocks = offset / audio_block_size;
+  offset %= audio_block_size;
+  audio_block_offset.store(offset);
+  for (size_t i = 0; i < num_blocks; i++) {
+    audio_blocks.Release();
+  }
+#if CONFIG_MICRO_KWS_AUDIO_OVERRUN_BLOCK
+  // Wake up the capture task if it waits for a free block, see
+  // AcquireCaptureBlock().
+  if (num_blocks > 0) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (capture_waiting.load()) {
+      xTaskNotifyGive(CaptureAudioSamplesHandle);
+    }
+  }
+#endif  // CONFIG_MICRO_KWS_AUDIO_OVERRUN_BLOCK
+  return ESP_OK;
+}
+
+esp_err_t SkipAudioGap() {
+  audio_samples_peeked = 0;
+  const audio_block_t* block = audio_blocks.Peek();
+  if (block == NULL) {
     return ESP_OK;
   }
+  const uint64_t sample_index = GetBlockInfo(block)->sample_index +
+                                audio_block_offset.load() / sizeof(int16_t);
+  if (sample_index > consumer_sample_index) {
+    Increment(&gap_samples, sample_index - consumer_sample_index);
+    consumer_sample_index = sample_index;
+  }
+  return ESP_OK;
+}
+
+esp_err_t HoldAudio() {
+  if (audio_history_blocks == 0) {
+    ESP_LOGE(__FILE__,
+             "ERROR: In HoldAudio(). CONFIG_MICRO_KWS_AUDIO_PREROLL_MS is 0.");
+    return ESP_ERR_NOT_SUPPORTED;
+  }
+  audio_held_block = audio_blocks.Hold();
+  audio_held = true;
+  return ESP_OK;
+}
+
+esp_err_t GetHeldAudio(uint64_t start_index, uint64_t end_index,
+                       audio_span_t spans[2], uint64_t* first_index,
+                       bool* complete) {
+  spans[0] = {NULL, 0};
+  spans[1] = {NULL, 0};
+  *first_index = start_index;
+  *complete = false;
+  if (!audio_held) {
+    ESP_LOGE(__FILE__, "ERROR: In GetHeldAudio(). The audio is not held.");
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  // The blocks are looked at right where the capture task has written them,
+  // just like in AudioPeek(). Only the wrap around of the audio queue starts
+  // the second span, and a gap in the audio stream ends the range early.
+  const size_t end = audio_blocks.End();
+  const audio_block_t* previous_block = NULL;
+  uint64_t next_sample_index = 0;
+  audio_span_t* span = &spans[0];
+  for (size_t number = audio_held_block; number != end;
+       number = audio_blocks.Next(number)) {
+    const audio_block_t* block = audio_blocks.ItemAt(number);
+    const audio_block_info_t* info = GetBlockInfo(block);
+    const uint64_t block_end = info->sample_index + audio_block_samples;
+    if (block_end <= start_index) {
+      continue;
+    }
+    if (previous_block != NULL && info->sample_index != next_sample_index) {
+      *complete = true;
+      break;
+    }
+
+    const uint64_t from = std::max(info->sample_index, start_index);
+    const uint64_t to = std::min(block_end, end_index);
+    if (from >= to) {
+      *complete = true;
+      break;
+    }
+    if (previous_block == NULL) {
+      *first_index = from;
+      span->samples = &block->samples[from - info->sample_index];
+    } else if (block != previous_block + 1) {
+      span = &spans[1];
+      span->samples = block->samples;
+    }
+    span->num_samples += to - from;
+    if (to == end_index) {
+      *complete = true;
+      break;
+    }
+    previous_block = block;
+    next_sample_index = block_end;
+  }
+  return ESP_OK;
+}
+
+esp_err_t ReleaseAudio() {
+  audio_blocks.Unhold();
+  audio_held = false;
+#if CONFIG_MICRO_KWS_AUDIO_OVERRUN_BLOCK
+  // The capture task might wait for the held blocks, see AudioCommit().
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (capture_waiting.load()) {
+    xTaskNotifyGive(CaptureAudioSamplesHandle);
+  }
+#endif  // CONFIG_MICRO_KWS_AUDIO_OVERRUN_BLOCK
+  return ESP_OK;
+}
+
+audio_stats_t GetAudioStats() {
+  audio_stats_t stats;
+  stats.blocks_captured = blocks_captured.load(std::memory_order_relaxed);
+  stats.overruns = overruns.load(std::memory_order_relaxed);
+  stats.short_reads = short_reads.load(std::memory_order_relaxed);
+  stats.read_errors = read_errors.load(std::memory_order_relaxed);
+  stats.gaps = gaps.load(std::memory_order_relaxed);
+  stats.gap_samples = gap_samples.load(std::memory_order_relaxed);
+  return stats;
+}
+
+esp_err_t PrintAudioStats() {
+  const audio_stats_t stats = GetAudioStats();
+  printf("Audio: blocks %" PRIu32 ", overruns %" PRIu32 ", short reads %" PRIu32
+         ", read errors %" PRIu32 ", gaps %" PRIu32 " (%" PRIu32 " samples)\n",
+         stats.blocks_captured, stats.overruns, stats.short_reads,
+         stats.read_errors, stats.gaps, stats.gap_samples);
+  return ESP_OK;
 }
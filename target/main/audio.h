@@ -21,15 +21,128 @@
 #ifndef AUDIO_H
 #define AUDIO_H
 
+#include <cstddef>
 #include <cstdint>
 
+#include "audio_source.h"
 #include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+// Selects where the audio data comes from, see audio_source.h. Has to be called
+// before InitializeAudio(). Otherwise the source selected in the configuration
+// is used (CONFIG_MICRO_KWS_AUDIO_SOURCE).
+esp_err_t SetAudioSource(const audio_source_t* source);
 
 esp_err_t InitializeAudio();
 
 esp_err_t StopAudio();
 
+// Blocks until at least `min_size` bytes of captured audio data are waiting in
+// the audio queue, but at most for `timeout` ticks. Returns
+// ESP_ERR_TIMEOUT if there is still not enough data. The capture task wakes up
+// the waiting task with a task notification, so there is no polling involved.
+// Only one task may wait at a time.
+esp_err_t WaitForAudioData(size_t min_size, TickType_t timeout);
+
 esp_err_t GetAudioData(size_t requested_size, size_t* actual_size,
                        int8_t* data);
 
+// Where the samples returned by AudioPeek() belong in the audio stream.
+typedef struct {
+  // Index of the first sample, counting from the start of the capture.
+  uint64_t sample_index;
+  // Time at which the block containing the samples was captured completely.
+  int64_t capture_time_us;
+  // Samples that were lost, e.g. because the audio queue was full, are
+  // replaced by silence. If this is not zero, the samples are such silence
+  // and `gap_samples` samples are missing in total, including the returned
+  // ones. The caller can either process the silence, which keeps the timing of
+  // the following samples, or skip the whole gap with SkipAudioGap().
+  uint32_t gap_samples;
+} audio_position_t;
+
+// Contiguous samples in the audio queue.
+typedef struct {
+  const int16_t* samples;
+  size_t num_samples;
+} audio_span_t;
+
+// Returns all captured samples waiting in the audio queue, directly in the
+// blocks the capture task has written them to, without copying them. As the
+// queue is a ring of blocks, the samples are split into two spans if they wrap
+// around its end. Otherwise the second span is empty. Both spans are empty if
+// fewer than `min_samples` samples are waiting. Does not wait for samples, see
+// WaitForAudioData().
+//
+// The samples stay in the queue until they are released with AudioCommit(),
+// so the caller can look at more samples than it consumes, e.g. at a whole
+// window when advancing by the hop size. At a gap in the audio stream, the
+// first span instead holds up to one block of silence, see audio_position_t.
+// If `position` is not NULL, it is set to the position of the first sample in
+// the audio stream.
+esp_err_t AudioPeek(size_t min_samples, audio_span_t spans[2],
+                    audio_position_t* position = NULL);
+
+// The spans of AudioPeek() hold the samples of the first channel. Returns the
+// samples of `channel`, less than audio_channels, which belong to `samples`
+// of such a span. They stay valid just as long.
+const int16_t* GetAudioChannelSamples(const int16_t* samples, size_t channel);
+
+// Releases the oldest `num_samples` samples of the last AudioPeek(). Can be
+// called several times for the same AudioPeek(), as long as the samples last.
+esp_err_t AudioCommit(size_t num_samples);
+
+// Skips the rest of the gap AudioPeek() currently reports, so that the next
+// call returns the samples after it. Ends the last AudioPeek().
+esp_err_t SkipAudioGap();
+
+// The audio queue keeps the blocks of the last
+// CONFIG_MICRO_KWS_AUDIO_PREROLL_MS after they have been committed, so that
+// recent audio can still be looked at, e.g. the audio of a detected keyword
+// (see keyword_audio.h). HoldAudio() keeps these blocks and all blocks
+// captured afterwards in the queue until ReleaseAudio(), and GetHeldAudio()
+// returns the samples of a part of them without copying them. Only one task
+// may hold the audio, which does not have to be the consumer. While the audio
+// is held, the capture task can not reuse the held blocks, so the audio queue
+// runs full if it is held for too long, see CONFIG_MICRO_KWS_AUDIO_OVERRUN.
+esp_err_t HoldAudio();
+
+// Returns the held samples from `start_index` up to `end_index` (exclusive),
+// in the audio stream timebase of audio_position_t. Just like AudioPeek(),
+// the samples are split into two spans if they wrap around the end of the
+// audio queue. Samples that are no longer or not yet in the queue are left
+// out, so `*first_index` is set to the index of the first returned sample,
+// which might be later than `start_index`. The range also ends early at a gap
+// in the audio stream. `*complete` tells whether the range ends there for
+// good, i.e. whether all of its samples that are ever going to be captured
+// are returned. The spans stay valid until ReleaseAudio().
+esp_err_t GetHeldAudio(uint64_t start_index, uint64_t end_index,
+                       audio_span_t spans[2], uint64_t* first_index,
+                       bool* complete);
+
+esp_err_t ReleaseAudio();
+
+// Counters of the audio input, for finding out whether a missed keyword was
+// caused by lost audio.
+typedef struct {
+  // Blocks of 256 samples read from the audio source.
+  uint32_t blocks_captured;
+  // How often the capture task found the audio queue full. Depending on
+  // CONFIG_MICRO_KWS_AUDIO_OVERRUN, samples were dropped or the capture task
+  // had to wait.
+  uint32_t overruns;
+  // Reads which timed out before the audio source delivered all samples, and
+  // reads which failed.
+  uint32_t short_reads;
+  uint32_t read_errors;
+  // Number of gaps the consumer found in the samples and the total number of
+  // missing samples.
+  uint32_t gaps;
+  uint32_t gap_samples;
+} audio_stats_t;
+
+audio_stats_t GetAudioStats();
+
+esp_err_t PrintAudioStats();
+
 #endif  // AUDIO_H
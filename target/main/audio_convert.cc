@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "audio_convert.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "esp_log.h"
+
+// Fraction bits of the DC blocker state. Steps between two full-scale 24 bit
+// samples still fit into 32 bits.
+constexpr uint32_t dc_fraction_bits = 5;
+
+static int16_t Saturate(int32_t value) {
+  return (int16_t)std::clamp<int32_t>(value, INT16_MIN, INT16_MAX);
+}
+
+esp_err_t InitializeDcBlocker(dc_blocker_t* dc_blocker, uint32_t sample_rate) {
+  if (sample_rate == 0) {
+    ESP_LOGE(__FILE__, "ERROR: In InitializeDcBlocker(). Invalid arguments.");
+    return ESP_ERR_INVALID_ARG;
+  }
+  // The cutoff frequency is about sample_rate / (2 * pi * 2^shift).
+  dc_blocker->shift = 1;
+  while (sample_rate > 2 * M_PI * 10 * (1 << dc_blocker->shift)) {
+    dc_blocker->shift++;
+  }
+  return ResetDcBlocker(dc_blocker);
+}
+
+esp_err_t ResetDcBlocker(dc_blocker_t* dc_blocker) {
+  dc_blocker->last_input = 0;
+  dc_blocker->output = 0;
+  return ESP_OK;
+}
+
+void ConvertAudioSamples(const int32_t* __restrict input,
+                         int16_t* __restrict output, size_t num_samples,
+                         uint32_t gain_shift) {
+  // Rounds by halving the result of one shift less, which can not overflow
+  // like adding half of the divisor could.
+  const uint32_t shift = 15 - gain_shift;
+  for (size_t i = 0; i < num_samples; i++) {
+    output[i] = Saturate(((input[i] >> shift) + 1) >> 1);
+  }
+}
+
+void ConvertAudioSamplesDcBlocked(const int32_t* __restrict input,
+                                  int16_t* __restrict output,
+                                  size_t num_samples, size_t num_channels,
+                                  uint32_t gain_shift,
+                                  dc_blocker_t* dc_blockers) {
+  // The filter depends on its previous output, so the samples of a channel are
+  // processed one by one, with the state kept in registers.
+  for (size_t channel = 0; channel < num_channels; channel++) {
+    dc_blocker_t* dc_blocker = &dc_blockers[channel];
+    const uint32_t shift = dc_blocker->shift;
+    const uint32_t output_shift = dc_fraction_bits + 8 - gain_shift;
+    const int32_t round = 1 << (output_shift - 1);
+    const int32_t decay_round = 1 << (shift - 1);
+    int32_t last_input = dc_blocker->last_input;
+    int32_t filtered = dc_blocker->output;
+    const size_t end = num_samples * num_channels;
+    for (size_t i = channel; i < end; i += num_channels) {
+      const int32_t sample = input[i] >> 8;
+      filtered += (sample - last_input) * (1 << dc_fraction_bits) -
+                  ((filtered + decay_round) >> shift);
+      last_input = sample;
+      output[i] = Saturate((filtered + round) >> output_shift);
+    }
+    dc_blocker->last_input = last_input;
+    dc_blocker->output = filtered;
+  }
+}
+
+void DeinterleaveAudioSamples(const int16_t* __restrict input,
+                              size_t num_channels, size_t num_frames,
+                              int16_t* const* __restrict outputs) {
+  for (size_t channel = 0; channel < num_channels; channel++) {
+    int16_t* __restrict output = outputs[channel];
+    for (size_t i = 0; i < num_frames; i++) {
+      output[i] = input[i * num_channels + channel];
+    }
+  }
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef AUDIO_CONVERT_H
+#define AUDIO_CONVERT_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+
+// Conversion of the 32 bit slots of 24 or 32 bit I2S microphones to the 16 bit
+// samples of the rest of the pipeline. The samples are left-aligned in their
+// slots, so without gain a sample keeps its upper 16 bits. A gain of
+// 2^`gain_shift` takes lower bits instead, with `gain_shift` from 0 to 8, and
+// the result is rounded and saturated.
+constexpr uint32_t max_convert_gain_shift = 8;
+
+// One-pole high-pass filter which removes the DC offset many MEMS microphones
+// have, y[n] = x[n] - x[n-1] + (1 - 2^-shift) * y[n-1]. It runs on the upper
+// 24 bits of the samples, with extra fraction bits for the filter state.
+typedef struct {
+  uint32_t shift;
+  int32_t last_input;
+  int32_t output;
+} dc_blocker_t;
+
+// Chooses the shift for a cutoff frequency of at most 10 Hz at `sample_rate`
+// and resets the filter state.
+esp_err_t InitializeDcBlocker(dc_blocker_t* dc_blocker, uint32_t sample_rate);
+
+esp_err_t ResetDcBlocker(dc_blocker_t* dc_blocker);
+
+// Converts `num_samples` slots from `input` to `output`. There are no
+// dependencies between samples, so this vectorizes well.
+void ConvertAudioSamples(const int32_t* input, int16_t* output,
+                         size_t num_samples, uint32_t gain_shift);
+
+// Like ConvertAudioSamples(), but also removes the DC offset in the same pass.
+// The slots of `num_channels` channels are interleaved, each channel has its
+// own filter in `dc_blockers` and `num_samples` counts the samples per channel.
+void ConvertAudioSamplesDcBlocked(const int32_t* input, int16_t* output,
+                                  size_t num_samples, size_t num_channels,
+                                  uint32_t gain_shift,
+                                  dc_blocker_t* dc_blockers);
+
+// Splits `num_frames` frames of `num_channels` interleaved samples into one
+// array per channel in `outputs`.
+void DeinterleaveAudioSamples(const int16_t* input, size_t num_channels,
+                              size_t num_frames, int16_t* const* outputs);
+
+#endif  // AUDIO_CONVERT_H
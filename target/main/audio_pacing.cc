@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "audio_pacing.h"
+
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static bool started = false;
+static TickType_t start_ticks = 0;
+
+esp_err_t WaitForAudioCaptureTime(int64_t capture_time_us) {
+  if (!started) {
+    start_ticks = xTaskGetTickCount();
+    started = true;
+  }
+
+  // Round up, the samples must not be delivered early.
+  constexpr int64_t tick_us = portTICK_PERIOD_MS * 1000;
+  const TickType_t wake_ticks =
+      start_ticks + (TickType_t)((capture_time_us + tick_us - 1) / tick_us);
+  const TickType_t now_ticks = xTaskGetTickCount();
+  // Compared as signed difference to cope with the overflow of the tick count.
+  if ((int32_t)(wake_ticks - now_ticks) > 0) {
+    vTaskDelay(wake_ticks - now_ticks);
+  }
+  return ESP_OK;
+}
+
+void EndAudioCapture() {
+  ESP_LOGW(__FILE__, "WARNING: Audio source ended.");
+  while (1) {
+    vTaskDelay(portMAX_DELAY);
+  }
+}
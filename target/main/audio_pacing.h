@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef AUDIO_PACING_H
+#define AUDIO_PACING_H
+
+#include <cstdint>
+
+#include "esp_err.h"
+
+// Lets the capture task deliver the samples of sources that are not paced by
+// hardware (see audio_source.h) at the rate they would have been captured. The
+// host build replaces this with its virtual clock, see ../host.
+
+// Blocks until `capture_time_us` has passed since the first call, i.e. until
+// the samples captured up to this time would be available.
+esp_err_t WaitForAudioCaptureTime(int64_t capture_time_us);
+
+// Called by the capture task once the audio source has ended. Never returns,
+// just like a microphone that stopped delivering data.
+void EndAudioCapture();
+
+#endif  // AUDIO_PACING_H
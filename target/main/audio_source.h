@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef AUDIO_SOURCE_H
+#define AUDIO_SOURCE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include "esp_err.h"
+
+// Where the capture task of audio.cc gets its samples from. All sources
+// deliver 16 bit samples at audio_capture_frequency, either mono or with the
+// audio_capture_channels channels interleaved.
+typedef struct {
+  const char* name;
+  esp_err_t (*start)();
+  // Reads up to `num_samples` samples per channel. `*num_read` is only smaller
+  // at the end of a finite source and zero once there is nothing left. A paced
+  // source returns ESP_ERR_TIMEOUT if it could not deliver all samples in time,
+  // the `*num_read` samples it did deliver are still valid.
+  esp_err_t (*read)(int16_t* samples, size_t num_samples, size_t* num_read);
+  esp_err_t (*stop)();
+  // Whether read() itself blocks until the samples have been captured, like
+  // the I2S driver does. The samples of all other sources are available right
+  // away, so the capture task holds them back until their capture time, see
+  // audio_pacing.h.
+  bool paced;
+  // Either 1 or audio_capture_channels. The capture task copies the samples of
+  // mono sources to all channels.
+  size_t channels;
+} audio_source_t;
+
+// The I2S microphone.
+const audio_source_t* GetI2sAudioSource();
+
+// Plays 16 bit mono PCM data from memory, e.g. embedded into the firmware or a
+// memory-mapped file on the host. The segments are played back to back in the
+// order they were added. The data is not copied, so it has to stay valid while
+// the source is in use.
+const audio_source_t* GetPcmAudioSource();
+
+// Appends `num_samples` little-endian samples at `data`, which does not need
+// to be aligned. Appends silence if `data` is NULL.
+esp_err_t AddPcmAudioSegment(const void* data, size_t num_samples);
+
+// Appends the samples of a WAV file in memory. Only PCM, 1 channel,
+// audio_capture_frequency and 16 bits are supported.
+esp_err_t AddWavAudioSegment(const void* data, size_t size);
+
+// Finds the samples of a WAV file in memory, see AddWavAudioSegment().
+esp_err_t ParseWavData(const void* data, size_t size, const void** samples,
+                       size_t* num_samples);
+
+// Generates test signals following a script of segments, which are played back
+// to back. The noise generators are seeded the same way on every start, so the
+// signal is the same on every run.
+const audio_source_t* GetSynthAudioSource();
+
+typedef enum {
+  SYNTH_SILENCE,
+  SYNTH_TONE,
+  SYNTH_WHITE_NOISE,
+  SYNTH_PINK_NOISE,
+  // Plays a clip added with AddSynthAudioClip() on top of white noise.
+  SYNTH_CLIP,
+} synth_segment_type_t;
+
+typedef struct {
+  synth_segment_type_t type;
+  // Ignored for SYNTH_CLIP, which always plays the whole clip.
+  uint32_t duration_ms;
+  uint32_t frequency_hz;
+  // Peak amplitude of the tone or the noise, up to 32767.
+  uint32_t amplitude;
+  uint32_t clip;
+} synth_segment_t;
+
+esp_err_t AddSynthAudioSegment(const synth_segment_t* segment);
+
+// Parses a script of comma separated segments and appends them:
+//   silence:MS
+//   tone:MS:HZ:AMPLITUDE
+//   white:MS:AMPLITUDE
+//   pink:MS:AMPLITUDE
+//   clip:INDEX[:NOISE_AMPLITUDE]
+// e.g. "pink:1000:500,tone:500:1000:8000,clip:0:500,silence:1000".
+esp_err_t ParseSynthAudioScript(const char* script);
+
+// Registers a clip of `num_samples` little-endian samples at `data` for
+// SYNTH_CLIP segments, e.g. a recorded keyword. The clips are numbered from
+// zero in the order they were added. The data is not copied.
+esp_err_t AddSynthAudioClip(const void* data, size_t num_samples);
+
+// Restarts the script once it has ended instead of ending the source.
+esp_err_t SetSynthAudioLoop(bool loop);
+
+// Reads raw 16 bit little-endian mono PCM data from a stream, e.g. stdin or a
+// file on a mounted file system. Ends at the end of the stream.
+const audio_source_t* GetStreamAudioSource();
+
+esp_err_t SetStreamAudioFile(FILE* file);
+
+#endif  // AUDIO_SOURCE_H
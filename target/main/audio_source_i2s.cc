@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "audio_source.h"
+
+#include <algorithm>
+
+#include "audio_convert.h"
+#include "driver/i2s.h"
+#include "esp_log.h"
+#include "gpio.h"
+#include "memory_report.h"
+#include "model_settings.h"
+#include "sdkconfig.h"
+
+// Number of samples per channel and DMA buffer.
+constexpr size_t i2s_dma_buf_len = 300;
+
+#ifdef CONFIG_MICRO_KWS_I2S_BITS_32
+constexpr i2s_bits_per_sample_t i2s_bits_per_sample =
+    I2S_BITS_PER_SAMPLE_32BIT;
+
+// The driver copies the samples out of its DMA buffers anyway, so they are
+// read into a buffer of the same size and converted from there straight into
+// the samples of the caller, in a single pass.
+static int32_t i2s_slots[i2s_dma_buf_len * audio_capture_channels];
+#ifdef CONFIG_MICRO_KWS_I2S_DC_BLOCK
+static dc_blocker_t dc_blockers[audio_capture_channels];
+#endif  // CONFIG_MICRO_KWS_I2S_DC_BLOCK
+#else   // CONFIG_MICRO_KWS_I2S_BITS_32
+constexpr i2s_bits_per_sample_t i2s_bits_per_sample =
+    I2S_BITS_PER_SAMPLE_16BIT;
+#endif  // CONFIG_MICRO_KWS_I2S_BITS_32
+
+static esp_err_t StartI2s() {
+  i2s_config_t i2s_config = {
+      /* Master should supply clock and we are only receiving data. */
+      .mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX),
+      /* Sample rate of the microphone, resampled to 16KHz if needed. */
+      .sample_rate = audio_capture_frequency,
+      /* 16bit per sample, i.e. two bytes, or 24 or 32 bit samples in 32 bit
+         slots, see CONFIG_MICRO_KWS_I2S_BITS. */
+      .bits_per_sample = i2s_bits_per_sample,
+      /* A single microphone outputs its audio data into the left channel of
+         the I2S interface (L/R pin connected to GND), so we only read the left
+         channel. A second microphone outputs into the right channel (L/R pin
+         connected to VDD), then both channels are read interleaved, see
+         CONFIG_MICRO_KWS_AUDIO_CHANNEL_MODE. */
+      .channel_format = audio_capture_channels == 1
+                            ? I2S_CHANNEL_FMT_ONLY_LEFT
+                            : I2S_CHANNEL_FMT_RIGHT_LEFT,
+      /* We are using a standard I2S interface. */
+      .communication_format = I2S_COMM_FORMAT_STAND_I2S,
+      /* Interrupt level set to 1 for the I2S hardware interrupt. */
+      .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
+      /* Using 3 internal buffers with 300 samples each. */
+      .dma_buf_count = 3,
+      .dma_buf_len = i2s_dma_buf_len,
+      /* No need for the higher resolution APLL clock. */
+      .use_apll = false,
+      /* No need for the auto clear feature since we are not transmitting. */
+      .tx_desc_auto_clear = false,
+  };
+
+  i2s_pin_config_t pin_config = {
+      /* No master clock needed. We are "only" using the bit clock. */
+      .mck_io_num = I2S_PIN_NO_CHANGE,
+      .bck_io_num = I2S_SCK_PIN,
+      /* Word select line. Selects the left or right channel of the slave
+         device. */
+      .ws_io_num = I2S_WS_PIN,
+      /* Data out is not needed as we are only working with a "data source". */
+      .data_out_num = I2S_PIN_NO_CHANGE,
+      /* Data in from slave device. */
+      .data_in_num = I2S_DATA_IN_PIN};
+
+  esp_err_t ret = ESP_OK;
+
+  ret = i2s_driver_install((i2s_port_t)I2S_PORT_ID, &i2s_config, 0, NULL);
+  if (ret != ESP_OK) {
+    ESP_LOGE(__FILE__, "ERROR: In StartI2s() at i2s_driver_install().");
+    return ret;
+  }
+
+  ret = i2s_set_pin((i2s_port_t)I2S_PORT_ID, &pin_config);
+  if (ret != ESP_OK) {
+    ESP_LOGE(__FILE__, "ERROR: In StartI2s() at i2s_set_pin().");
+    return ret;
+  }
+
+  ret = i2s_zero_dma_buffer((i2s_port_t)I2S_PORT_ID);
+  if (ret != ESP_OK) {
+    ESP_LOGE(__FILE__, "ERROR: In StartI2s() at i2s_zero_dma_buffer().");
+    return ret;
+  }
+
+#ifdef CONFIG_MICRO_KWS_I2S_BITS_32
+  AddMemoryBuffer("i2s slots", sizeof(i2s_slots));
+#ifdef CONFIG_MICRO_KWS_I2S_DC_BLOCK
+  for (dc_blocker_t& dc_blocker : dc_blockers) {
+    ret = InitializeDcBlocker(&dc_blocker, audio_capture_frequency);
+    if (ret != ESP_OK) {
+      ESP_LOGE(__FILE__, "ERROR: In StartI2s() at InitializeDcBlocker().");
+      return ret;
+    }
+  }
+#endif  // CONFIG_MICRO_KWS_I2S_DC_BLOCK
+#endif  // CONFIG_MICRO_KWS_I2S_BITS_32
+
+  return ret;
+}
+
+#ifdef CONFIG_MICRO_KWS_I2S_BITS_32
+static esp_err_t ReadI2s(int16_t* samples, size_t num_samples,
+                         size_t* num_read) {
+  *num_read = 0;
+  while (*num_read < num_samples) {
+    const size_t count = std::min(num_samples - *num_read, i2s_dma_buf_len);
+    constexpr size_t frame_size = sizeof(int32_t) * audio_capture_channels;
+    size_t bytes_read = 0;
+    const esp_err_t ret =
+        i2s_read((i2s_port_t)I2S_PORT_ID, (void*)i2s_slots, count * frame_size,
+                 &bytes_read, pdMS_TO_TICKS(100));
+    const size_t frames_read = bytes_read / frame_size;
+    int16_t* output = &samples[*num_read * audio_capture_channels];
+#ifdef CONFIG_MICRO_KWS_I2S_DC_BLOCK
+    ConvertAudioSamplesDcBlocked(i2s_slots, output, frames_read,
+                                 audio_capture_channels,
+                                 CONFIG_MICRO_KWS_I2S_GAIN_SHIFT, dc_blockers);
+#else   // CONFIG_MICRO_KWS_I2S_DC_BLOCK
+    ConvertAudioSamples(i2s_slots, output,
+                        frames_read * audio_capture_channels,
+                        CONFIG_MICRO_KWS_I2S_GAIN_SHIFT);
+#endif  // CONFIG_MICRO_KWS_I2S_DC_BLOCK
+    *num_read += frames_read;
+    if (ret != ESP_OK) {
+      return ret;
+    }
+    // Anything less means that the samples did not arrive in time, just like
+    // with 16 bit samples.
+    if (frames_read < count) {
+      return ESP_ERR_TIMEOUT;
+    }
+  }
+  return ESP_OK;
+}
+#else   // CONFIG_MICRO_KWS_I2S_BITS_32
+static esp_err_t ReadI2s(int16_t* samples, size_t num_samples,
+                         size_t* num_read) {
+  constexpr size_t frame_size = sizeof(int16_t) * audio_capture_channels;
+  size_t bytes_read = 0;
+  const esp_err_t ret =
+      i2s_read((i2s_port_t)I2S_PORT_ID, (void*)samples,
+               num_samples * frame_size, &bytes_read, pdMS_TO_TICKS(100));
+  *num_read = bytes_read / frame_size;
+  if (ret != ESP_OK) {
+    return ret;
+  }
+
+  // A microphone never runs out of samples, so anything less means that the
+  // samples did not arrive in time.
+  return *num_read < num_samples ? ESP_ERR_TIMEOUT : ESP_OK;
+}
+#endif  // CONFIG_MICRO_KWS_I2S_BITS_32
+
+static esp_err_t StopI2s() {
+  return i2s_driver_uninstall((i2s_port_t)I2S_PORT_ID);
+}
+
+static const audio_source_t i2s_audio_source = {
+    .name = "i2s",
+    .start = StartI2s,
+    .read = ReadI2s,
+    .stop = StopI2s,
+    .paced = true,
+    .channels = audio_capture_channels,
+};
+
+const audio_source_t* GetI2sAudioSource() { return &i2s_audio_source; }
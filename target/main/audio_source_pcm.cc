@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "audio_source.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+
+#include "esp_log.h"
+#include "model_settings.h"
+
+typedef struct {
+  // NULL for silence.
+  const uint8_t* data;
+  size_t num_samples;
+} pcm_segment_t;
+
+// Segments are only added before the source is started, so a plain array that
+// grows with every segment is good enough.
+static pcm_segment_t* segments = NULL;
+static size_t num_segments = 0;
+
+static size_t segment_index = 0;
+static size_t segment_offset = 0;
+
+esp_err_t AddPcmAudioSegment(const void* data, size_t num_samples) {
+  pcm_segment_t* new_segments = (pcm_segment_t*)realloc(
+      segments, (num_segments + 1) * sizeof(pcm_segment_t));
+  if (new_segments == NULL) {
+    ESP_LOGE(__FILE__, "ERROR: In AddPcmAudioSegment() at realloc().");
+    return ESP_ERR_NO_MEM;
+  }
+  segments = new_segments;
+  segments[num_segments].data = (const uint8_t*)data;
+  segments[num_segments].num_samples = num_samples;
+  num_segments++;
+  return ESP_OK;
+}
+
+static uint32_t ReadLE(const uint8_t* data, size_t size) {
+  uint32_t value = 0;
+  for (size_t i = 0; i < size; i++) {
+    value |= (uint32_t)data[i] << (8 * i);
+  }
+  return value;
+}
+
+esp_err_t ParseWavData(const void* data, size_t size, const void** samples,
+                       size_t* num_samples) {
+  const uint8_t* bytes = (const uint8_t*)data;
+  if (size < 12 || memcmp(bytes, "RIFF", 4) != 0 ||
+      memcmp(&bytes[8], "WAVE", 4) != 0) {
+    ESP_LOGE(__FILE__, "ERROR: Not a WAV file.");
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  // Walk through the chunks until we find the data, the format has to be known
+  // by then.
+  bool format_ok = false;
+  size_t pos = 12;
+  while (pos + 8 <= size) {
+    const uint8_t* chunk = &bytes[pos];
+    const size_t chunk_size =
+        std::min((size_t)ReadLE(&chunk[4], 4), size - pos - 8);
+    pos += 8;
+
+    if (memcmp(chunk, "fmt ", 4) == 0) {
+      if (chunk_size < 16) {
+        break;
+      }
+      const uint8_t* format = &bytes[pos];
+      const uint32_t audio_format = ReadLE(&format[0], 2);
+      const uint32_t channels = ReadLE(&format[2], 2);
+      const uint32_t sample_rate = ReadLE(&format[4], 4);
+      const uint32_t bits_per_sample = ReadLE(&format[14], 2);
+      if (audio_format != 1 || channels != 1 ||
+          sample_rate != audio_capture_frequency || bits_per_sample != 16) {
+        ESP_LOGE(__FILE__,
+                 "ERROR: WAV file has format %" PRIu32 ", %" PRIu32
+                 " channels, %" PRIu32 " Hz and %" PRIu32
+                 " bits. Only PCM, 1 channel, %" PRIu32
+                 " Hz and 16 bits are supported.",
+                 audio_format, channels, sample_rate, bits_per_sample,
+                 (uint32_t)audio_capture_frequency);
+        return ESP_ERR_NOT_SUPPORTED;
+      }
+      format_ok = true;
+    } else if (memcmp(chunk, "data", 4) == 0 && format_ok) {
+      *samples = &bytes[pos];
+      *num_samples = chunk_size / sizeof(int16_t);
+      return ESP_OK;
+    }
+    // Chunks are padded to an even size.
+    pos += chunk_size + (chunk_size & 1);
+  }
+
+  ESP_LOGE(__FILE__, "ERROR: No audio data found in WAV file.");
+  return ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t AddWavAudioSegment(const void* data, size_t size) {
+  const void* samples = NULL;
+  size_t num_samples = 0;
+  esp_err_t ret = ParseWavData(data, size, &samples, &num_samples);
+  if (ret != ESP_OK) {
+    return ret;
+  }
+  return AddPcmAudioSegment(samples, num_samples);
+}
+
+static esp_err_t StartPcm() {
+  segment_index = 0;
+  segment_offset = 0;
+  return ESP_OK;
+}
+
+static esp_err_t ReadPcm(int16_t* samples, size_t num_samples,
+                         size_t* num_read) {
+  *num_read = 0;
+  while (*num_read < num_samples && segment_index < num_segments) {
+    const pcm_segment_t* segment = &segments[segment_index];
+    const size_t count = std::min(num_samples - *num_read,
+                                  segment->num_samples - segment_offset);
+    // All supported targets are little-endian, so the samples can be copied
+    // as they are. memcpy() also takes care of unaligned data.
+    if (segment->data != NULL) {
+      memcpy(&samples[*num_read],
+             &segment->data[segment_offset * sizeof(int16_t)],
+             count * sizeof(int16_t));
+    } else {
+      memset(&samples[*num_read], 0, count * sizeof(int16_t));
+    }
+    *num_read += count;
+    segment_offset += count;
+    if (segment_offset == segment->num_samples) {
+      segment_index++;
+      segment_offset = 0;
+    }
+  }
+  return ESP_OK;
+}
+
+static esp_err_t StopPcm() { return ESP_OK; }
+
+static const audio_source_t pcm_audio_source = {
+    .name = "pcm",
+    .start = StartPcm,
+    .read = ReadPcm,
+    .stop = StopPcm,
+    .paced = false,
+    .channels = 1,
+};
+
+const audio_source_t* GetPcmAudioSource() { return &pcm_audio_source; }
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "audio_source.h"
+
+#include "esp_log.h"
+
+static FILE* stream_file = NULL;
+
+esp_err_t SetStreamAudioFile(FILE* file) {
+  stream_file = file;
+  return ESP_OK;
+}
+
+static esp_err_t StartStream() {
+  if (stream_file == NULL) {
+    ESP_LOGE(__FILE__, "ERROR: In StartStream(). No file set.");
+    return ESP_ERR_INVALID_STATE;
+  }
+  return ESP_OK;
+}
+
+static esp_err_t ReadStream(int16_t* samples, size_t num_samples,
+                            size_t* num_read) {
+  // fread() keeps reading until it has all samples, e.g. from a pipe, so it
+  // only returns less at the end of the stream or on an error. All supported
+  // targets are little-endian, so the samples can be read as they are.
+  *num_read = fread(samples, sizeof(int16_t), num_samples, stream_file);
+  if (*num_read < num_samples && ferror(stream_file)) {
+    ESP_LOGE(__FILE__, "ERROR: In ReadStream() at fread().");
+    return ESP_FAIL;
+  }
+  return ESP_OK;
+}
+
+static esp_err_t StopStream() { return ESP_OK; }
+
+static const audio_source_t stream_audio_source = {
+    .name = "stream",
+    .start = StartStream,
+    .read = ReadStream,
+    .stop = StopStream,
+    .paced = false,
+    .channels = 1,
+};
+
+const audio_source_t* GetStreamAudioSource() { return &stream_audio_source; }
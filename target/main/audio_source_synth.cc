@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "audio_source.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "esp_log.h"
+#include "model_settings.h"
+
+typedef struct {
+  const uint8_t* data;
+  size_t num_samples;
+} synth_clip_t;
+
+// Segments and clips are only added before the source is started, so plain
+// arrays that grow with every entry are good enough.
+static synth_segment_t* segments = NULL;
+static size_t num_segments = 0;
+static synth_clip_t* clips = NULL;
+static size_t num_clips = 0;
+static bool loop_script = false;
+
+static size_t segment_index = 0;
+static size_t segment_offset = 0;
+
+// One period of a sine, indexed by the upper bits of the phase.
+constexpr size_t sine_table_bits = 8;
+static int16_t sine_table[1 << sine_table_bits];
+static uint32_t tone_phase = 0;
+
+static uint32_t noise_state = 0;
+
+// Voss-McCartney pink noise: every row is white noise, but row k only changes
+// every 2^k samples. Their sum falls off by roughly 3 dB per octave.
+constexpr size_t pink_rows = 8;
+static int16_t pink_row_values[pink_rows];
+static uint32_t pink_counter = 0;
+
+static size_t GetSegmentSamples(const synth_segment_t* segment) {
+  if (segment->type == SYNTH_CLIP) {
+    return clips[segment->clip].num_samples;
+  }
+  return (size_t)audio_capture_frequency * segment->duration_ms / 1000;
+}
+
+esp_err_t AddSynthAudioSegment(const synth_segment_t* segment) {
+  if (segment->amplitude > INT16_MAX ||
+      (segment->type == SYNTH_CLIP && segment->clip >= num_clips) ||
+      GetSegmentSamples(segment) == 0) {
+    ESP_LOGE(__FILE__, "ERROR: In AddSynthAudioSegment(). Invalid segment.");
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  synth_segment_t* new_segments = (synth_segment_t*)realloc(
+      segments, (num_segments + 1) * sizeof(synth_segment_t));
+  if (new_segments == NULL) {
+    ESP_LOGE(__FILE__, "ERROR: In AddSynthAudioSegment() at realloc().");
+    return ESP_ERR_NO_MEM;
+  }
+  segments = new_segments;
+  segments[num_segments] = *segment;
+  num_segments++;
+  return ESP_OK;
+}
+
+esp_err_t AddSynthAudioClip(const void* data, size_t num_samples) {
+  synth_clip_t* new_clips =
+      (synth_clip_t*)realloc(clips, (num_clips + 1) * sizeof(synth_clip_t));
+  if (new_clips == NULL) {
+    ESP_LOGE(__FILE__, "ERROR: In AddSynthAudioClip() at realloc().");
+    return ESP_ERR_NO_MEM;
+  }
+  clips = new_clips;
+  clips[num_clips].data = (const uint8_t*)data;
+  clips[num_clips].num_samples = num_samples;
+  num_clips++;
+  return ESP_OK;
+}
+
+esp_err_t SetSynthAudioLoop(bool loop) {
+  loop_script = loop;
+  return ESP_OK;
+}
+
+// Reads the next number of a script segment, which has to follow a ':'.
+static bool ParseScriptNumber(const char** pos, uint32_t* value) {
+  if (**pos != ':') {
+    return false;
+  }
+  char* end = NULL;
+  *value = strtoul(*pos + 1, &end, 10);
+  if (end == *pos + 1) {
+    return false;
+  }
+  *pos = end;
+  return true;
+}
+
+esp_err_t ParseSynthAudioScript(const char* script) {
+  const char* pos = script;
+  while (*pos != '\0') {
+    const char* name = pos;
+    while (*pos != ':' && *pos != ',' && *pos != '\0') {
+      pos++;
+    }
+    const size_t name_length = pos - name;
+
+    synth_segment_t segment = {};
+    bool ok = false;
+    if (name_length == 7 && strncmp(name, "silence", 7) == 0) {
+      segment.type = SYNTH_SILENCE;
+      ok = ParseScriptNumber(&pos, &segment.duration_ms);
+    } else if (name_length == 4 && strncmp(name, "tone", 4) == 0) {
+      segment.type = SYNTH_TONE;
+      ok = ParseScriptNumber(&pos, &segment.duration_ms) &&
+           ParseScriptNumber(&pos, &segment.frequency_hz) &&
+           ParseScriptNumber(&pos, &segment.amplitude);
+    } else if (name_length == 5 && strncmp(name, "white", 5) == 0) {
+      segment.type = SYNTH_WHITE_NOISE;
+      ok = ParseScriptNumber(&pos, &segment.duration_ms) &&
+           ParseScriptNumber(&pos, &segment.amplitude);
+    } else if (name_length == 4 && strncmp(name, "pink", 4) == 0) {
+      segment.type = SYNTH_PINK_NOISE;
+      ok = ParseScriptNumber(&pos, &segment.duration_ms) &&
+           ParseScriptNumber(&pos, &segment.amplitude);
+    } else if (name_length == 4 && strncmp(name, "clip", 4) == 0) {
+      segment.type = SYNTH_CLIP;
+      ok = ParseScriptNumber(&pos, &segment.clip) &&
+           (*pos != ':' || ParseScriptNumber(&pos, &segment.amplitude));
+    }
+    if (!ok || (*pos != ',' && *pos != '\0')) {
+      ESP_LOGE(__FILE__, "ERROR: Invalid synthetic audio script at \"%s\".",
+               name);
+      return ESP_ERR_INVALID_ARG;
+    }
+    if (*pos == ',') {
+      pos++;
+    }
+
+    esp_err_t ret = AddSynthAudioSegment(&segment);
+    if (ret != ESP_OK) {
+      return ret;
+    }
+  }
+  return ESP_OK;
+}
+
+// xorshift32, good enough for test signals and the same on every platform.
+static int16_t NextNoise() {
+  noise_state ^= noise_state << 13;
+  noise_state ^= noise_state >> 17;
+  noise_state ^= noise_state << 5;
+  return (int16_t)(noise_state >> 16);
+}
+
+static int32_t Scale(int32_t value, uint32_t amplitude) {
+  return value * (int32_t)amplitude / 32768;
+}
+
+static int16_t NextPinkNoise() {
+  pink_counter++;
+  // Row k changes whenever bit k of the counter flips from 0 to 1, which
+  // happens for exactly one row per sample.
+  const size_t row = __builtin_ctz(pink_counter) % pink_rows;
+  pink_row_values[row] = NextNoise();
+
+  int32_t sum = NextNoise();
+  for (size_t i = 0; i < pink_rows; i++) {
+    sum += pink_row_values[i];
+  }
+  return (int16_t)(sum / (int32_t)(pink_rows + 1));
+}
+
+static int16_t NextSample(const synth_segment_t* segment, size_t offset,
+                          uint32_t tone_step) {
+  switch (segment->type) {
+    case SYNTH_TONE: {
+      const int32_t value = sine_table[tone_phase >> (32 - sine_table_bits)];
+      tone_phase += tone_step;
+      return (int16_t)Scale(value, segment->amplitude);
+    }
+    case SYNTH_WHITE_NOISE:
+      return (int16_t)Scale(NextNoise(), segment->amplitude);
+    case SYNTH_PINK_NOISE:
+      return (int16_t)Scale(NextPinkNoise(), segment->amplitude);
+    case SYNTH_CLIP: {
+      int16_t sample;
+      memcpy(&sample, &clips[segment->clip].data[offset * sizeof(int16_t)],
+             sizeof(sample));
+      const int32_t value = sample + Scale(NextNoise(), segment->amplitude);
+      return (int16_t)std::min(std::max(value, (int32_t)INT16_MIN),
+                               (int32_t)INT16_MAX);
+    }
+    case SYNTH_SILENCE:
+    default:
+      return 0;
+  }
+}
+
+static esp_err_t StartSynth() {
+  for (size_t i = 0; i < sizeof(sine_table) / sizeof(sine_table[0]); i++) {
+    sine_table[i] = (int16_t)lrintf(
+        32767.0f * sinf(2.0f * (float)M_PI * i / (1 << sine_table_bits)));
+  }
+  tone_phase = 0;
+  noise_state = 0x12345678;
+  memset(pink_row_values, 0, sizeof(pink_row_values));
+  pink_counter = 0;
+  segment_index = 0;
+  segment_offset = 0;
+  return ESP_OK;
+}
+
+static esp_err_t ReadSynth(int16_t* samples, size_t num_samples,
+                           size_t* num_read) {
+  *num_read = 0;
+  while (*num_read < num_samples) {
+    if (segment_index == num_segments) {
+      if (!loop_script || num_segments == 0) {
+        break;
+      }
+      segment_index = 0;
+    }
+    const synth_segment_t* segment = &segments[segment_index];
+    const size_t segment_samples = GetSegmentSamples(segment);
+    const size_t count =
+        std::min(num_samples - *num_read, segment_samples - segment_offset);
+    // Phase increment per sample, with the full circle being 2^32.
+    const uint32_t tone_step = (uint32_t)(
+        ((uint64_t)segment->frequency_hz << 32) / audio_capture_frequency);
+    for (size_t i = 0; i < count; i++) {
+      samples[*num_read + i] =
+          NextSample(segment, segment_offset + i, tone_step);
+    }
+    *num_read += count;
+    segment_offset += count;
+    if (segment_offset == segment_samples) {
+      segment_index++;
+      segment_offset = 0;
+    }
+  }
+  return ESP_OK;
+}
+
+static esp_err_t StopSynth() { return ESP_OK; }
+
+static const audio_source_t synth_audio_source = {
+    .name = "synth",
+    .start = StartSynth,
+    .read = ReadSynth,
+    .stop = StopSynth,
+    .paced = false,
+    .channels = 1,
+};
+
+const audio_source_t* GetSynthAudioSource() { return &synth_audio_source; }
@@ -20,6 +20,8 @@
 
 #include "backend.h"
 
+#include <algorithm>
+#include <cinttypes>
 #include <cmath>
 #include <cstdio>
 #include <cstring>
@@ -28,6 +30,7 @@
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "gpio.h"
+#include "keyword_audio.h"
 #include "model_settings.h"
 
 // TODO(fabianpedd): In order to improve the detection accuracy we could
@@ -37,15 +40,24 @@
 // would help to supress detections where the NN is unsure about two categories.
 // However, this might lead to worse detection sensitivity.
 
-// TODO(fabianpedd): Make threshold (or better history length) independent from
-// inference performance / inferences per second.
+// The posterior history covers a fixed time span, namely the time
+// CONFIG_MICRO_KWS_POSTERIOR_HISTORY_LENGTH inferences take at the maximum
+// rate. Every posterior is weighted with the time since the previous one, up
+// to the whole span, so the detections do not depend on the current inference
+// rate. At a constant rate this is the same as a plain sum over the last
+// posterior_history_length posteriors.
 constexpr size_t posterior_supression_ms =
     CONFIG_MICRO_KWS_POSTERIOR_SUPRESSION_MS;
 constexpr size_t posterior_history_length =
     CONFIG_MICRO_KWS_POSTERIOR_HISTORY_LENGTH;
-constexpr size_t posterior_trigger_threshold =
-    CONFIG_MICRO_KWS_POSTERIOR_TRIGGER_THRESHOLD_SINGLE *
-    CONFIG_MICRO_KWS_POSTERIOR_HISTORY_LENGTH;
+constexpr uint32_t default_posterior_interval_ms =
+    1000 / CONFIG_MICRO_KWS_MAX_RATE > 0 ? 1000 / CONFIG_MICRO_KWS_MAX_RATE : 1;
+constexpr uint32_t posterior_history_ms =
+    posterior_history_length * default_posterior_interval_ms;
+constexpr uint32_t posterior_trigger_threshold =
+    CONFIG_MICRO_KWS_POSTERIOR_TRIGGER_THRESHOLD_SINGLE * posterior_history_ms;
+
+static uint32_t posterior_interval_ms = default_posterior_interval_ms;
 
 esp_err_t KeywordCallback(const char* category) {
   /****************************************************************************/
@@ -105,26 +117,92 @@ esp_err_t KeywordCallback(const char* category) {
   return ESP_OK;
 }
 
+esp_err_t KeywordAudioCallback(const char* category, uint64_t start_index,
+                               const audio_span_t spans[2]) {
+  // The audio could be passed on to a recognizer for the words after the
+  // keyword, or be logged to find the cause of false detections. For now, only
+  // report where it is in the audio stream.
+  const size_t num_samples = spans[0].num_samples + spans[1].num_samples;
+  printf("Keyword audio: %s, %" PRIu32 " ms from %.3fs\n", category,
+         (uint32_t)(num_samples * 1000 / audio_sample_frequency),
+         (double)start_index / audio_sample_frequency);
+  return ESP_OK;
+}
+
+esp_err_t SetPosteriorInterval(uint32_t interval_ms) {
+  if (interval_ms == 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  posterior_interval_ms = interval_ms;
+  return ESP_OK;
+}
+
+esp_err_t FusePosteriors(
+    const uint8_t channel_posteriors[audio_channels][category_count],
+    uint8_t fused_posteriors[category_count]) {
+  for (size_t i = 0; i < category_count; i++) {
+    uint32_t sum = 0;
+    for (size_t channel = 0; channel < audio_channels; channel++) {
+      sum += channel_posteriors[channel][i];
+    }
+    fused_posteriors[i] = (sum + audio_channels / 2) / audio_channels;
+  }
+  return ESP_OK;
+}
+
 esp_err_t HandlePosteriors(uint8_t new_posteriors[category_count],
                            size_t* top_category_index) {
   // A 'posterior_history_length x category_count' matrix of past posteriors.
   static uint8_t posterior_history[posterior_history_length][category_count] = {
       0};
-  // For efficiency reasons we keep an accumulator (transforms the problem of
-  // calculating the top category from O(posterior_history_length) to O(2) for
-  // each category).
+  // The time in ms each entry of the history stands for.
+  static uint32_t posterior_history_interval_ms[posterior_history_length] = {0};
+  // For efficiency reasons we keep an accumulator of the weighted posteriors
+  // (transforms the problem of calculating the top category from
+  // O(posterior_history_length) to O(2) for each category).
   static uint32_t posterior_accumulator[category_count] = {0};
+  // Slot for the next entry and number of valid entries before it.
   static size_t posterior_history_pointer = 0;
+  static size_t posterior_history_count = 0;
+  // Sum of the intervals of all valid entries.
+  static uint32_t posterior_history_span_ms = 0;
+
+  // Drop the oldest entries until there is room for the new one, both in the
+  // history and in its time span.
+  while (posterior_history_count > 0 &&
+         (posterior_history_count >= posterior_history_length ||
+          posterior_history_span_ms + posterior_interval_ms >
+              posterior_history_ms)) {
+    const size_t oldest =
+        (posterior_history_pointer + posterior_history_length -
+         posterior_history_count) %
+        posterior_history_length;
+    for (size_t i = 0; i < category_count; i++) {
+      posterior_accumulator[i] -= posterior_history[oldest][i] *
+                                  posterior_history_interval_ms[oldest];
+    }
+    posterior_history_span_ms -= posterior_history_interval_ms[oldest];
+    posterior_history_count--;
+  }
+
+  // An interval longer than the history, i.e. a rate below
+  // 1000 / posterior_history_ms, has dropped all other entries. The new entry
+  // then stands for the whole history, rather than outweighing a full history
+  // of posteriors on its own.
+  const uint32_t weight_ms = std::min(
+      posterior_interval_ms, posterior_history_ms - posterior_history_span_ms);
+
+  // Add the new posteriors and look for the top category.
   size_t top_canidate_index = 0;
-  // Iterate over all category values in posterior_history and replace with new
-  // posteriors.
   for (size_t i = 0; i < category_count; i++) {
-    posterior_accumulator[i] -= posterior_history[posterior_history_pointer][i];
-    posterior_accumulator[i] += new_posteriors[i];
+    posterior_accumulator[i] += new_posteriors[i] * weight_ms;
     posterior_history[posterior_history_pointer][i] = new_posteriors[i];
     if (posterior_accumulator[i] > posterior_accumulator[top_canidate_index])
       top_canidate_index = i;
   }
+  posterior_history_interval_ms[posterior_history_pointer] = weight_ms;
+  posterior_history_span_ms += weight_ms;
+  posterior_history_count++;
   // Bump posterior history pointer and handle wraparound.
   if (++posterior_history_pointer >= posterior_history_length)
     posterior_history_pointer = 0;
@@ -144,6 +222,10 @@ esp_err_t HandlePosteriors(uint8_t new_posteriors[category_count],
            top_posterior_ms + posterior_supression_ms)) {
     top_posterior_index = top_canidate_index;
     top_posterior_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    // The first category is silence, which has no audio worth keeping.
+    if (top_posterior_index > 0) {
+      HoldKeywordAudio(category_labels[top_posterior_index]);
+    }
     KeywordCallback(category_labels[top_posterior_index]);
   }
   *top_category_index = top_posterior_index;
@@ -21,11 +21,24 @@
 #ifndef BACKEND_H
 #define BACKEND_H
 
+#include <cstddef>
 #include <cstdint>
 
 #include "esp_err.h"
 #include "model_settings.h"
 
+// Tells the posterior handler how much time the next posteriors stand for,
+// i.e. the time since the last ones. Applies to all following posteriors.
+esp_err_t SetPosteriorInterval(uint32_t interval_ms);
+
+// Combines the posteriors of the audio_channels channels, which each have
+// their own model run, into one set of posteriors for HandlePosteriors(). The
+// posteriors are averaged, so a keyword heard clearly by one microphone still
+// counts with half of its weight.
+esp_err_t FusePosteriors(
+    const uint8_t channel_posteriors[audio_channels][category_count],
+    uint8_t fused_posteriors[category_count]);
+
 esp_err_t HandlePosteriors(uint8_t new_posteriors[category_count],
                            size_t* top_category_index);
 
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "beamformer.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+
+#include "esp_log.h"
+
+esp_err_t InitializeBeamformer(beamformer_t* beamformer, int32_t delay) {
+  if (delay < -max_beamformer_delay || delay > max_beamformer_delay) {
+    ESP_LOGE(__FILE__, "ERROR: In InitializeBeamformer(). Invalid arguments.");
+    return ESP_ERR_INVALID_ARG;
+  }
+  // If the sound reaches the second channel later, the first one has to wait
+  // for it, and vice versa.
+  const uint32_t magnitude = std::abs(delay);
+  beamformer->delayed_channel = delay >= 0 ? 0 : 1;
+  beamformer->delay_samples = magnitude >> beamformer_delay_fraction_bits;
+  beamformer->delay_fraction =
+      magnitude & ((1 << beamformer_delay_fraction_bits) - 1);
+  return ResetBeamformer(beamformer);
+}
+
+esp_err_t ResetBeamformer(beamformer_t* beamformer) {
+  std::fill(std::begin(beamformer->history), std::end(beamformer->history), 0);
+  return ESP_OK;
+}
+
+void Beamform(beamformer_t* beamformer, const int16_t* __restrict input,
+              size_t num_frames, int16_t* __restrict output) {
+  const size_t delayed = beamformer->delayed_channel;
+  const size_t other = 1 - delayed;
+  const size_t delay = beamformer->delay_samples;
+  const size_t lag = delay + 1;
+  int16_t* history = beamformer->history;
+
+  // The delayed sample is interpolated between the samples `delay` and
+  // `delay + 1` ago. Weighting the other channel with 1 as well, the sum is
+  // twice the average with beamformer_delay_fraction_bits fraction bits.
+  constexpr int32_t one = 1 << beamformer_delay_fraction_bits;
+  constexpr int32_t shift = beamformer_delay_fraction_bits + 1;
+  constexpr int32_t round = 1 << (shift - 1);
+  const int32_t newer_weight = one - beamformer->delay_fraction;
+  const int32_t older_weight = beamformer->delay_fraction;
+
+  // Sample `index` of the delayed channel, counted from the start of the
+  // input. The `lag` samples before the input are taken from the history.
+  auto delayed_sample = [&](ptrdiff_t index) -> int32_t {
+    return index < 0 ? history[lag + index] : input[2 * index + delayed];
+  };
+
+  // The first `lag` frames still need samples from the history.
+  const size_t head = std::min(num_frames, lag);
+  for (size_t i = 0; i < head; i++) {
+    const ptrdiff_t index = (ptrdiff_t)i - (ptrdiff_t)delay;
+    const int32_t sum = input[2 * i + other] * one +
+                        delayed_sample(index) * newer_weight +
+                        delayed_sample(index - 1) * older_weight;
+    output[i] = (int16_t)((sum + round) >> shift);
+  }
+  // Afterwards, both samples of the delayed channel are part of the input.
+  for (size_t i = head; i < num_frames; i++) {
+    const int32_t sum = input[2 * i + other] * one +
+                        input[2 * (i - delay) + delayed] * newer_weight +
+                        input[2 * (i - lag) + delayed] * older_weight;
+    output[i] = (int16_t)((sum + round) >> shift);
+  }
+
+  // Keep the last `lag` samples of the delayed channel for the next call. If
+  // some of them come from the history itself, they are read from further back
+  // than they are written to, so this works in place.
+  for (size_t i = 0; i < lag; i++) {
+    history[i] = delayed_sample((ptrdiff_t)(num_frames + i) - (ptrdiff_t)lag);
+  }
+}
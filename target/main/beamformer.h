@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BEAMFORMER_H
+#define BEAMFORMER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+
+// Fixed-point delay-and-sum beamformer for two microphones. The channel that a
+// sound from the steered direction reaches first is delayed by the steering
+// delay, so that the sound lines up in both channels, and the channels are
+// averaged. Sound from the steered direction keeps its level, sound from other
+// directions partly cancels out and uncorrelated noise, like the self-noise of
+// the microphones, drops by 3 dB.
+//
+// The delay is given in 1/16 of a sample. Fractions of a sample are linearly
+// interpolated between the two neighbouring samples.
+constexpr int32_t beamformer_delay_fraction_bits = 4;
+constexpr int32_t max_beamformer_delay_samples = 8;
+constexpr int32_t max_beamformer_delay = max_beamformer_delay_samples
+                                         << beamformer_delay_fraction_bits;
+
+typedef struct {
+  // Channel which is delayed, and its delay in whole samples and in 1/16 of a
+  // sample.
+  uint32_t delayed_channel;
+  uint32_t delay_samples;
+  int32_t delay_fraction;
+  // The last delay_samples + 1 samples of the delayed channel, from the oldest
+  // to the newest one.
+  int16_t history[max_beamformer_delay_samples + 1];
+} beamformer_t;
+
+// Sets the steering delay, i.e. how many 1/16 samples later a sound from the
+// steered direction reaches the second channel than the first one, from
+// -max_beamformer_delay to max_beamformer_delay. Resets the filter state.
+esp_err_t InitializeBeamformer(beamformer_t* beamformer, int32_t delay);
+
+// Forgets all previous samples.
+esp_err_t ResetBeamformer(beamformer_t* beamformer);
+
+// Combines `num_frames` interleaved stereo frames from `input` into
+// `num_frames` mono samples in `output`. The result never exceeds the range of
+// the input, so there is no need to saturate.
+void Beamform(beamformer_t* beamformer, const int16_t* input,
+              size_t num_frames, int16_t* output);
+
+#endif  // BEAMFORMER_H
@@ -24,12 +24,14 @@
 
 #include <cstring>
 
+#include "adpcm.h"
 #include "audio.h"
 #include "driver/uart.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "freertos/task.h"
 #include "gpio.h"
+#include "memory_report.h"
 #include "model_settings.h"
 
 // TODO(fabianpedd): If we had two cores, like on the ESP32, we could run the
@@ -49,9 +51,26 @@
 #define UART_TX_PIN 21  // default is pin 21 (or pin 7 for external)
 #define UART_RX_PIN UART_PIN_NO_CHANGE  // 20
 
-#ifdef CONFIG_MICRO_KWS_MODE_DEBUG
+// Both debug modes send their packets to the host through the DebugWorker()
+// task.
+#if defined(CONFIG_MICRO_KWS_MODE_DEBUG) || \
+    defined(CONFIG_MICRO_KWS_MODE_DEBUG_AUDIO)
+#define DEBUG_UART 1
+#endif  // CONFIG_MICRO_KWS_MODE_DEBUG || CONFIG_MICRO_KWS_MODE_DEBUG_AUDIO
+
+#ifdef DEBUG_UART
 static RingbufHandle_t buf_handle = NULL;
-#endif  // CONFIG_MICRO_KWS_MODE_DEBUG
+#endif  // DEBUG_UART
+
+// The audio packets are larger than the feature windows.
+#ifndef CONFIG_MICRO_KWS_MODE_DEBUG_AUDIO
+constexpr size_t debug_buffer_size = 1024 * 16;
+constexpr size_t debug_worker_stack_size = 1024 * 16;
+#else   // CONFIG_MICRO_KWS_MODE_DEBUG_AUDIO
+constexpr size_t debug_buffer_size = 1024 * 32;
+constexpr size_t debug_worker_stack_size = 1024 * 32;
+#endif  // CONFIG_MICRO_KWS_MODE_DEBUG_AUDIO
+constexpr size_t debug_print_stats_stack_size = 1024 * 4;
 
 static TaskHandle_t DebugWorkerHandle = NULL;
 
@@ -60,12 +79,14 @@ typedef struct __attribute__((packed)) {
   int8_t feature_data[feature_element_count];
   uint8_t category_data[category_count];
   uint8_t top_category_index;
+#elif defined(CONFIG_MICRO_KWS_DEBUG_AUDIO_STREAM)
+  audio_stream_packet_t audio_stream_packet;
 #else   // CONFIG_MICRO_KWS_MODE_DEBUG_AUDIO
   uint8_t audio_data[AUDIO_PACKET_SIZE];
 #endif  // CONFIG_MICRO_KWS_MODE_DEBUG_AUDIO
 } debug_data_t;
 
-#ifdef CONFIG_MICRO_KWS_MODE_DEBUG
+#ifdef DEBUG_UART
 static void DebugWorker(void* arg) {
   while (true) {
     size_t item_size = 0;
@@ -125,7 +146,7 @@ static void DebugWorker(void* arg) {
     // }
   }
 }
-#endif  // CONFIG_MICRO_KWS_MODE_DEBUG
+#endif  // DEBUG_UART
 
 #ifdef CONFIG_MICRO_KWS_PRINT_STATS
 static void DebugPrintStats(void* arg) {
@@ -143,7 +164,7 @@ static void DebugPrintStats(void* arg) {
 #endif  // CONFIG_MICRO_KWS_PRINT_STATS
 
 esp_err_t InitializeDebug() {
-#ifdef CONFIG_MICRO_KWS_MODE_DEBUG
+#ifdef DEBUG_UART
   uart_config_t uart_config = {
       .baud_rate = (int)UART_BAUDRATE,
       .data_bits = UART_DATA_8_BITS,
@@ -169,36 +190,32 @@ esp_err_t InitializeDebug() {
     return ESP_FAIL;
   }
 
-#ifndef CONFIG_MICRO_KWS_MODE_DEBUG_AUDIO
-  buf_handle = xRingbufferCreate(1024 * 16, RINGBUF_TYPE_NOSPLIT);
-#else   // CONFIG_MICRO_KWS_MODE_DEBUG_AUDIO
-  buf_handle = xRingbufferCreate(1024 * 32, RINGBUF_TYPE_NOSPLIT);
-#endif  // CONFIG_MICRO_KWS_MODE_DEBUG_AUDIO
+  buf_handle = xRingbufferCreate(debug_buffer_size, RINGBUF_TYPE_NOSPLIT);
   if (buf_handle == NULL) {
     ESP_LOGE(__FILE__, "ERROR: In xRingbufferCreate() in DebugInit().");
     return ESP_FAIL;
   }
+  AddMemoryRingbuffer(buf_handle, "debug", debug_buffer_size);
 
-#ifndef CONFIG_MICRO_KWS_MODE_DEBUG_AUDIO
-  if (xTaskCreate(DebugWorker, "DebugWorker", 1024 * 16, NULL, 10,
-                  &DebugWorkerHandle) !=
-#else   // CONFIG_MICRO_KWS_MODE_DEBUG_AUDIO
-  if (xTaskCreate(DebugWorker, "DebugWorker", 1024 * 32, NULL, 10,
-                  &DebugWorkerHandle) !=
-#endif  // CONFIG_MICRO_KWS_MODE_DEBUG_AUDIO
-      pdPASS) {
+  if (xTaskCreate(DebugWorker, "DebugWorker", debug_worker_stack_size, NULL,
+                  10, &DebugWorkerHandle) != pdPASS) {
     ESP_LOGE(__FILE__, "ERROR: In xTaskCreate(DebugWorker) in DebugInit().");
     return ESP_FAIL;
   }
-#endif  // CONFIG_MICRO_KWS_MODE_DEBUG
+  AddMemoryTask(DebugWorkerHandle, "DebugWorker", debug_worker_stack_size);
+#endif  // DEBUG_UART
 
 #ifdef CONFIG_MICRO_KWS_PRINT_STATS
-  if (xTaskCreate(DebugPrintStats, "DebugPrintStats", 1024 * 4, NULL, 10,
-                  NULL) != pdPASS) {
+  TaskHandle_t print_stats_handle = NULL;
+  if (xTaskCreate(DebugPrintStats, "DebugPrintStats",
+                  debug_print_stats_stack_size, NULL, 10,
+                  &print_stats_handle) != pdPASS) {
     ESP_LOGE(__FILE__,
              "ERROR: In xTaskCreate(DebugPrintStats) in DebugInit().");
     return ESP_FAIL;
   }
+  AddMemoryTask(print_stats_handle, "DebugPrintStats",
+                debug_print_stats_stack_size);
 #endif  // CONFIG_MICRO_KWS_MODE_DEBUG
 
   return ESP_OK;
@@ -211,7 +228,7 @@ esp_err_t StopDebug() {
 }
 
 #ifndef CONFIG_MICRO_KWS_MODE_DEBUG_AUDIO
-esp_err_t DebugRun(int8_t* feature_data, uint8_t* category_data,
+esp_err_t DebugRun(const int8_t* feature_data, uint8_t* category_data,
                    uint8_t top_category_index) {
 #ifdef CONFIG_MICRO_KWS_PRINT_OUTPUTS
   for (size_t i = 0; i < category_count; i++) {
@@ -236,9 +253,12 @@ esp_err_t DebugRun(int8_t* feature_data, uint8_t* category_data,
   printf("Δ%dms", delta_time);
   last_time = this_time;
 #endif  // CONFIG_MICRO_KWS_PRINT_TIME
-#ifdef CONFIG_MICRO_KWS_MODE_DEFAULT
+#if defined(CONFIG_MICRO_KWS_MODE_DEFAULT) &&   \
+    (defined(CONFIG_MICRO_KWS_PRINT_OUTPUTS) || \
+     defined(CONFIG_MICRO_KWS_PRINT_TIME))
   printf("\n");
-#endif // CONFIG_MICRO_KWS_MODE_DEFAULT
+#endif  // CONFIG_MICRO_KWS_MODE_DEFAULT && (CONFIG_MICRO_KWS_PRINT_OUTPUTS ||
+        // CONFIG_MICRO_KWS_PRINT_TIME)
 
 #ifdef CONFIG_MICRO_KWS_MODE_DEBUG
   debug_data_t debug_data;
@@ -254,12 +274,13 @@ esp_err_t DebugRun(int8_t* feature_data, uint8_t* category_data,
              "running and reading enough to keep the Ringbuffer empty.");
     return ESP_FAIL;
   }
+  UpdateMemoryRingbufferPeak(buf_handle);
 #endif  // CONFIG_MICRO_KWS_MODE_DEBUG
 
   return ESP_OK;
 }
 
-#else   // CONFIG_MICRO_KWS_MODE_DEBUG_AUDIO
+#elif !defined(CONFIG_MICRO_KWS_DEBUG_AUDIO_STREAM)
 
 esp_err_t DebugRunAudio(int8_t* audio_data) {
   // TODO(fabianpedd): Switch these over to 32bit
@@ -280,11 +301,71 @@ esp_err_t DebugRunAudio(int8_t* audio_data) {
              "likely the Ringbuffer is full.");
     return ESP_FAIL;
   }
+  UpdateMemoryRingbufferPeak(buf_handle);
   printf("Sent %d bytes via xRingbufferSend() in DebugRunAudio().\n",
          sizeof(debug_data));
 
   return ESP_OK;
 }
+
+#else   // CONFIG_MICRO_KWS_DEBUG_AUDIO_STREAM
+
+// Sends the audio continuously in packets of AUDIO_STREAM_PACKET_SAMPLES
+// samples, see audio_stream_packet_t. Only returns after an error.
+static esp_err_t StreamAudio() {
+  adpcm_state_t adpcm_state;
+  ResetAdpcm(&adpcm_state);
+  uint16_t sequence = 0;
+
+  while (true) {
+    if (WaitForAudioData(AUDIO_STREAM_PACKET_SAMPLES * sizeof(int16_t),
+                         portMAX_DELAY) != ESP_OK) {
+      ESP_LOGE(__FILE__, "ERROR: In WaitForAudioData() in StreamAudio().");
+      return ESP_FAIL;
+    }
+
+    debug_data_t debug_data;
+    audio_stream_packet_t* packet = &debug_data.audio_stream_packet;
+    packet->sequence = sequence++;
+    packet->predictor = adpcm_state.predictor;
+    packet->step_index = adpcm_state.step_index;
+    packet->reserved = 0;
+
+    // Encode the samples straight from the audio queue. Samples lost on the
+    // device are encoded as the silence that AudioPeek() returns for them, so
+    // the sample index of the packets always continues.
+    size_t num_samples = 0;
+    while (num_samples < AUDIO_STREAM_PACKET_SAMPLES) {
+      audio_span_t spans[2];
+      audio_position_t position;
+      AudioPeek(1, spans, &position);
+      if (spans[0].num_samples == 0) {
+        ESP_LOGE(__FILE__, "ERROR: In AudioPeek() in StreamAudio().");
+        return ESP_FAIL;
+      }
+      if (num_samples == 0) {
+        packet->sample_index = (uint32_t)position.sample_index;
+      }
+      size_t num_taken = 0;
+      for (const audio_span_t& span : spans) {
+        const size_t count =
+            MIN(span.num_samples, AUDIO_STREAM_PACKET_SAMPLES - num_samples);
+        EncodeAdpcm(&adpcm_state, span.samples, count, packet->data,
+                    num_samples);
+        num_samples += count;
+        num_taken += count;
+      }
+      AudioCommit(num_taken);
+    }
+
+    // Never wait for the UART, the audio queue would overrun instead. A
+    // dropped packet shows up as a gap in the sequence numbers on the host.
+    if (xRingbufferSend(buf_handle, (void*)&debug_data, sizeof(debug_data),
+                        0) == pdTRUE) {
+      UpdateMemoryRingbufferPeak(buf_handle);
+    }
+  }
+}
 #endif  // CONFIG_MICRO_KWS_MODE_DEBUG_AUDIO
 
 void micro_audio(void* params) {
@@ -312,6 +393,21 @@ void micro_audio(void* params) {
   // Set RGB to orange in order to indicate get ready
   SetLEDColor(LED_RGB_ORANGE);
 
+#ifdef CONFIG_MICRO_KWS_DEBUG_AUDIO_STREAM
+  // The debug driver is needed right away, as the audio is sent while it is
+  // being recorded.
+  if (InitializeDebug() != ESP_OK) {
+    ESP_LOGE(__FILE__, "ERROR: In InitializeDebug().");
+    return;
+  }
+
+  // Set RGB to red in order to indicate the running stream.
+  SetLEDColor(LED_RGB_RED);
+  if (StreamAudio() != ESP_OK) {
+    ESP_LOGE(__FILE__, "ERROR: In StreamAudio().");
+    return;
+  }
+#else   // CONFIG_MICRO_KWS_DEBUG_AUDIO_STREAM
   // Large array that holds the complete audio sample.
   int8_t i2s_read_buffer[AUDIO_SAMPLE_SIZE] = {0};
   size_t actual_bytes_read = 0;
@@ -320,8 +416,8 @@ void micro_audio(void* params) {
   uint32_t start_time = (uint32_t)(esp_timer_get_time() / 1000);
   do {
     vTaskDelay(pdMS_TO_TICKS(10));
-    if (GetAudioData(2 * 16 * 200, &actual_bytes_read, i2s_read_buffer) !=
-        ESP_OK) {
+    if (GetAudioData(2 * AUDIO_SAMPLES_PER_MS * 200, &actual_bytes_read,
+                     i2s_read_buffer) != ESP_OK) {
       ESP_LOGE(__FILE__, "ERROR: In GetAudioData().");
       return;
     } else if (actual_bytes_read > 0) {
@@ -339,10 +435,15 @@ void micro_audio(void* params) {
   size_t total_bytes_read = 0;
   actual_bytes_read = 0;
   for (;;) {
-    if (GetAudioData(
-            MIN(AUDIO_PACKET_SIZE, AUDIO_SAMPLE_SIZE - total_bytes_read),
-            &actual_bytes_read,
-            &(i2s_read_buffer[total_bytes_read])) != ESP_OK) {
+    // Sleep until the next packet has been captured.
+    const size_t packet_size =
+        MIN(AUDIO_PACKET_SIZE, AUDIO_SAMPLE_SIZE - total_bytes_read);
+    if (WaitForAudioData(packet_size, portMAX_DELAY) != ESP_OK) {
+      ESP_LOGE(__FILE__, "ERROR: In WaitForAudioData().");
+      return;
+    }
+    if (GetAudioData(packet_size, &actual_bytes_read,
+                     &(i2s_read_buffer[total_bytes_read])) != ESP_OK) {
       ESP_LOGE(__FILE__, "ERROR: In GetAudioData().");
       return;
     }
@@ -365,8 +466,6 @@ void micro_audio(void* params) {
                total_bytes_read, AUDIO_SAMPLE_SIZE);
       return;
     }
-
-    vTaskDelay(pdMS_TO_TICKS(10));
   }
 
   // Stop the I2S audio driver.
@@ -407,4 +506,5 @@ void micro_audio(void* params) {
   while (true) {
     vTaskDelay(pdMS_TO_TICKS(100));
   }
+#endif  // CONFIG_MICRO_KWS_DEBUG_AUDIO_STREAM
 }
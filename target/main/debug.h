@@ -24,21 +24,47 @@
 #include <cstdint>
 
 #include "esp_err.h"
+#include "model_settings.h"
 
 // These parameters are relevant for the MICRO_KWS_MICROPHONE_DEBUG_MODE...
 
 // If you incease this you probably also need to increase the micro_audio stack
 // stack size.
 #define AUDIO_SAMPLE_MS 2000
-// 16bit audio @ 16kHz sample rate.
-#define AUDIO_SAMPLE_SIZE (2 * 16 * AUDIO_SAMPLE_MS)
-// 16bit audio @ 16kHz sample rate.
-#define AUDIO_PACKET_SIZE (2 * 16 * 100)  // Sending 100ms at once to host PC
+// Samples per ms, 16 at 16kHz sample rate and 8 in the low power mode.
+#define AUDIO_SAMPLES_PER_MS (audio_sample_frequency / 1000)
+// 16bit audio @ 16kHz (or 8kHz) sample rate.
+#define AUDIO_SAMPLE_SIZE (2 * AUDIO_SAMPLES_PER_MS * AUDIO_SAMPLE_MS)
+// 16bit audio @ 16kHz (or 8kHz) sample rate.
+#define AUDIO_PACKET_SIZE \
+  (2 * AUDIO_SAMPLES_PER_MS * 100)  // Sending 100ms at once to host PC
+
+// With CONFIG_MICRO_KWS_DEBUG_AUDIO_STREAM the audio is instead sent
+// continuously, compressed with IMA ADPCM (see adpcm.h), in packets of 100ms.
+#define AUDIO_STREAM_PACKET_MS 100
+#define AUDIO_STREAM_PACKET_SAMPLES \
+  (AUDIO_SAMPLES_PER_MS * AUDIO_STREAM_PACKET_MS)
+
+// Packet of the continuous audio stream, followed by the usual packet footer.
+// All fields are little-endian.
+typedef struct __attribute__((packed)) {
+  // Counts every packet, including the ones the device had to drop because
+  // the UART could not keep up, so the host can tell how many are missing.
+  uint16_t sequence;
+  // Index of the first sample since the start of the capture, modulo 2^32.
+  uint32_t sample_index;
+  // State of the encoder before the first sample, so every packet can be
+  // decoded on its own.
+  int16_t predictor;
+  uint8_t step_index;
+  uint8_t reserved;
+  uint8_t data[AUDIO_STREAM_PACKET_SAMPLES / 2];
+} audio_stream_packet_t;
 
 #define MIN(a, b) (((a) < (b)) ? (a) : (b))
 #define MAX(a, b) (((a) > (b)) ? (a) : (b))
 
-esp_err_t DebugRun(int8_t* feature_data, uint8_t* category_data,
+esp_err_t DebugRun(const int8_t* feature_data, uint8_t* category_data,
                    uint8_t top_category_index);
 
 esp_err_t InitializeDebug();
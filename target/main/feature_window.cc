@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "feature_window.h"
+
+#include <cstring>
+
+#include "memory_report.h"
+#include "model_settings.h"
+
+// The feature slices are kept in a ringbuffer of feature_slize_count slots,
+// which is stored twice in a row ("mirrored"). Every slot k has a second copy
+// at k + feature_slize_count. This way the last feature_slize_count slices can
+// always be read as one contiguous array starting at the oldest slot, no matter
+// where the write position currently is. The model can therefore use the
+// ringbuffer directly as its input tensor, instead of us having to shift the
+// whole window by one slice and copying it into a separate input buffer for
+// every new slice.
+static int8_t feature_rings[audio_channels][2 * feature_element_count] = {0};
+
+// Slot the next slice will be written to. This is also the oldest slot of the
+// current window.
+static size_t feature_ring_head = 0;
+
+static uint32_t feature_window_position = 0;
+
+esp_err_t InitializeFeatureWindow() {
+  memset(feature_rings, 0, sizeof(feature_rings));
+  feature_ring_head = 0;
+  feature_window_position = 0;
+  AddMemoryBuffer("feature window", sizeof(feature_rings));
+  return ESP_OK;
+}
+
+int8_t* GetFeatureSliceBuffer(size_t channel) {
+  return feature_rings[channel] + feature_ring_head * feature_slice_size;
+}
+
+esp_err_t CommitFeatureSlice() {
+  // Update the mirrored copy of the slot. This is the only copy left per slice
+  // and only touches feature_slice_size bytes.
+  for (size_t channel = 0; channel < audio_channels; channel++) {
+    int8_t* slice = GetFeatureSliceBuffer(channel);
+    memcpy(slice + feature_element_count, slice, feature_slice_size);
+  }
+
+  if (++feature_ring_head >= (size_t)feature_slize_count) {
+    feature_ring_head = 0;
+  }
+  feature_window_position++;
+  return ESP_OK;
+}
+
+const int8_t* GetFeatureWindow(size_t channel) {
+  return feature_rings[channel] + feature_ring_head * feature_slice_size;
+}
+
+uint32_t GetFeatureWindowPosition() { return feature_window_position; }
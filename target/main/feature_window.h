@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FEATURE_WINDOW_H
+#define FEATURE_WINDOW_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+
+// Every one of the audio_channels channels has its own window, which all move
+// on together.
+
+// Clears all stored slices and resets the write position.
+esp_err_t InitializeFeatureWindow();
+
+// Returns the memory the next feature slice (feature_slice_size bytes) of
+// `channel` should be written to. The slice only becomes part of the window
+// once it has been committed with CommitFeatureSlice().
+int8_t* GetFeatureSliceBuffer(size_t channel);
+
+// Appends the slices written to GetFeatureSliceBuffer() to the feature windows
+// of all channels, dropping the oldest slice.
+esp_err_t CommitFeatureSlice();
+
+// Returns the current feature window of `channel`, i.e. the last
+// feature_slize_count slices ordered from oldest to newest, as one contiguous
+// feature_element_count byte array. Note that the oldest slice of the window
+// shares its memory with GetFeatureSliceBuffer(), so only write a new slice
+// once the model is done with the window.
+const int8_t* GetFeatureWindow(size_t channel);
+
+// Returns the number of slices committed since the initialization. This is
+// also the absolute index of the oldest slice of the current window, if the
+// zero slices the window starts with are counted as the first
+// feature_slize_count slices.
+uint32_t GetFeatureWindowPosition();
+
+#endif  // FEATURE_WINDOW_H
@@ -20,70 +20,115 @@
 
 #include "frontend.h"
 
+#include <cinttypes>
 #include <cmath>
 #include <cstdio>
 #include <cstring>
 
 #include "esp_log.h"
+#include "frontend_tables.h"
+#include "memory_report.h"
 #include "microfrontend/lib/frontend.h"
 #include "microfrontend/lib/frontend_util.h"
 #include "model_settings.h"
 
-FrontendState micro_features_state;
+static FrontendState micro_features_states[audio_channels];
 
-esp_err_t InitializeFrontend() {
+esp_err_t PopulateFrontendState(FrontendState* state,
+                                int32_t sample_frequency) {
   // TODO(fabianpedd): Understand each value and try to finetune it. Refer to
   // the paper: "TRAINABLE FRONTEND FOR ROBUST AND FAR-FIELD KEYWORD SPOTTING"
   // TODO(fabianpedd): Check if the training in Keras, where the frontend is
   // part of the model, is changing/optimizing these parameters during training
+  // The window, the filterbank and the gain of the PCAN are computed at
+  // compile time, see frontend_tables.h.
+  const frontend_tables_t* tables = GetFrontendTables(sample_frequency);
+  if (tables == NULL) {
+    ESP_LOGE(__FILE__, "ERROR: No frontend tables for %" PRId32 " Hz.",
+             sample_frequency);
+    return ESP_FAIL;
+  }
+
   FrontendConfig config;
   config.window.size_ms = feature_slice_duration_ms;
   config.window.step_size_ms = feature_slice_stride_ms;
+  config.window.coefficients = tables->window_coefficients;
   config.filterbank.num_channels = feature_slice_size;
-  config.filterbank.lower_band_limit = 125.0;
-  config.filterbank.upper_band_limit = 7500.0;
-  config.noise_reduction.smoothing_bits = 10;
+  config.filterbank.tables = &tables->filterbank;
+  config.noise_reduction.smoothing_bits = frontend_smoothing_bits;
   config.noise_reduction.even_smoothing = 0.025;
   config.noise_reduction.odd_smoothing = 0.06;
   config.noise_reduction.min_signal_remaining = 0.05;
   config.pcan_gain_control.enable_pcan = 1;
-  config.pcan_gain_control.strength = 0.95;
-  config.pcan_gain_control.offset = 80.0;
-  config.pcan_gain_control.gain_bits = 21;
+  config.pcan_gain_control.gain_bits = frontend_pcan_gain_bits;
+  config.pcan_gain_control.gain_lut = tables->pcan_gain_lut;
   config.log_scale.enable_log = 1;
   config.log_scale.scale_shift = 6;
 
-  if (!FrontendPopulateState(&config, &micro_features_state,
-                             audio_sample_frequency)) {
+  // The FFT size follows from the window size, i.e. 512 points at 16 kHz and
+  // 256 points at 8 kHz.
+  if (!FrontendPopulateState(&config, state, sample_frequency)) {
     ESP_LOGE(__FILE__, "ERROR: FrontendPopulateState() failed.");
     return ESP_FAIL;
   }
   return ESP_OK;
 }
 
-esp_err_t GenerateFrontendData(const int16_t* input, size_t input_size,
-                               int8_t* output) {
-  // TODO(fabianpedd): Simply add the 160 directly to input without the need for
-  // an extra variable. But was is this code here for anyways!?!
-  const int16_t* frontend_input;
-  static bool is_first_time = true;
-  if (is_first_time) {
-    frontend_input = input;
-    is_first_time = false;
-  } else {
-    // TODO(fabianpedd): Why do we need to add 160 here? Has this smth todo with
-    // the comment from petewarden in feature_provider?
-    frontend_input = input + 160;
+esp_err_t InitializeFrontend() {
+  // The frontend allocates its buffers on the heap, its lookup tables are in
+  // flash.
+  const size_t heap_used = GetHeapUsed();
+  for (FrontendState& state : micro_features_states) {
+    if (PopulateFrontendState(&state, audio_sample_frequency) != ESP_OK) {
+      ESP_LOGE(__FILE__, "ERROR: In InitializeFrontend().");
+      return ESP_FAIL;
+    }
+  }
+  AddMemoryBuffer("frontend state", GetHeapUsed() - heap_used);
+  return ESP_OK;
+}
+
+esp_err_t ResetFrontend() {
+  for (FrontendState& state : micro_features_states) {
+    FrontendReset(&state);
   }
+  return ESP_OK;
+}
 
-  // TODO(fabianpedd): Unused...
-  size_t num_samples_read = 0;
-  (void)num_samples_read;
+size_t GetFrontendSamplesNeeded() {
+  return micro_features_states[0].window.size -
+         micro_features_states[0].window.input_used;
+}
 
-  FrontendOutput frontend_output = FrontendProcessSamples(
-      &micro_features_state, frontend_input, input_size, &num_samples_read);
+esp_err_t GenerateFrontendData(size_t channel, const int16_t* input,
+                               size_t input_size, size_t* num_samples_read,
+                               int8_t* output, bool* output_ready) {
+  if (channel >= audio_channels) {
+    ESP_LOGE(__FILE__, "ERROR: In GenerateFrontendData(). Invalid channel.");
+    return ESP_ERR_INVALID_ARG;
+  }
+  return ProcessFrontendSamples(&micro_features_states[channel], input,
+                                input_size, num_samples_read, output,
+                                output_ready);
+}
+
+esp_err_t ProcessFrontendSamples(FrontendState* state, const int16_t* input,
+                                 size_t input_size, size_t* num_samples_read,
+                                 int8_t* output, bool* output_ready) {
+  // The WindowState inside the frontend buffers the samples until a full window
+  // is available and keeps the overlapping part of the last window, so we only
+  // ever have to feed it new samples.
+  FrontendOutput frontend_output =
+      FrontendProcessSamples(state, input, input_size, num_samples_read);
+
+  // Not enough samples for a new window yet. No big deal, the samples have been
+  // consumed and we will continue with the next call.
+  *output_ready = false;
+  if (frontend_output.values == NULL) {
+    return ESP_OK;
+  }
 
-  if (frontend_output.size <= 0 || frontend_output.values == NULL) {
+  if (frontend_output.size != (size_t)feature_slice_size) {
     ESP_LOGE(__FILE__, "ERROR: In FrontendProcessSamples().");
     return ESP_FAIL;
   }
@@ -121,5 +166,6 @@ esp_err_t GenerateFrontendData(const int16_t* input, size_t input_size,
     output[i] = value;
   }
 
+  *output_ready = true;
   return ESP_OK;
 }
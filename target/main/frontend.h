@@ -21,16 +21,49 @@
 #ifndef FRONTEND_H
 #define FRONTEND_H
 
+#include <cstddef>
 #include <cstdint>
 
 #include "esp_err.h"
 
-// Sets up any resources needed for the feature generation pipeline.
+// Sets up any resources needed for the feature generation pipeline. Every one
+// of the audio_channels channels gets its own frontend.
 esp_err_t InitializeFrontend();
 
 // Converts audio sample data into a more compact form that's appropriate for
-// feeding into a neural network.
-esp_err_t GenerateFrontendData(const int16_t* input, size_t input_size,
-                               int8_t* output);
+// feeding into a neural network. The input can be of arbitrary length, the
+// frontend keeps track of the window overlap itself. Samples are consumed until
+// a new feature slice is ready (or the input is exhausted), so the caller has
+// to call this again with the remaining `input_size - *num_samples_read`
+// samples. If a new slice was generated, it is written to `output` and
+// `*output_ready` is set to true.
+esp_err_t GenerateFrontendData(size_t channel, const int16_t* input,
+                               size_t input_size, size_t* num_samples_read,
+                               int8_t* output, bool* output_ready);
+
+// Forgets all samples seen so far, including the window overlap and the noise
+// and gain estimates, e.g. after a gap in the audio input. Resets the frontends
+// of all channels.
+esp_err_t ResetFrontend();
+
+// Number of samples still missing for the next feature slice. As long as all
+// channels get the same number of samples, this is the same for all of them.
+size_t GetFrontendSamplesNeeded();
+
+// The frontends of the pipeline are set up for audio_sample_frequency. The
+// following functions work on any frontend state, e.g. for comparing sample
+// rates in a host benchmark.
+struct FrontendState;
+
+// Sets up `state` for audio at `sample_frequency`. The upper band limit of the
+// filterbank stays below the Nyquist frequency, so at 8 kHz its
+// feature_slice_size channels reach up to 3.8 kHz instead of 7.5 kHz.
+esp_err_t PopulateFrontendState(FrontendState* state,
+                                int32_t sample_frequency);
+
+// Like GenerateFrontendData(), but with the frontend `state`.
+esp_err_t ProcessFrontendSamples(FrontendState* state, const int16_t* input,
+                                 size_t input_size, size_t* num_samples_read,
+                                 int8_t* output, bool* output_ready);
 
 #endif  // FRONTEND_H
@@ -0,0 +1,414 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "frontend_tables.h"
+
+#include "microfrontend/lib/filterbank.h"
+#include "microfrontend/lib/pcan_gain_control_util.h"
+#include "microfrontend/lib/window.h"
+#include "model_settings.h"
+
+// The tables are computed by the same expressions as the original code of the
+// microfrontend, with the same float and double types, so that they come out
+// the same. Only the functions of the math library are replaced by constexpr
+// versions below, which are precise to a few units in the last place of a
+// double. The results are rounded to float or to integers, so they only differ
+// if a value is almost exactly halfway between two of them. frontend_tables_
+// bench of the host build checks that the tables match the original code.
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+// ln(2) and pi / 2 split into a part with trailing zeros, whose multiples are
+// exact, and the rest, like in fdlibm.
+constexpr double kLn2High = 6.93147180369123816490e-01;
+constexpr double kLn2Low = 1.90821492927058770002e-10;
+constexpr double kHalfPiHigh = 1.57079632673412561417e+00;
+constexpr double kHalfPiLow = 6.07710050650619224932e-11;
+
+constexpr double Floor(double x) {
+  const double truncated = (double)(int64_t)x;
+  return truncated > x ? truncated - 1 : truncated;
+}
+
+constexpr double Round(double x) { return Floor(x + 0.5); }
+
+// x * 2^exponent.
+constexpr double ScaleByPowerOfTwo(double x, int exponent) {
+  for (; exponent > 0; exponent--) {
+    x *= 2;
+  }
+  for (; exponent < 0; exponent++) {
+    x /= 2;
+  }
+  return x;
+}
+
+// Taylor series of cos(x) (`power` 0) or sin(x) (`power` 1) for
+// |x| <= pi / 4.
+constexpr double CosSinSeries(double x, int power) {
+  double term = power == 0 ? 1.0 : x;
+  double sum = term;
+  for (int n = power + 2; n <= 24; n += 2) {
+    term *= -x * x / ((n - 1) * n);
+    sum += term;
+  }
+  return sum;
+}
+
+constexpr double Cos(double x) {
+  const double quadrants = Round(x / (kPi / 2));
+  const double reduced = (x - quadrants * kHalfPiHigh) - quadrants * kHalfPiLow;
+  switch ((int64_t)quadrants & 3) {
+    case 0:
+      return CosSinSeries(reduced, 0);
+    case 1:
+      return -CosSinSeries(reduced, 1);
+    case 2:
+      return -CosSinSeries(reduced, 0);
+    default:
+      return CosSinSeries(reduced, 1);
+  }
+}
+
+// For x > 0.
+constexpr double Log(double x) {
+  // x = m 2^exponent with m in [sqrt(1/2), sqrt(2)).
+  int exponent = 0;
+  for (; x >= 1.4142135623730951; exponent++) {
+    x /= 2;
+  }
+  for (; x < 0.7071067811865476; exponent--) {
+    x *= 2;
+  }
+  // ln(m) = 2 atanh(s) with s = (m - 1) / (m + 1), |s| < 0.18.
+  const double s = (x - 1) / (x + 1);
+  double power = s;
+  double sum = 0.0;
+  for (int n = 1; n <= 41; n += 2) {
+    sum += power / n;
+    power *= s * s;
+  }
+  return exponent * kLn2High + (2 * sum + exponent * kLn2Low);
+}
+
+constexpr double Log1p(double x) {
+  // Corrects the rounding error of 1 + x, see Goldberg, "What every computer
+  // scientist should know about floating-point arithmetic", theorem 4.
+  const double u = 1.0 + x;
+  return u == 1.0 ? x : Log(u) * x / (u - 1.0);
+}
+
+constexpr double Exp(double x) {
+  const double exponent = Round(x / kLn2High);
+  const double r = (x - exponent * kLn2High) - exponent * kLn2Low;
+  double term = 1.0;
+  double sum = 1.0;
+  for (int n = 1; n <= 20; n++) {
+    term *= r / n;
+    sum += term;
+  }
+  return ScaleByPowerOfTwo(sum, (int)exponent);
+}
+
+constexpr float PowF(float base, float exponent) {
+  return (float)Exp(exponent * Log(base));
+}
+
+constexpr size_t RoundUpToPowerOfTwo(size_t value, size_t power = 1) {
+  return power >= value ? power : RoundUpToPowerOfTwo(value, power * 2);
+}
+
+constexpr int num_channels_plus_1 = feature_slice_size + 1;
+
+// Sizes that follow from the sample rate, like in FrontendPopulateState().
+template <int32_t sample_frequency>
+struct FrontendSizes {
+  static constexpr size_t window_size =
+      feature_slice_duration_ms * sample_frequency / 1000;
+  // FftPopulateState().
+  static constexpr size_t fft_size =
+      RoundUpToPowerOfTwo(window_size < 4 ? 4 : window_size);
+  static constexpr int spectrum_size = fft_size / 2 + 1;
+  // MostSignificantBit32(fft_size) - 1 - (kFilterbankBits / 2).
+  static constexpr int32_t input_correction_bits =
+      __builtin_ctz(fft_size) - (kFilterbankBits / 2);
+};
+
+// WindowPopulateState().
+template <size_t size>
+struct WindowTable {
+  int16_t coefficients[size];
+};
+
+template <size_t size>
+constexpr WindowTable<size> MakeWindowTable() {
+  WindowTable<size> table = {};
+  const float arg = kPi * 2.0 / ((float)size);
+  for (size_t i = 0; i < size; ++i) {
+    const float float_value = 0.5 - (0.5 * Cos(arg * (i + 0.5)));
+    // Scale it to fixed point and round it.
+    table.coefficients[i] =
+        Floor(float_value * (1 << kFrontendWindowBits) + 0.5);
+  }
+  return table;
+}
+
+// FilterbankPopulateState().
+constexpr int kFilterbankIndexAlignment = 4;
+constexpr int kFilterbankChannelBlockSize = 4;
+
+constexpr float FreqToMel(float freq) { return 1127.0 * Log1p(freq / 700.0); }
+
+struct FilterbankLayout {
+  int start_index;
+  int end_index;
+  int16_t channel_frequency_starts[num_channels_plus_1];
+  int16_t channel_weight_starts[num_channels_plus_1];
+  int16_t channel_widths[num_channels_plus_1];
+  int num_weights;
+  // Only needed for the weights.
+  float center_mel_freqs[num_channels_plus_1];
+  int16_t actual_channel_starts[num_channels_plus_1];
+  int16_t actual_channel_widths[num_channels_plus_1];
+  float hz_per_sbin;
+};
+
+constexpr FilterbankLayout MakeFilterbankLayout(int32_t sample_frequency,
+                                                int spectrum_size) {
+  FilterbankLayout layout = {};
+  const float lower_band_limit = frontend_lower_band_limit;
+  const float upper_band_limit = FrontendUpperBandLimit(sample_frequency);
+  const int index_alignment =
+      (kFilterbankIndexAlignment < sizeof(int16_t)
+           ? 1
+           : kFilterbankIndexAlignment / sizeof(int16_t));
+
+  // CalculateCenterFrequencies().
+  const float mel_low = FreqToMel(lower_band_limit);
+  const float mel_hi = FreqToMel(upper_band_limit);
+  const float mel_span = mel_hi - mel_low;
+  const float mel_spacing = mel_span / ((float)num_channels_plus_1);
+  for (int i = 0; i < num_channels_plus_1; ++i) {
+    layout.center_mel_freqs[i] = mel_low + (mel_spacing * (i + 1));
+  }
+
+  // Always exclude DC.
+  const float hz_per_sbin =
+      0.5 * sample_frequency / ((float)spectrum_size - 1);
+  layout.hz_per_sbin = hz_per_sbin;
+  layout.start_index = 1.5 + lower_band_limit / hz_per_sbin;
+
+  int chan_freq_index_start = layout.start_index;
+  int weight_index_start = 0;
+  bool needs_zeros = false;
+  for (int chan = 0; chan < num_channels_plus_1; ++chan) {
+    // Keep jumping frequencies until we overshoot the bound on this channel.
+    int freq_index = chan_freq_index_start;
+    while (FreqToMel((freq_index)*hz_per_sbin) <=
+           layout.center_mel_freqs[chan]) {
+      ++freq_index;
+    }
+
+    const int width = freq_index - chan_freq_index_start;
+    layout.actual_channel_starts[chan] = chan_freq_index_start;
+    layout.actual_channel_widths[chan] = width;
+
+    if (width == 0) {
+      // The channel is always zero. It does a single block of multiplications
+      // with zero weights, which are placed at the beginning of the weights.
+      layout.channel_frequency_starts[chan] = 0;
+      layout.channel_weight_starts[chan] = 0;
+      layout.channel_widths[chan] = kFilterbankChannelBlockSize;
+      if (!needs_zeros) {
+        needs_zeros = true;
+        for (int j = 0; j < chan; ++j) {
+          layout.channel_weight_starts[j] += kFilterbankChannelBlockSize;
+        }
+        weight_index_start += kFilterbankChannelBlockSize;
+      }
+    } else {
+      const int aligned_start =
+          (chan_freq_index_start / index_alignment) * index_alignment;
+      const int aligned_width = (chan_freq_index_start - aligned_start + width);
+      const int padded_width =
+          (((aligned_width - 1) / kFilterbankChannelBlockSize) + 1) *
+          kFilterbankChannelBlockSize;
+
+      layout.channel_frequency_starts[chan] = aligned_start;
+      layout.channel_weight_starts[chan] = weight_index_start;
+      layout.channel_widths[chan] = padded_width;
+      weight_index_start += padded_width;
+    }
+    chan_freq_index_start = freq_index;
+  }
+  layout.num_weights = weight_index_start;
+
+  for (int chan = 0; chan < num_channels_plus_1; ++chan) {
+    const int end = layout.actual_channel_starts[chan] +
+                    layout.actual_channel_widths[chan];
+    if (end > layout.end_index) {
+      layout.end_index = end;
+    }
+  }
+  return layout;
+}
+
+template <int num_weights>
+struct FilterbankTable {
+  int16_t channel_frequency_starts[num_channels_plus_1];
+  int16_t channel_weight_starts[num_channels_plus_1];
+  int16_t channel_widths[num_channels_plus_1];
+  int16_t actual_channel_widths[num_channels_plus_1];
+  int16_t weights[num_weights];
+  int16_t unweights[num_weights];
+};
+
+template <int num_weights>
+constexpr FilterbankTable<num_weights> MakeFilterbankTable(
+    const FilterbankLayout& layout) {
+  FilterbankTable<num_weights> table = {};
+  for (int chan = 0; chan < num_channels_plus_1; ++chan) {
+    table.channel_frequency_starts[chan] =
+        layout.channel_frequency_starts[chan];
+    table.channel_weight_starts[chan] = layout.channel_weight_starts[chan];
+    table.channel_widths[chan] = layout.channel_widths[chan];
+    table.actual_channel_widths[chan] = layout.actual_channel_widths[chan];
+  }
+
+  const float mel_low = FreqToMel(frontend_lower_band_limit);
+  for (int chan = 0; chan < num_channels_plus_1; ++chan) {
+    int frequency = layout.actual_channel_starts[chan];
+    const int num_frequencies = layout.actual_channel_widths[chan];
+    const int frequency_offset =
+        frequency - layout.channel_frequency_starts[chan];
+    const int weight_start = layout.channel_weight_starts[chan];
+    const float denom_val =
+        (chan == 0) ? mel_low : layout.center_mel_freqs[chan - 1];
+    for (int j = 0; j < num_frequencies; ++j, ++frequency) {
+      const float weight = (layout.center_mel_freqs[chan] -
+                            FreqToMel(frequency * layout.hz_per_sbin)) /
+                           (layout.center_mel_freqs[chan] - denom_val);
+      // QuantizeFilterbankWeights().
+      const int weight_index = weight_start + frequency_offset + j;
+      table.weights[weight_index] =
+          Floor(weight * (1 << kFilterbankBits) + 0.5);
+      table.unweights[weight_index] =
+          Floor((1.0 - weight) * (1 << kFilterbankBits) + 0.5);
+    }
+  }
+  return table;
+}
+
+// PcanGainLookupFunction().
+constexpr int16_t PcanGain(int32_t input_bits, uint32_t x) {
+  const float x_as_float = ((float)x) / ((uint32_t)1 << input_bits);
+  const float gain_as_float =
+      ((uint32_t)1 << frontend_pcan_gain_bits) *
+      PowF(x_as_float + frontend_pcan_offset, -frontend_pcan_strength);
+
+  if (gain_as_float > INT16_MAX) {
+    return INT16_MAX;
+  }
+  return (int16_t)(gain_as_float + 0.5f);
+}
+
+// PcanGainControlPopulateState(). The fourth entry of every interval is not
+// used.
+struct PcanTable {
+  int16_t gain_lut[kWideDynamicFunctionLUTSize];
+};
+
+constexpr PcanTable MakePcanTable(int32_t input_correction_bits) {
+  PcanTable table = {};
+  const int32_t input_bits = frontend_smoothing_bits - input_correction_bits;
+  table.gain_lut[0] = PcanGain(input_bits, 0);
+  table.gain_lut[1] = PcanGain(input_bits, 1);
+  for (int interval = 2; interval <= kWideDynamicFunctionBits; ++interval) {
+    const uint32_t x0 = (uint32_t)1 << (interval - 1);
+    const uint32_t x1 = x0 + (x0 >> 1);
+    const uint32_t x2 =
+        (interval == kWideDynamicFunctionBits) ? x0 + (x0 - 1) : 2 * x0;
+
+    const int16_t y0 = PcanGain(input_bits, x0);
+    const int16_t y1 = PcanGain(input_bits, x1);
+    const int16_t y2 = PcanGain(input_bits, x2);
+
+    const int32_t diff1 = (int32_t)y1 - y0;
+    const int32_t diff2 = (int32_t)y2 - y0;
+    const int32_t a1 = 4 * diff1 - diff2;
+    const int32_t a2 = diff2 - a1;
+
+    table.gain_lut[4 * interval - 6] = y0;
+    table.gain_lut[4 * interval - 5] = (int16_t)a1;
+    table.gain_lut[4 * interval - 4] = (int16_t)a2;
+  }
+  return table;
+}
+
+template <int32_t sample_frequency>
+struct Tables {
+  typedef FrontendSizes<sample_frequency> sizes;
+  static constexpr WindowTable<sizes::window_size> window =
+      MakeWindowTable<sizes::window_size>();
+  static constexpr FilterbankLayout layout =
+      MakeFilterbankLayout(sample_frequency, sizes::spectrum_size);
+  static constexpr FilterbankTable<layout.num_weights> filterbank =
+      MakeFilterbankTable<layout.num_weights>(layout);
+  static constexpr PcanTable pcan = MakePcanTable(sizes::input_correction_bits);
+};
+
+template <int32_t sample_frequency>
+constexpr frontend_tables_t MakeFrontendTables() {
+  typedef Tables<sample_frequency> tables;
+  return {
+      tables::sizes::window_size,
+      tables::window.coefficients,
+      {
+          tables::layout.start_index,
+          tables::layout.end_index,
+          tables::filterbank.channel_frequency_starts,
+          tables::filterbank.channel_weight_starts,
+          tables::filterbank.channel_widths,
+          tables::filterbank.actual_channel_widths,
+          tables::filterbank.weights,
+          tables::filterbank.unweights,
+      },
+      tables::pcan.gain_lut,
+      sizeof(tables::window) + sizeof(tables::filterbank) +
+          sizeof(tables::pcan),
+  };
+}
+
+constexpr frontend_tables_t frontend_tables_16k = MakeFrontendTables<16000>();
+constexpr frontend_tables_t frontend_tables_8k = MakeFrontendTables<8000>();
+
+}  // namespace
+
+const frontend_tables_t* GetFrontendTables(int32_t sample_frequency) {
+  switch (sample_frequency) {
+    case 16000:
+      return &frontend_tables_16k;
+    case 8000:
+      return &frontend_tables_8k;
+    default:
+      return NULL;
+  }
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FRONTEND_TABLES_H
+#define FRONTEND_TABLES_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "microfrontend/lib/filterbank_util.h"
+
+// Lookup tables of the frontend, which the microfrontend used to compute and
+// allocate on the heap at startup. They only depend on the configuration, so
+// they are computed at compile time and end up in flash. The parameters below
+// are those of PopulateFrontendState() in frontend.cc.
+
+constexpr float frontend_lower_band_limit = 125.0f;
+// Just below the Nyquist frequency at 8 kHz, where the filterbank is squeezed
+// into half the bandwidth.
+constexpr float FrontendUpperBandLimit(int32_t sample_frequency) {
+  return std::min(7500.0f, 0.475f * sample_frequency);
+}
+constexpr uint16_t frontend_smoothing_bits = 10;
+constexpr float frontend_pcan_strength = 0.95f;
+constexpr float frontend_pcan_offset = 80.0f;
+constexpr int frontend_pcan_gain_bits = 21;
+
+typedef struct {
+  size_t window_size;
+  const int16_t* window_coefficients;
+  struct FilterbankTables filterbank;
+  const int16_t* pcan_gain_lut;
+  // Size of all tables in bytes.
+  size_t size;
+} frontend_tables_t;
+
+// Returns the tables for the window, the filterbank and the PCAN gain control
+// at `sample_frequency`, 16 kHz or 8 kHz, or NULL for any other rate.
+const frontend_tables_t* GetFrontendTables(int32_t sample_frequency);
+
+#endif  // FRONTEND_TABLES_H
@@ -65,6 +65,15 @@
 #define I2S_DATA_IN_PIN 33
 #define I2S_PORT_ID 1
 
+#elif CONFIG_IDF_TARGET_LINUX
+// Host build, see ../host. The pins are never used, there only is a shim of the
+// I2S driver and the LED is replaced by printing its color.
+
+#define I2S_SCK_PIN 7
+#define I2S_WS_PIN 6
+#define I2S_DATA_IN_PIN 8
+#define I2S_PORT_ID 0
+
 #else
 
 #error \
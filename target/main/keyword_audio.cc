@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "keyword_audio.h"
+
+#include "esp_log.h"
+#include "model_settings.h"
+#include "sdkconfig.h"
+
+constexpr uint64_t keyword_preroll_samples =
+    (uint64_t)audio_sample_frequency * CONFIG_MICRO_KWS_AUDIO_PREROLL_MS / 1000;
+constexpr uint64_t keyword_postroll_samples =
+    (uint64_t)audio_sample_frequency * CONFIG_MICRO_KWS_AUDIO_POSTROLL_MS /
+    1000;
+
+static uint64_t window_end_index = 0;
+
+// The held keyword, if `keyword_category` is not NULL, and the range of its
+// audio.
+static const char* keyword_category = NULL;
+static uint64_t keyword_start_index = 0;
+static uint64_t keyword_end_index = 0;
+
+esp_err_t SetKeywordWindowEnd(uint64_t sample_index) {
+  window_end_index = sample_index;
+  return ESP_OK;
+}
+
+// Passes the held audio on and releases it.
+static esp_err_t PassKeywordAudio() {
+  audio_span_t spans[2];
+  uint64_t start_index = 0;
+  bool complete = false;
+  esp_err_t ret = GetHeldAudio(keyword_start_index, keyword_end_index, spans,
+                               &start_index, &complete);
+  if (ret == ESP_OK) {
+    ret = KeywordAudioCallback(keyword_category, start_index, spans);
+  }
+  keyword_category = NULL;
+  ReleaseAudio();
+  return ret;
+}
+
+esp_err_t HoldKeywordAudio(const char* category) {
+  if (keyword_preroll_samples == 0) {
+    return ESP_OK;
+  }
+  if (keyword_category != NULL) {
+    PassKeywordAudio();
+  }
+
+  const esp_err_t ret = HoldAudio();
+  if (ret != ESP_OK) {
+    ESP_LOGE(__FILE__, "ERROR: In HoldKeywordAudio() at HoldAudio().");
+    return ret;
+  }
+  keyword_category = category;
+  keyword_start_index = window_end_index > keyword_preroll_samples
+                            ? window_end_index - keyword_preroll_samples
+                            : 0;
+  keyword_end_index = window_end_index + keyword_postroll_samples;
+  return ESP_OK;
+}
+
+esp_err_t GetKeywordAudio(audio_span_t spans[2], uint64_t* start_index) {
+  if (keyword_category == NULL) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  bool complete = false;
+  return GetHeldAudio(keyword_start_index, keyword_end_index, spans,
+                      start_index, &complete);
+}
+
+esp_err_t UpdateKeywordAudio() {
+  if (keyword_category == NULL) {
+    return ESP_OK;
+  }
+  audio_span_t spans[2];
+  uint64_t start_index = 0;
+  bool complete = false;
+  const esp_err_t ret = GetHeldAudio(keyword_start_index, keyword_end_index,
+                                     spans, &start_index, &complete);
+  if (ret != ESP_OK || !complete) {
+    return ret;
+  }
+  return PassKeywordAudio();
+}
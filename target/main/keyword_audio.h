@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef KEYWORD_AUDIO_H
+#define KEYWORD_AUDIO_H
+
+#include <cstdint>
+
+#include "audio.h"
+#include "esp_err.h"
+
+// The audio a keyword was detected in, kept in the audio queue without copying
+// it, see HoldAudio(). It reaches from CONFIG_MICRO_KWS_AUDIO_PREROLL_MS before
+// the end of the feature window the keyword was detected in to
+// CONFIG_MICRO_KWS_AUDIO_POSTROLL_MS after it. If
+// CONFIG_MICRO_KWS_AUDIO_PREROLL_MS is 0, no audio is kept and these
+// functions do nothing.
+
+// Tells where the feature window of the next posteriors ends, as the sample
+// index (see audio_position_t) just after the audio of its newest slice.
+esp_err_t SetKeywordWindowEnd(uint64_t sample_index);
+
+// Holds the audio of `category`, which has just been detected in the current
+// feature window. Called by the posterior handler before KeywordCallback(),
+// which can already look at the audio up to the end of the window with
+// GetKeywordAudio(). An earlier keyword that still waits for its post-roll is
+// passed on right away, with as much of the post-roll as there is.
+esp_err_t HoldKeywordAudio(const char* category);
+
+// Returns the audio of the held keyword captured so far, as up to two spans
+// of the first audio channel (see GetAudioChannelSamples()), which start at
+// the sample index `*start_index`. Returns ESP_ERR_INVALID_STATE if no keyword
+// is held.
+esp_err_t GetKeywordAudio(audio_span_t spans[2], uint64_t* start_index);
+
+// Passes the audio of the held keyword on to KeywordAudioCallback() as soon as
+// the post-roll is complete, and releases it afterwards. Has to be called
+// regularly by the task that calls HandlePosteriors(), even while no
+// inferences run, since the held audio blocks the audio queue.
+esp_err_t UpdateKeywordAudio();
+
+// Called with the audio of a detected keyword, including the post-roll, see
+// GetKeywordAudio(). The spans are only valid during the call. Implemented
+// next to KeywordCallback().
+esp_err_t KeywordAudioCallback(const char* category, uint64_t start_index,
+                               const audio_span_t spans[2]);
+
+#endif  // KEYWORD_AUDIO_H
@@ -31,18 +31,384 @@
 #include "esp_log.h"
 #include "esp_system.h"
 #include "esp_timer.h"
+#include "feature_window.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "frontend.h"
 #include "gpio.h"
+#include "keyword_audio.h"
+#include "memory_report.h"
 #include "model_settings.h"
+#include "pipeline_stats.h"
+#include "profiler.h"
+#include "rate_controller.h"
+#include "spsc_queue.h"
 #include "tvm_wrapper.h"
+#include "vad.h"
 
 // TODO(fabianpedd): Use size_t wherever reasonable
 // TODO(fabianpedd): Adjust return values and ESP_LOG to esp-idf specific types
 // and functions
 
+// Stack sizes in bytes.
+constexpr size_t micro_kws_stack_size = 32 * 1024;
+// The memory report shows about 8 KB used by the frontend task on a 64 bit
+// host, so it gets half of that on top.
+constexpr size_t frontend_task_stack_size = 12 * 1024;
+
+// The streaming convolution caches the rows of a single feature window, see
+// tvm_wrapper.h.
+#if defined(CONFIG_MICRO_KWS_STREAM) && CONFIG_MICRO_KWS_AUDIO_CHANNELS > 1
+#error "CONFIG_MICRO_KWS_STREAM only supports a single audio channel."
+#endif
+
+// A feature slice on its way from the frontend stage to the inference stage,
+// with the slices of all audio channels.
+typedef struct {
+  int8_t data[audio_channels][feature_slice_size];
+  // Time at which the slice was generated, used to measure the latency.
+  int64_t timestamp_us;
+  // Sample index just after the audio of the slice, see audio_position_t.
+  uint64_t end_sample_index;
+} feature_slice_t;
+
+// New feature slices generated by the frontend stage, waiting to be appended to
+// the feature window by the inference stage.
+static SpscQueue<feature_slice_t, CONFIG_MICRO_KWS_SLICE_QUEUE_LENGTH>
+    slice_queue;
+
+#ifdef CONFIG_MICRO_KWS_PIPELINE
+// The tasks of both stages. Each notifies the other when it commits or releases
+// a slice, so that the other can wait for the slice queue without polling.
+static TaskHandle_t frontend_task = NULL;
+static TaskHandle_t inference_task = NULL;
+#endif  // CONFIG_MICRO_KWS_PIPELINE
+
+// Tick count of the last inference, as updated by vTaskDelayUntil().
+static TickType_t last_inference_ticks = 0;
+
+// Position in the audio stream of the end of the feature window, and of the
+// window of the last posteriors, if there were any.
+static uint64_t window_end_sample_index = 0;
+static uint64_t last_posterior_sample_index = 0;
+static bool have_posteriors = false;
+
+// Longest gap in the audio input which is filled with silence.
+constexpr uint32_t max_gap_fill_samples =
+    (uint64_t)audio_sample_frequency * CONFIG_MICRO_KWS_AUDIO_GAP_FILL_MS /
+    1000;
+
+// How long the frontend waits for audio data before it complains.
+constexpr TickType_t audio_timeout_ticks = pdMS_TO_TICKS(1000);
+
+// Sleeps until there is enough audio data for the next slice, but at most for
+// `timeout` ticks. Returns ESP_ERR_TIMEOUT if there still is not.
+static esp_err_t WaitForFrontendData(TickType_t timeout) {
+  return WaitForAudioData(GetFrontendSamplesNeeded() * sizeof(int16_t),
+                          timeout);
+}
+
+// Generates new feature slices from the audio samples using the
+// GenerateFrontendData() function. This will convert the time domain audio
+// samples into a frequency domain representation. Every slice is written
+// straight into its slot in the slice queue. Since every slice needs
+// `feature_slice_stride_samples` new samples, the queue can not run full here.
+// The last samples might not complete another slice though, so they go through
+// the frontend even if the queue is already full.
+//
+// `channels` holds the samples of every audio channel, starting at
+// `sample_index` in the audio stream. The frontends of all channels get the
+// same number of samples, so they complete their slices at the same time.
+static esp_err_t ProcessAudioSamples(const int16_t* const* channels,
+                                     size_t num_samples, uint64_t sample_index,
+                                     size_t* num_slices) {
+  size_t offset = 0;
+  while (offset < num_samples) {
+    static feature_slice_t no_slice;
+    feature_slice_t* slice = slice_queue.AcquireWrite();
+    if (slice == NULL) {
+      slice = &no_slice;
+    }
+
+    size_t num_samples_read = 0;
+    bool slice_ready = false;
+    PROFILE_BEGIN(PROFILE_FRONTEND);
+    for (size_t channel = 0; channel < audio_channels; channel++) {
+      const esp_err_t frontend_ret = GenerateFrontendData(
+          channel, &channels[channel][offset], num_samples - offset,
+          &num_samples_read, slice->data[channel], &slice_ready);
+      if (frontend_ret != ESP_OK) {
+        ESP_LOGE(__FILE__, "ERROR: In GenerateFrontendData().");
+        return ESP_FAIL;
+      }
+    }
+    PROFILE_END(PROFILE_FRONTEND);
+    if (slice_ready && slice == &no_slice) {
+      ESP_LOGE(__FILE__, "ERROR: Slice queue overflow.");
+      return ESP_FAIL;
+    }
+    if (slice_ready) {
+      slice->timestamp_us = esp_timer_get_time();
+      slice->end_sample_index = sample_index + offset + num_samples_read;
+      slice_queue.CommitWrite();
+#ifdef CONFIG_MICRO_KWS_PIPELINE
+      xTaskNotifyGive(inference_task);
+#endif  // CONFIG_MICRO_KWS_PIPELINE
+      (*num_slices)++;
+    }
+    offset += num_samples_read;
+  }
+  return ESP_OK;
+}
+
+// The frontend stage. Gets audio data from audio input and creates slices until
+// no more data is available, but at most `max_slices` slices and never more
+// than there is room for in the slice queue.
+static esp_err_t RunFrontendStage(size_t max_slices, size_t* num_slices) {
+  const int64_t start_us = esp_timer_get_time();
+  *num_slices = 0;
+
+  // Only take as much audio data as needed for `max_slices` new slices. The
+  // rest stays in the audio queue until there is room again.
+  size_t samples_left = MIN(max_slices, slice_queue.Free()) *
+                        feature_slice_stride_samples;
+  while (samples_left > 0) {
+    // Look at the audio data directly in the blocks the capture task has read
+    // it into. We simply take whatever is available, the frontend keeps track
+    // of the 10ms window overlap and the 20ms window stride itself.
+    audio_span_t spans[2];
+    audio_position_t position;
+    PROFILE_BEGIN(PROFILE_AUDIO_RECEIVE);
+    const esp_err_t peek_ret = AudioPeek(1, spans, &position);
+    PROFILE_END(PROFILE_AUDIO_RECEIVE);
+    if (peek_ret != ESP_OK) {
+      ESP_LOGE(__FILE__, "ERROR: In AudioPeek().");
+      return ESP_FAIL;
+    }
+
+    // If there is no more audio data available at the moment, we are done.
+    if (spans[0].num_samples == 0) {
+      break;
+    }
+
+    // Samples were lost. Short gaps are processed as silence, which keeps the
+    // slices aligned to the audio stream. After a longer gap the frontend
+    // starts over, there is nothing to align to anymore.
+    if (position.gap_samples > max_gap_fill_samples) {
+      SkipAudioGap();
+      ResetFrontend();
+      continue;
+    }
+
+    size_t num_samples = 0;
+    for (const audio_span_t& span : spans) {
+      const size_t count = MIN(span.num_samples, samples_left - num_samples);
+      const int16_t* channels[audio_channels];
+      for (size_t channel = 0; channel < audio_channels; channel++) {
+        channels[channel] = GetAudioChannelSamples(span.samples, channel);
+      }
+      if (ProcessAudioSamples(channels, count,
+                              position.sample_index + num_samples,
+                              num_slices) != ESP_OK) {
+        return ESP_FAIL;
+      }
+      num_samples += count;
+    }
+    samples_left -= num_samples;
+    AudioCommit(num_samples);
+  }
+
+  RecordFrontendStage(*num_slices, esp_timer_get_time() - start_us,
+                      slice_queue.Free() == 0);
+  return ESP_OK;
+}
+
+// Prints the pipeline stats and the latency histograms, if enabled and due.
+static void PrintPeriodicStats() {
+#ifdef CONFIG_MICRO_KWS_PRINT_PIPELINE_STATS
+  static uint32_t last_stats_ms = (uint32_t)(esp_timer_get_time() / 1000);
+  if ((uint32_t)(esp_timer_get_time() / 1000) - last_stats_ms >=
+      CONFIG_MICRO_KWS_PRINT_PIPELINE_STATS_INTERVAL) {
+    last_stats_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    PrintAudioStats();
+    PrintPipelineStats();
+  }
+#endif  // CONFIG_MICRO_KWS_PRINT_PIPELINE_STATS
+
+#if defined(CONFIG_MICRO_KWS_PROFILE) && CONFIG_MICRO_KWS_PROFILE_INTERVAL > 0
+  static uint32_t last_profile_ms = (uint32_t)(esp_timer_get_time() / 1000);
+  if ((uint32_t)(esp_timer_get_time() / 1000) - last_profile_ms >=
+      CONFIG_MICRO_KWS_PROFILE_INTERVAL) {
+    last_profile_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    PrintProfile();
+  }
+#endif  // CONFIG_MICRO_KWS_PROFILE && CONFIG_MICRO_KWS_PROFILE_INTERVAL > 0
+
+#if defined(CONFIG_MICRO_KWS_PRINT_MEMORY) && \
+    CONFIG_MICRO_KWS_PRINT_MEMORY_INTERVAL > 0
+  static uint32_t last_memory_ms = (uint32_t)(esp_timer_get_time() / 1000);
+  if ((uint32_t)(esp_timer_get_time() / 1000) - last_memory_ms >=
+      CONFIG_MICRO_KWS_PRINT_MEMORY_INTERVAL) {
+    last_memory_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    PrintMemoryReport();
+  }
+#endif  // CONFIG_MICRO_KWS_PRINT_MEMORY &&
+        // CONFIG_MICRO_KWS_PRINT_MEMORY_INTERVAL > 0
+}
+
+// The inference stage. Appends all new slices to the feature window and runs
+// the model on the latest window.
+static esp_err_t RunInferenceStage() {
+  // Limit number of inferences per second, as chosen by the rate controller. We
+  // wait before taking the new slices so that the model always sees the latest
+  // data.
+  vTaskDelayUntil(&last_inference_ticks, GetInferenceIntervalTicks());
+
+  // Move the new slices from the slice queue into the feature window, each
+  // replacing the oldest slice.
+  size_t num_slices = 0;
+  int64_t newest_slice_us = esp_timer_get_time();
+  PROFILE_BEGIN(PROFILE_FEATURE_WINDOW);
+  for (feature_slice_t* slice = slice_queue.Peek(); slice != NULL;
+       slice = slice_queue.Peek()) {
+    for (size_t channel = 0; channel < audio_channels; channel++) {
+      memcpy(GetFeatureSliceBuffer(channel), slice->data[channel],
+             feature_slice_size);
+    }
+    VadProcessSlice(slice->data[0], audio_channels);
+    newest_slice_us = slice->timestamp_us;
+    window_end_sample_index = slice->end_sample_index;
+    SetKeywordWindowEnd(slice->end_sample_index);
+    slice_queue.Release();
+#ifdef CONFIG_MICRO_KWS_PIPELINE
+    xTaskNotifyGive(frontend_task);
+#endif  // CONFIG_MICRO_KWS_PIPELINE
+    CommitFeatureSlice();
+    num_slices++;
+  }
+  PROFILE_END(PROFILE_FEATURE_WINDOW);
+
+  // Pass on the audio of the last detected keyword once its post-roll has been
+  // captured. Also while the inferences are skipped, as the held audio blocks
+  // the audio queue.
+  PROFILE_BEGIN(PROFILE_KEYWORD_AUDIO);
+  UpdateKeywordAudio();
+  PROFILE_END(PROFILE_KEYWORD_AUDIO);
+
+  // Without any speech-like energy in the recent slices there is nothing to
+  // detect, so save the CPU time. VadIsActive() is always true if the voice
+  // activity detection is disabled.
+  if (!VadIsActive()) {
+    RecordSkippedInference(num_slices);
+    PrintPeriodicStats();
+    return ESP_OK;
+  }
+
+  // Let the model read its input directly from the feature window of every
+  // audio channel and run the inference.
+  uint8_t channel_outputs[audio_channels][category_count] = {{0}};
+  const int64_t inference_start_us = esp_timer_get_time();
+  for (size_t channel = 0; channel < audio_channels; channel++) {
+    model_set_input_ptr(0, (void*)GetFeatureWindow(channel));
+    model_set_input_position(GetFeatureWindowPosition());
+
+    PROFILE_BEGIN(PROFILE_MODEL_INVOKE);
+    model_invoke();
+    PROFILE_END(PROFILE_MODEL_INVOKE);
+
+    // Collect and offest the inference values by 128
+    for (size_t i = 0; i < category_count; i++) {
+      channel_outputs[channel][i] = ((int8_t*)model_output_ptr(0))[i] + 128;
+    }
+  }
+  const uint32_t inference_us = esp_timer_get_time() - inference_start_us;
+  RecordInferenceStage(num_slices, inference_start_us - newest_slice_us,
+                       inference_us);
+
+  uint8_t output[category_count] = {0};
+  FusePosteriors(channel_outputs, output);
+
+  // The posterior handler weights the posteriors with the audio time since the
+  // last ones, which includes the windows the VAD skipped. The first ones stand
+  // for a single stride.
+  const uint64_t elapsed_samples =
+      have_posteriors ? window_end_sample_index - last_posterior_sample_index
+                      : feature_slice_stride_samples;
+  const uint64_t elapsed_ms = elapsed_samples * 1000 / audio_sample_frequency;
+  SetPosteriorInterval((uint32_t)MAX(MIN(elapsed_ms, UINT32_MAX), 1));
+  last_posterior_sample_index = window_end_sample_index;
+  have_posteriors = true;
+
+  // Choose the time until the next inference.
+  UpdateRateController(inference_us, output);
+
+  /****************************************************************************/
+  /************************ Student work starts here **************************/
+  /****************************************************************************/
+
+  // Your task is to convert the model 'output' from "raw" posterior values to
+  // precentages.
+
+  // TODO(fabianpedd): Remove sample solution
+  // for (size_t i=0; i<category_count; i++) {
+  //   output[i] /= 2.55; // Divide by 255 and multiply by 100
+  // }
+
+  /****************************************************************************/
+  /************************ Student work stops here ***************************/
+  /****************************************************************************/
+
+  size_t top_category_index = 0;
+#ifdef CONFIG_MICRO_KWS_LED_RAW_POSTERIORS
+  SetLEDColor(output[3], output[2], 0);
+#else   // CONFIG_MICRO_KWS_LED_RAW_POSTERIORS
+  PROFILE_BEGIN(PROFILE_POSTERIORS);
+  HandlePosteriors(output, &top_category_index);
+  PROFILE_END(PROFILE_POSTERIORS);
+#endif  // CONFIG_MICRO_KWS_LED_RAW_POSTERIORS
+  // Send the feature buffer and inferences results to the computer for
+  // analysis and debugging.
+  PROFILE_BEGIN(PROFILE_DEBUG_RUN);
+  DebugRun(GetFeatureWindow(0), output, top_category_index);
+  PROFILE_END(PROFILE_DEBUG_RUN);
+
+  PrintPeriodicStats();
+
+  return ESP_OK;
+}
+
+#ifdef CONFIG_MICRO_KWS_PIPELINE
+// Runs the frontend stage in its own task, so that a slow model does not delay
+// the generation of new slices.
+static void FrontendTask(void* params) {
+  while (true) {
+    // Sleep until there is enough audio data for a new slice. If the slice
+    // queue is full, the inference stage has fallen behind, so sleep until it
+    // releases a slice instead. A notification meant for WaitForAudioData()
+    // only causes another check of the queue.
+    if (slice_queue.Free() == 0) {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      continue;
+    }
+    if (WaitForFrontendData(audio_timeout_ticks) != ESP_OK) {
+      ESP_LOGW(__FILE__, "WARNING: No audio data received.");
+      continue;
+    }
+
+    size_t num_slices = 0;
+    if (RunFrontendStage(slice_queue.Capacity(), &num_slices) != ESP_OK) {
+      ESP_LOGE(__FILE__, "ERROR: In RunFrontendStage().");
+      return;
+    }
+  }
+}
+#endif  // CONFIG_MICRO_KWS_PIPELINE
+
 void micro_kws(void* params) {
+  AddMemoryTask(xTaskGetCurrentTaskHandle(), "micro_kws", micro_kws_stack_size);
+  AddMemoryBuffer("slice queue", sizeof(slice_queue));
+  AddMemoryBuffer("mlf output", model_output_size(0));
+
   // Initialize onboard LEDs, if available.
   if (InitializeGPIO() != ESP_OK) {
     ESP_LOGE(__FILE__, "ERROR: In InitializeGPIO().");
@@ -59,6 +425,27 @@ void micro_kws(void* params) {
     return;
   }
 
+  // The feature window holds our features, interpreted as 40 by 49 byte 2d
+  // array, and is directly used as the model input.
+  if (InitializeFeatureWindow() != ESP_OK) {
+    ESP_LOGE(__FILE__, "ERROR: In InitializeFeatureWindow().");
+    return;
+  }
+  if (model_reset_input_position() != ESP_OK) {
+    ESP_LOGE(__FILE__, "ERROR: In model_reset_input_position().");
+    return;
+  }
+
+  if (InitializeVad() != ESP_OK) {
+    ESP_LOGE(__FILE__, "ERROR: In InitializeVad().");
+    return;
+  }
+
+  if (InitializeRateController() != ESP_OK) {
+    ESP_LOGE(__FILE__, "ERROR: In InitializeRateController().");
+    return;
+  }
+
   // This is only relevant when using the Python visualizer via the additional
   // UART interface.
   if (InitializeDebug() != ESP_OK) {
@@ -66,127 +453,101 @@ void micro_kws(void* params) {
     return;
   }
 
-  // We are collecting 20ms of new audio data and are reusing 10ms of past data.
-  // time    30ms = 20ms + 10ms
-  // samples 480 = 320 new + 160 old
-  // bytes   960 = 640 new + 320 old
-  int8_t audio_buffer[960] = {0};
-
-  // Contains our features. Interpreted as 40 by 49 byte 2d array.
-  int8_t feature_buffer[feature_element_count];
+#ifdef CONFIG_MICRO_KWS_PRINT_MEMORY
+  PrintMemoryReport();
+#endif  // CONFIG_MICRO_KWS_PRINT_MEMORY
 
   // Endless loop of main function.
   printf("Starting system main loop...\n");
 
-  TickType_t last_inference_ticks = xTaskGetTickCount();
-  ;
-  const TickType_t min_inference_ticks =
-      (1000 / CONFIG_MICRO_KWS_MAX_RATE) / portTICK_PERIOD_MS;
+  last_inference_ticks = xTaskGetTickCount();
 
+#ifndef CONFIG_MICRO_KWS_PIPELINE
   while (true) {
-    // Get audio data from audio input and create slices until no more data is
-    // available. But at most `feature_slize_count` times, which is equal to
-    // 960ms of data. If we would
-    for (size_t i = 0; i < feature_slize_count; i++) {
-      // Get audio data via I2S from the audio driver.
-      size_t actual_bytes_read = 0;
-      int8_t i2s_read_buffer[640] = {0};
-      if (GetAudioData(640, &actual_bytes_read, i2s_read_buffer) != ESP_OK) {
-        ESP_LOGE(__FILE__, "ERROR: In GetAudioData().");
-        return;
-      }
-
-      // If there is no more audio data available at the moment, exit the
-      // loop and continue with inference.
-      if (actual_bytes_read < 640) {
+    // Until the next inference is due, sleep until there is enough audio data
+    // for a new slice and generate it right away. This way the inference sees
+    // all slices whose audio data arrived in the meantime. If the slice queue
+    // is full, we have fallen behind, so run the inference right away.
+    while (true) {
+      const TickType_t next_inference_ticks =
+          last_inference_ticks + GetInferenceIntervalTicks();
+      const TickType_t now_ticks = xTaskGetTickCount();
+      if ((int32_t)(next_inference_ticks - now_ticks) <= 0 ||
+          slice_queue.Free() == 0 ||
+          WaitForFrontendData(next_inference_ticks - now_ticks) != ESP_OK) {
         break;
       }
-
-      // If there is a full 20ms / 320 samples / 640 bytes available, move the
-      // old data (10ms / 160 samples / 320 bytes) to the top of the buffer and
-      // fill the rest with the new audio data from the i2s_read_buffer.
-      memcpy(audio_buffer, audio_buffer + 640, 320);
-      memcpy(audio_buffer, i2s_read_buffer, 640);
-
-      // Generate a new feature slice from the audio samples using the
-      // GenerateFrontendData() function. This will convert the time domain
-      // audio samples into a frequency domain representation.
-      int8_t new_slice_buffer[feature_slice_size] = {0};
-      if (GenerateFrontendData((int16_t*)audio_buffer, 512, new_slice_buffer) !=
-          0) {
-        ESP_LOGE(__FILE__, "ERROR: In GenerateFrontendData().");
+      size_t num_slices = 0;
+      if (RunFrontendStage(1, &num_slices) != ESP_OK) {
+        ESP_LOGE(__FILE__, "ERROR: In RunFrontendStage().");
         return;
       }
-
-      // Move other slices by one, i.e. make room to store new slice at the end.
-      // TODO(fabianpedd): This is actually really inefficient. Using a
-      // ringbuffer would be a lot more efficient but also more
-      // complicated. The ringbuffer could be used in such a way as to
-      // minimize the amount of copying required. It would only be
-      // necessary to copy the data when a ringbuffer overflow occurs. The
-      // ringbuffer, in turn, would have to be at least 2-3x times the size of
-      // the data we are expecting in order for this method to bring any
-      // improvement. So we are basically trading in storage (of which we should
-      // have plenty) for computations. But then again, how expensive are a
-      // couple of memmoves and memcpys in the grand scheme of things here?
-      memmove(feature_buffer, feature_buffer + feature_slice_size,
-              feature_element_count - feature_slice_size);
-      memcpy(feature_buffer + feature_element_count - feature_slice_size,
-             new_slice_buffer, feature_slice_size);
-    }
-
-    // Copy the feature buffer into the model input buffer and run the
-    // inference.
-    memcpy((int8_t*)model_input_ptr(0), feature_buffer, feature_element_count);
-
-    // Limit number of inferences per second
-    vTaskDelayUntil(&last_inference_ticks, min_inference_ticks);
-
-    model_invoke();
-    // Collect and offest the inference values by 128
-    uint8_t output[category_count] = {0};
-    for (size_t i = 0; i < category_count; i++) {
-      output[i] = ((int8_t*)model_output_ptr(0))[i] + 128;
     }
 
-    /**************************************************************************/
-    /************************ Student work starts here ************************/
-    /**************************************************************************/
+    // Create at most `feature_slize_count` new slices, which is equal to 980ms
+    // of data, before running the next inference. Otherwise we might never get
+    // to run an inference if the audio data arrives faster than we can
+    // process it.
+    size_t num_slices = 0;
+    if (RunFrontendStage(feature_slize_count, &num_slices) != ESP_OK) {
+      ESP_LOGE(__FILE__, "ERROR: In RunFrontendStage().");
+      return;
+    }
 
-    // Your task is to convert the model 'output' from "raw" posterior values to
-    // precentages.
+    // Just like in the pipelined mode, there is no point in running the model
+    // on the same feature window twice. Without a new slice, sleep until there
+    // is enough audio data for one.
+    if (slice_queue.Size() == 0) {
+      if (WaitForFrontendData(audio_timeout_ticks) != ESP_OK) {
+        ESP_LOGW(__FILE__, "WARNING: No audio data received.");
+      }
+      continue;
+    }
 
-    // TODO(fabianpedd): Remove sample solution
-    // for (size_t i=0; i<category_count; i++) {
-    //   output[i] /= 2.55; // Divide by 255 and multiply by 100
-    // }
+    if (RunInferenceStage() != ESP_OK) {
+      ESP_LOGE(__FILE__, "ERROR: In RunInferenceStage().");
+      return;
+    }
+  }
+#else   // CONFIG_MICRO_KWS_PIPELINE
+  // The frontend stage gets a higher priority than this task, which becomes the
+  // inference stage. This way new slices are generated in time even while a
+  // long inference is running.
+  inference_task = xTaskGetCurrentTaskHandle();
+  if (xTaskCreate(FrontendTask, "micro_kws_frontend", frontend_task_stack_size,
+                  NULL, 9, &frontend_task) != pdPASS) {
+    ESP_LOGE(__FILE__, "ERROR: In xTaskCreate(FrontendTask).");
+    return;
+  }
+  AddMemoryTask(frontend_task, "micro_kws_frontend", frontend_task_stack_size);
 
-    /**************************************************************************/
-    /************************ Student work stops here *************************/
-    /**************************************************************************/
+  while (true) {
+    // Sleep until there is at least one new slice, there is no point in running
+    // the model on the same feature window twice.
+    if (slice_queue.Size() == 0) {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      continue;
+    }
 
-    size_t top_category_index = 0;
-#ifdef CONFIG_MICRO_KWS_LED_RAW_POSTERIORS
-    SetLEDColor(output[3], output[2], 0);
-#else   // CONFIG_MICRO_KWS_LED_RAW_POSTERIORS
-    HandlePosteriors(output, &top_category_index);
-#endif  // CONFIG_MICRO_KWS_LED_RAW_POSTERIORS
-    // Send the feature buffer and inferences results to the computer for
-    // analysis and debugging.
-    DebugRun(feature_buffer, output, top_category_index);
+    if (RunInferenceStage() != ESP_OK) {
+      ESP_LOGE(__FILE__, "ERROR: In RunInferenceStage().");
+      return;
+    }
   }
+#endif  // CONFIG_MICRO_KWS_PIPELINE
 }
 
 // This function gets called after the internal bootprocess is finished. We
 // directly span a new task in which we do all the work.
 extern "C" void app_main(void) {
 #ifndef CONFIG_MICRO_KWS_MODE_DEBUG_AUDIO
-  xTaskCreate(&micro_kws,   // Function that implements the task.
-              "micro_kws",  // Text name for the task.
-              32 * 1024,    // Stack size in bytes, so 32KB.
-              NULL,         // Parameter passed into the task.
-              8,            // Priority of task. Higher number, higher prio.
-              NULL          // Task handle.
+  xTaskCreate(&micro_kws,             // Function that implements the task.
+              "micro_kws",            // Text name for the task.
+              micro_kws_stack_size,   // Stack size in bytes, so 32KB.
+              NULL,                   // Parameter passed into the task.
+              8,                      // Priority of task. Higher number,
+                                      // higher prio.
+              NULL                    // Task handle.
   );
 #else   // CONFIG_MICRO_KWS_MODE_DEBUG_AUDIO
   xTaskCreate(&micro_audio,   // Function that implements the task.
@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "memory_report.h"
+
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "sdkconfig.h"
+#include "tvmgen_default.h"
+
+// Set by mlf_memory.cmake from the metadata.json of the MLF.
+#if !defined(MICRO_KWS_MLF_WORKSPACE_SIZE) || \
+    !defined(MICRO_KWS_MLF_CONSTANTS_SIZE)
+#error "The MLF memory sizes are missing, see mlf_memory.cmake."
+#endif
+
+static_assert(MICRO_KWS_MLF_WORKSPACE_SIZE == TVMGEN_DEFAULT_WORKSPACE_SIZE,
+              "metadata.json does not match tvmgen_default.h.");
+
+typedef struct {
+  const char* name;
+  size_t size;
+} memory_buffer_t;
+
+typedef struct {
+  TaskHandle_t task;
+  const char* name;
+  size_t stack_size;
+} memory_task_t;
+
+typedef struct {
+  const void* queue;
+  const char* name;
+  size_t size;
+  // Only written by the producer, see UpdateMemoryQueuePeak().
+  std::atomic<size_t> peak;
+} memory_queue_t;
+
+constexpr size_t max_memory_buffers = 16;
+constexpr size_t max_memory_tasks = 8;
+constexpr size_t max_memory_queues = 4;
+
+// The MLF buffers are always there. The workspace is the global_workspace in
+// .bss.noinit.tvm. The io of the metadata.json is left out: the input is read
+// directly from the feature window, and the output buffer of tvm_wrapper.cc is
+// added by the main loop.
+static const memory_buffer_t mlf_buffers[] = {
+    {"mlf workspace", MICRO_KWS_MLF_WORKSPACE_SIZE},
+    {"mlf constants", MICRO_KWS_MLF_CONSTANTS_SIZE},
+#ifdef CONFIG_MICRO_KWS_STREAM
+    {"mlf stream cache", TVMGEN_DEFAULT_STREAM_CACHE_SIZE},
+#endif  // CONFIG_MICRO_KWS_STREAM
+};
+
+static memory_buffer_t buffers[max_memory_buffers];
+static size_t buffer_count = 0;
+
+static memory_task_t tasks[max_memory_tasks];
+static size_t task_count = 0;
+
+static memory_queue_t queues[max_memory_queues];
+static size_t queue_count = 0;
+
+esp_err_t AddMemoryBuffer(const char* name, size_t size) {
+  if (buffer_count >= max_memory_buffers) {
+    ESP_LOGE(__FILE__, "ERROR: In AddMemoryBuffer(). Too many buffers.");
+    return ESP_ERR_NO_MEM;
+  }
+  buffers[buffer_count].name = name;
+  buffers[buffer_count].size = size;
+  buffer_count++;
+  return ESP_OK;
+}
+
+esp_err_t AddMemoryTask(TaskHandle_t task, const char* name,
+                        size_t stack_size) {
+  if (task_count >= max_memory_tasks) {
+    ESP_LOGE(__FILE__, "ERROR: In AddMemoryTask(). Too many tasks.");
+    return ESP_ERR_NO_MEM;
+  }
+  tasks[task_count].task = task;
+  tasks[task_count].name = name;
+  tasks[task_count].stack_size = stack_size;
+  task_count++;
+  return ESP_OK;
+}
+
+esp_err_t AddMemoryQueue(const void* queue, const char* name, size_t size) {
+  if (queue_count >= max_memory_queues) {
+    ESP_LOGE(__FILE__, "ERROR: In AddMemoryQueue(). Too many queues.");
+    return ESP_ERR_NO_MEM;
+  }
+  queues[queue_count].queue = queue;
+  queues[queue_count].name = name;
+  queues[queue_count].size = size;
+  queues[queue_count].peak.store(0, std::memory_order_relaxed);
+  queue_count++;
+  return ESP_OK;
+}
+
+void UpdateMemoryQueuePeak(const void* queue, size_t fill) {
+  for (size_t i = 0; i < queue_count; i++) {
+    memory_queue_t* entry = &queues[i];
+    if (entry->queue != queue) {
+      continue;
+    }
+    if (fill > entry->peak.load(std::memory_order_relaxed)) {
+      entry->peak.store(fill, std::memory_order_relaxed);
+    }
+    return;
+  }
+}
+
+esp_err_t AddMemoryRingbuffer(RingbufHandle_t buffer, const char* name,
+                              size_t size) {
+  return AddMemoryQueue(buffer, name, size);
+}
+
+void UpdateMemoryRingbufferPeak(RingbufHandle_t buffer) {
+  for (size_t i = 0; i < queue_count; i++) {
+    if (queues[i].queue == buffer) {
+      UpdateMemoryQueuePeak(buffer,
+                            queues[i].size - xRingbufferGetCurFreeSize(buffer));
+      return;
+    }
+  }
+}
+
+size_t GetHeapUsed() {
+  return heap_caps_get_total_size(MALLOC_CAP_DEFAULT) -
+         heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+}
+
+static void PrintMemoryLine(const char* kind, const char* name, size_t size) {
+  printf("  %-10s %-20s %10" PRIu32 "\n", kind, name, (uint32_t)size);
+}
+
+static void PrintMemoryLine(const char* kind, const char* name, size_t size,
+                            size_t used) {
+  printf("  %-10s %-20s %10" PRIu32 " %10" PRIu32 "\n", kind, name,
+         (uint32_t)size, (uint32_t)used);
+}
+
+esp_err_t PrintMemoryReport() {
+  printf("Memory (bytes)                          size       used\n");
+
+  size_t buffer_total = 0;
+  for (const memory_buffer_t& buffer : mlf_buffers) {
+    PrintMemoryLine("buffer", buffer.name, buffer.size);
+    buffer_total += buffer.size;
+  }
+  for (size_t i = 0; i < buffer_count; i++) {
+    PrintMemoryLine("buffer", buffers[i].name, buffers[i].size);
+    buffer_total += buffers[i].size;
+  }
+
+  // The high-water mark is the smallest amount of free stack so far.
+  size_t stack_total = 0;
+  size_t stack_used_total = 0;
+  for (size_t i = 0; i < task_count; i++) {
+    const size_t free = uxTaskGetStackHighWaterMark(tasks[i].task);
+    const size_t used =
+        free < tasks[i].stack_size ? tasks[i].stack_size - free : 0;
+    PrintMemoryLine("stack", tasks[i].name, tasks[i].stack_size, used);
+    stack_total += tasks[i].stack_size;
+    stack_used_total += used;
+  }
+
+  size_t queue_total = 0;
+  size_t queue_peak_total = 0;
+  for (size_t i = 0; i < queue_count; i++) {
+    const size_t peak = queues[i].peak.load(std::memory_order_relaxed);
+    PrintMemoryLine("queue", queues[i].name, queues[i].size, peak);
+    queue_total += queues[i].size;
+    queue_peak_total += peak;
+  }
+
+  // The peak heap usage follows from the smallest amount of free heap so far.
+  const size_t heap_total = heap_caps_get_total_size(MALLOC_CAP_DEFAULT);
+  PrintMemoryLine("heap", "now", heap_total, GetHeapUsed());
+  PrintMemoryLine(
+      "heap", "peak", heap_total,
+      heap_total - heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT));
+
+  printf("Memory: buffers %" PRIu32 ", stacks %" PRIu32 " (used %" PRIu32
+         "), queues %" PRIu32 " (peak %" PRIu32 ")\n",
+         (uint32_t)buffer_total, (uint32_t)stack_total,
+         (uint32_t)stack_used_total, (uint32_t)queue_total,
+         (uint32_t)queue_peak_total);
+  return ESP_OK;
+}
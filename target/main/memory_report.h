@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MEMORY_REPORT_H
+#define MEMORY_REPORT_H
+
+// Memory accounting. Collects the size of every large buffer together with the
+// stack high-water marks of the tasks, the peak fill of the queues and the
+// heap usage, so that stacks and buffers can be sized based on measurements.
+//
+// The sizes of the MLF buffers are read from its metadata.json at build time,
+// see mlf_memory.cmake. Everything else registers itself during the
+// initialization. Registration is not thread-safe, so it is only done by the
+// micro_kws task before the main loop starts.
+
+#include <cstddef>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/ringbuf.h"
+#include "freertos/task.h"
+
+// Adds a buffer of fixed size, e.g. a static array or a heap allocation made
+// during the initialization.
+esp_err_t AddMemoryBuffer(const char* name, size_t size);
+
+// Adds a task whose stack of `stack_size` bytes is checked for its high-water
+// mark.
+esp_err_t AddMemoryTask(TaskHandle_t task, const char* name,
+                        size_t stack_size);
+
+// Adds a queue of `size` bytes, identified by any pointer unique to it. Its
+// peak fill is only tracked by calls of UpdateMemoryQueuePeak().
+esp_err_t AddMemoryQueue(const void* queue, const char* name, size_t size);
+
+// Records that `fill` bytes of `queue` are in use. Meant to be called by the
+// producer right after every write, as this is when the queue is fullest.
+void UpdateMemoryQueuePeak(const void* queue, size_t fill);
+
+// The same for FreeRTOS ringbuffers, whose fill is looked up.
+esp_err_t AddMemoryRingbuffer(RingbufHandle_t buffer, const char* name,
+                              size_t size);
+void UpdateMemoryRingbufferPeak(RingbufHandle_t buffer);
+
+// Returns the number of heap bytes currently allocated.
+size_t GetHeapUsed();
+
+esp_err_t PrintMemoryReport();
+
+#endif  // MEMORY_REPORT_H
@@ -13,40 +13,347 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 #include "microfrontend/lib/fft.h"
-#include "microfrontend/lib/kiss_fft_int16.h"
 
 #include <string.h>
 
+#include "microfrontend/lib/bits.h"
+#include "sdkconfig.h"
 
-void FftCompute(struct FftState* state, const int16_t* input,
-                int input_scale_shift) {
-  const size_t input_size = state->input_size;
-  const size_t fft_size = state->fft_size;
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define FFT_SIMD 1
+#endif
+
+// The FFT used to be kissfft_fixed16::kiss_fftr(). For a power of two size, it
+// computes a complex FFT of half the size on the even and odd samples, factored
+// into radix 4 stages and one radix 2 stage if needed, and splits the result
+// into the bins of the real input. Every step divides by its radix and rounds,
+// and all intermediate values are 16 bit. This is the same computation with the
+// stages as plain loops instead of a recursion, the input permutation and the
+// scaling of the input fused into the first stage, and twiddle factors that are
+// computed at compile time. Every value is rounded and truncated to 16 bits
+// exactly like kissfft does, so the features do not change.
+
+namespace {
+
+typedef struct complex_int16_t Complex;
+
+constexpr size_t RoundUpToPowerOfTwo(size_t value, size_t power = 1) {
+  return power >= value ? power : RoundUpToPowerOfTwo(value, power * 2);
+}
+
+// The frontend runs at 16 kHz or 8 kHz, so this size is enough for the
+// configured window at both rates.
+constexpr size_t kMaxFftSize =
+    RoundUpToPowerOfTwo(CONFIG_MICRO_KWS_WINDOW_SIZE_MS * 16000 / 1000);
+
+constexpr double kPi = 3.14159265358979323846;
 
-  int16_t* fft_input = state->input;
-  // First, scale the input by the given shift.
-  size_t i;
-  for (i = 0; i < input_size; ++i) {
-    fft_input[i] = static_cast<int16_t>(static_cast<uint16_t>(input[i])
-                                        << input_scale_shift);
+// Taylor series of cos(x) (`power` 0) or sin(x) (`power` 1), precise to the
+// last bit of a double for |x| <= pi / 4.
+constexpr double Taylor(double x, int power) {
+  double term = power == 0 ? 1.0 : x;
+  double sum = term;
+  for (int n = power + 2; n <= 24; n += 2) {
+    term *= -x * x / ((n - 1) * n);
+    sum += term;
   }
-  // Zero out whatever else remains in the top part of the input.
-  for (; i < fft_size; ++i) {
-    fft_input[i] = 0;
+  return sum;
+}
+
+// Q15 value like KISS_FFT_COS() and KISS_FFT_SIN(), floor(0.5 + 32767 * x).
+constexpr int16_t ToQ15(double x) {
+  const double value = 0.5 + 32767 * x;
+  const int16_t truncated = (int16_t)value;
+  return truncated > value ? truncated - 1 : truncated;
+}
+
+// e^(-2 pi i index / size) in Q15, like kf_cexp().
+constexpr Complex Twiddle(size_t index, size_t size) {
+  // Reduce the angle to [0, pi / 4], using integers, so that every quadrant
+  // and octant is exactly as precise as the first one.
+  const size_t quadrant = index * 4 / size;
+  const size_t remainder = index - quadrant * size / 4;
+  const bool upper_octant = remainder * 8 > size;
+  const double angle =
+      2 * kPi * (upper_octant ? size / 4 - remainder : remainder) / size;
+  const double c = Taylor(angle, upper_octant ? 1 : 0);
+  const double s = Taylor(angle, upper_octant ? 0 : 1);
+  const double cosine[] = {c, -s, -c, s};
+  const double sine[] = {s, c, -s, -c};
+  return {ToQ15(cosine[quadrant]), ToQ15(-sine[quadrant])};
+}
+
+// The twiddle factors e^(-2 pi i k / kMaxFftSize) up to 3/4 of a turn. The
+// complex FFT of size n needs those of its own size up to 3/4 of a turn, every
+// (kMaxFftSize / n)-th entry, and the split into the real bins those of twice
+// its size up to 1/4 of a turn.
+struct TwiddleTable {
+  Complex values[kMaxFftSize * 3 / 4];
+};
+
+constexpr TwiddleTable MakeTwiddleTable() {
+  TwiddleTable table = {};
+  for (size_t k = 0; k < kMaxFftSize * 3 / 4; k++) {
+    table.values[k] = Twiddle(k, kMaxFftSize);
   }
+  return table;
+}
+
+constexpr TwiddleTable twiddle_table = MakeTwiddleTable();
+const Complex* const twiddles = twiddle_table.values;
 
-  // Apply the FFT.
-  kissfft_fixed16::kiss_fftr(
-    reinterpret_cast<kissfft_fixed16::kiss_fftr_cfg>(state->scratch),
-    state->input,
-    reinterpret_cast<kissfft_fixed16::kiss_fft_cpx*>(state->output));
+// sround(), including the truncation to 16 bits.
+inline int16_t Round(int32_t product) {
+  return (int16_t)((product + (1 << 14)) >> 15);
 }
 
+// C_FIXDIV().
+inline Complex Divide(Complex a, int32_t divisor) {
+  const int32_t factor = 32767 / divisor;
+  return {Round(a.real * factor), Round(a.imag * factor)};
+}
+
+// C_MUL().
+inline Complex Multiply(Complex a, Complex b) {
+  return {Round(a.real * b.real - a.imag * b.imag),
+          Round(a.real * b.imag + a.imag * b.real)};
+}
+
+inline Complex Add(Complex a, Complex b) {
+  return {(int16_t)(a.real + b.real), (int16_t)(a.imag + b.imag)};
+}
+
+inline Complex Subtract(Complex a, Complex b) {
+  return {(int16_t)(a.real - b.real), (int16_t)(a.imag - b.imag)};
+}
+
+// The second half of kf_bfly4(), after the inputs are divided by 4 and
+// multiplied with their twiddle factors.
+inline void Combine4(Complex f0, Complex s0, Complex s1, Complex s2,
+                     Complex* out0, Complex* out1, Complex* out2,
+                     Complex* out3) {
+  const Complex s5 = Subtract(f0, s1);
+  f0 = Add(f0, s1);
+  const Complex s3 = Add(s0, s2);
+  const Complex s4 = Subtract(s0, s2);
+  *out2 = Subtract(f0, s3);
+  *out0 = Add(f0, s3);
+  *out1 = {(int16_t)(s5.real + s4.imag), (int16_t)(s5.imag - s4.real)};
+  *out3 = {(int16_t)(s5.real - s4.imag), (int16_t)(s5.imag + s4.real)};
+}
+
+// Element `index` of the complex input, made of two samples, shifted and
+// divided by `divisor`. The padding is zero, without reading or scaling it.
+inline Complex LoadInput(const int16_t* input, size_t input_size, int shift,
+                         size_t index, int32_t divisor) {
+  const size_t i = index * 2;
+  if (i >= input_size) {
+    return {0, 0};
+  }
+  const int16_t real = (int16_t)((uint16_t)input[i] << shift);
+  const int16_t imag =
+      i + 1 < input_size ? (int16_t)((uint16_t)input[i + 1] << shift) : 0;
+  return Divide({real, imag}, divisor);
+}
+
+inline size_t Log2(size_t power_of_two) {
+  return MostSignificantBit32(power_of_two) - 1;
+}
+
+// Reverses the order of the `num_digits` lowest base 4 digits of `value`.
+inline size_t ReverseDigits(size_t value, size_t num_digits) {
+  size_t result = 0;
+  for (; num_digits > 0; num_digits--) {
+    result = (result << 2) | (value & 3);
+    value >>= 2;
+  }
+  return result;
+}
+
+// The innermost stage, with a radix of 2 if the size is not a power of 4,
+// which reads its input from the permuted positions. It multiplies with the
+// twiddle factor e^0, which is slightly less than one in Q15.
+void FirstStage(const int16_t* input, size_t input_size, int shift,
+                Complex* output, size_t size) {
+  const Complex one = twiddles[0];
+  const size_t radix = (Log2(size) & 1) ? 2 : 4;
+  const size_t stride = size / radix;
+  const size_t num_digits = Log2(stride) / 2;
+  for (size_t block = 0; block < stride; block++) {
+    const size_t start = ReverseDigits(block, num_digits);
+    Complex* out = output + block * radix;
+    if (radix == 2) {
+      const Complex f0 = LoadInput(input, input_size, shift, start, 2);
+      const Complex f1 =
+          LoadInput(input, input_size, shift, start + stride, 2);
+      const Complex t = Multiply(f1, one);
+      out[1] = Subtract(f0, t);
+      out[0] = Add(f0, t);
+    } else {
+      const Complex f0 = LoadInput(input, input_size, shift, start, 4);
+      const Complex s0 = Multiply(
+          LoadInput(input, input_size, shift, start + stride, 4), one);
+      const Complex s1 = Multiply(
+          LoadInput(input, input_size, shift, start + 2 * stride, 4), one);
+      const Complex s2 = Multiply(
+          LoadInput(input, input_size, shift, start + 3 * stride, 4), one);
+      Combine4(f0, s0, s1, s2, &out[0], &out[1], &out[2], &out[3]);
+    }
+  }
+}
+
+#ifdef FFT_SIMD
+// Rounds the 32 bit real and imaginary parts of four products, truncates them
+// to 16 bits and interleaves them.
+inline __m128i RoundVector(__m128i real, __m128i imag) {
+  const __m128i round = _mm_set1_epi32(1 << 14);
+  real = _mm_srai_epi32(_mm_add_epi32(real, round), 15);
+  imag = _mm_srai_epi32(_mm_add_epi32(imag, round), 15);
+  return _mm_or_si128(_mm_and_si128(real, _mm_set1_epi32(0xffff)),
+                      _mm_slli_epi32(imag, 16));
+}
+
+inline __m128i DivideVector(__m128i a, __m128i factor) {
+  return RoundVector(_mm_madd_epi16(a, factor),
+                     _mm_madd_epi16(_mm_srli_epi32(a, 16), factor));
+}
+
+// Multiplies with (b.real, -b.imag) and (b.imag, b.real) of the twiddle
+// factors b, which give the real and imaginary part with one pmaddwd each.
+inline __m128i MultiplyVector(__m128i a, __m128i b_real, __m128i b_imag) {
+  return RoundVector(_mm_madd_epi16(a, b_real), _mm_madd_epi16(a, b_imag));
+}
+
+inline __m128i SwapVector(__m128i a) {
+  return _mm_shufflehi_epi16(_mm_shufflelo_epi16(a, 0xb1), 0xb1);
+}
+
+// Negates the imaginary parts.
+inline __m128i ConjugateVector(__m128i a) {
+  const __m128i mask = _mm_set1_epi32((int32_t)0xffff0000);
+  return _mm_sub_epi16(_mm_xor_si128(a, mask), mask);
+}
+
+// Twiddle factors `index`, 2 `index`, ... of `step` apart, for
+// MultiplyVector().
+inline void LoadTwiddles(size_t index, size_t step, __m128i* real,
+                         __m128i* imag) {
+  int32_t values[4];
+  for (size_t k = 0; k < 4; k++) {
+    memcpy(&values[k], &twiddles[(index + k) * step], sizeof(values[k]));
+  }
+  const __m128i b =
+      _mm_setr_epi32(values[0], values[1], values[2], values[3]);
+  *real = ConjugateVector(b);
+  *imag = SwapVector(b);
+}
+
+// Radix 4 stage with the butterflies of four neighboring elements at once.
+void Stage4Vector(Complex* output, size_t size, size_t length) {
+  const size_t step = kMaxFftSize / (4 * length);
+  const __m128i factor = _mm_set1_epi32(32767 / 4);
+  for (size_t u = 0; u < length; u += 4) {
+    __m128i tw1_real, tw1_imag, tw2_real, tw2_imag, tw3_real, tw3_imag;
+    LoadTwiddles(u, step, &tw1_real, &tw1_imag);
+    LoadTwiddles(u, 2 * step, &tw2_real, &tw2_imag);
+    LoadTwiddles(u, 3 * step, &tw3_real, &tw3_imag);
+    for (Complex* out = output + u; out < output + size; out += 4 * length) {
+      __m128i* out0 = (__m128i*)out;
+      __m128i* out1 = (__m128i*)(out + length);
+      __m128i* out2 = (__m128i*)(out + 2 * length);
+      __m128i* out3 = (__m128i*)(out + 3 * length);
+      __m128i f0 = DivideVector(_mm_loadu_si128(out0), factor);
+      const __m128i s0 = MultiplyVector(
+          DivideVector(_mm_loadu_si128(out1), factor), tw1_real, tw1_imag);
+      const __m128i s1 = MultiplyVector(
+          DivideVector(_mm_loadu_si128(out2), factor), tw2_real, tw2_imag);
+      const __m128i s2 = MultiplyVector(
+          DivideVector(_mm_loadu_si128(out3), factor), tw3_real, tw3_imag);
+      const __m128i s5 = _mm_sub_epi16(f0, s1);
+      f0 = _mm_add_epi16(f0, s1);
+      const __m128i s3 = _mm_add_epi16(s0, s2);
+      // (s4.imag, -s4.real), see Combine4().
+      const __m128i s4 = ConjugateVector(SwapVector(_mm_sub_epi16(s0, s2)));
+      _mm_storeu_si128(out2, _mm_sub_epi16(f0, s3));
+      _mm_storeu_si128(out0, _mm_add_epi16(f0, s3));
+      _mm_storeu_si128(out1, _mm_add_epi16(s5, s4));
+      _mm_storeu_si128(out3, _mm_sub_epi16(s5, s4));
+    }
+  }
+}
+#endif  // FFT_SIMD
+
+// Radix 4 stage which combines the FFTs of `length` elements in blocks of four
+// into FFTs of 4 `length` elements, like kf_bfly4().
+void Stage4(Complex* output, size_t size, size_t length) {
+#ifdef FFT_SIMD
+  if (length % 4 == 0) {
+    Stage4Vector(output, size, length);
+    return;
+  }
+#endif
+  const size_t step = kMaxFftSize / (4 * length);
+  for (size_t u = 0; u < length; u++) {
+    const Complex tw1 = twiddles[u * step];
+    const Complex tw2 = twiddles[2 * u * step];
+    const Complex tw3 = twiddles[3 * u * step];
+    for (Complex* out = output + u; out < output + size; out += 4 * length) {
+      const Complex f0 = Divide(out[0], 4);
+      const Complex s0 = Multiply(Divide(out[length], 4), tw1);
+      const Complex s1 = Multiply(Divide(out[2 * length], 4), tw2);
+      const Complex s2 = Multiply(Divide(out[3 * length], 4), tw3);
+      Combine4(f0, s0, s1, s2, &out[0], &out[length], &out[2 * length],
+               &out[3 * length]);
+    }
+  }
+}
+
+// Splits the complex FFT of the even and odd samples into the bins of the
+// real input, in place, like the second half of kiss_fftr().
+void SplitReal(Complex* output, size_t size) {
+  const size_t step = kMaxFftSize / (2 * size);
+  Complex dc = Divide(output[0], 2);
+  output[0] = {(int16_t)(dc.real + dc.imag), 0};
+  output[size] = {(int16_t)(dc.real - dc.imag), 0};
+  for (size_t k = 1; k <= size / 2; k++) {
+    const Complex fpk = Divide(output[k], 2);
+    const Complex fpnk = Divide(
+        {output[size - k].real, (int16_t)-output[size - k].imag}, 2);
+    const Complex f1k = Add(fpk, fpnk);
+    const Complex f2k = Subtract(fpk, fpnk);
+    // e^(-i pi (k / size + 1/2)) = -i e^(-i pi k / size).
+    const Complex twiddle = twiddles[k * step];
+    const Complex tw =
+        Multiply(f2k, {twiddle.imag, (int16_t)-twiddle.real});
+    output[k] = {(int16_t)((f1k.real + tw.real) >> 1),
+                 (int16_t)((f1k.imag + tw.imag) >> 1)};
+    output[size - k] = {(int16_t)((f1k.real - tw.real) >> 1),
+                        (int16_t)((tw.imag - f1k.imag) >> 1)};
+  }
+}
+
+}  // namespace
+
+void FftCompute(struct FftState* state, const int16_t* input,
+                int input_scale_shift) {
+  // The complex FFT of the even and odd samples.
+  const size_t size = state->fft_size / 2;
+  Complex* output = state->output;
+  FirstStage(input, state->input_size, input_scale_shift, output, size);
+  for (size_t length = (Log2(size) & 1) ? 2 : 4; length < size;
+       length *= 4) {
+    Stage4(output, size, length);
+  }
+  SplitReal(output, size);
+}
+
+size_t FftMaxSize(void) { return kMaxFftSize; }
+
 void FftInit(struct FftState* state) {
   // All the initialization is done in FftPopulateState()
 }
 
 void FftReset(struct FftState* state) {
-  memset(state->input, 0, state->fft_size * sizeof(*state->input));
   memset(state->output, 0, (state->fft_size / 2 + 1) * sizeof(*state->output));
 }
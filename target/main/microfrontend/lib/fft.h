@@ -28,17 +28,21 @@ struct complex_int16_t {
 };
 
 struct FftState {
-  int16_t* input;
   struct complex_int16_t* output;
   size_t fft_size;
   size_t input_size;
-  void* scratch;
-  size_t scratch_size;
 };
 
+// Computes the `fft_size / 2 + 1` bins of the real FFT of the `input_size`
+// samples of `input`, shifted left by `input_scale_shift` and padded with zeros
+// to `fft_size`. The result is the same as that of kiss_fftr() of kissfft, bit
+// by bit.
 void FftCompute(struct FftState* state, const int16_t* input,
                 int input_scale_shift);
 
+// Largest supported FFT size.
+size_t FftMaxSize(void);
+
 void FftInit(struct FftState* state);
 
 void FftReset(struct FftState* state);
@@ -18,44 +18,88 @@ limitations under the License.
 
 #include "microfrontend/lib/bits.h"
 
-void FilterbankConvertFftComplexToEnergy(struct FilterbankState* state,
-                                         struct complex_int16_t* fft_output,
-                                         int32_t* energy) {
-  const int end_index = state->end_index;
+// The square magnitude of `value`. It is below 2^31 unless both parts are
+// -32768, where it wraps around to -2^31. The original two-pass version of
+// FilterbankAccumulateEnergy() stored the energy as int32_t and sign extended
+// it to 64 bits, which both versions below keep for the sake of exactness.
+static inline int32_t Energy(const struct complex_int16_t* value) {
+  const int32_t real = value->real;
+  const int32_t imag = value->imag;
+  return (int32_t)((uint32_t)(real * real) + (uint32_t)(imag * imag));
+}
+
+// The 64 bit sum of the 32 bit weighted sums of the upper and lower 16 bits of
+// the energy.
+static inline uint64_t Combine(int32_t high_sum, uint32_t low_sum) {
+  return ((uint64_t)(int64_t)high_sum << 16) + low_sum;
+}
+
+// Each frequency between start_index and end_index belongs to exactly one
+// channel, to whose weight and the next channel's unweight it contributes, so
+// both sums of a channel are accumulated while its frequencies are visited,
+// skipping the zero padding of channel_widths.
+static void AccumulateEnergy32(struct FilterbankState* state,
+                               const struct complex_int16_t* fft_output) {
+  uint64_t* work = state->work;
+  uint64_t unweight_accumulator = 0;
+  int frequency = state->start_index;
+  const int num_channels_plus_1 = state->num_channels + 1;
   int i;
-  energy += state->start_index;
-  fft_output += state->start_index;
-  for (i = state->start_index; i < end_index; ++i) {
-    const int32_t real = fft_output->real;
-    const int32_t imag = fft_output->imag;
-    fft_output++;
-    const uint32_t mag_squared = (real * real) + (imag * imag);
-    *energy++ = mag_squared;
+  for (i = 0; i < num_channels_plus_1; ++i) {
+    const int width = state->actual_channel_widths[i];
+    uint32_t weight_low = 0;
+    int32_t weight_high = 0;
+    uint32_t unweight_low = 0;
+    int32_t unweight_high = 0;
+    if (width > 0) {
+      const int weight_start = state->channel_weight_starts[i] + frequency -
+                               state->channel_frequency_starts[i];
+      const int16_t* weights = state->weights + weight_start;
+      const int16_t* unweights = state->unweights + weight_start;
+      const struct complex_int16_t* bins = fft_output + frequency;
+      int j;
+      for (j = 0; j < width; ++j) {
+        const int32_t energy = Energy(bins++);
+        const uint32_t low = (uint32_t)energy & 0xFFFF;
+        const int32_t high = energy >> 16;
+        const int32_t weight = *weights++;
+        const int32_t unweight = *unweights++;
+        weight_low += (uint32_t)weight * low;
+        weight_high += weight * high;
+        unweight_low += (uint32_t)unweight * low;
+        unweight_high += unweight * high;
+      }
+      frequency += width;
+    }
+    *work++ = unweight_accumulator + Combine(weight_high, weight_low);
+    unweight_accumulator = Combine(unweight_high, unweight_low);
   }
 }
 
-void FilterbankAccumulateChannels(struct FilterbankState* state,
-                                  const int32_t* energy) {
+static void AccumulateEnergy64(struct FilterbankState* state,
+                               const struct complex_int16_t* fft_output) {
   uint64_t* work = state->work;
   uint64_t weight_accumulator = 0;
   uint64_t unweight_accumulator = 0;
-
-  const int16_t* channel_frequency_starts = state->channel_frequency_starts;
-  const int16_t* channel_weight_starts = state->channel_weight_starts;
-  const int16_t* channel_widths = state->channel_widths;
-
-  int num_channels_plus_1 = state->num_channels + 1;
+  int frequency = state->start_index;
+  const int num_channels_plus_1 = state->num_channels + 1;
   int i;
   for (i = 0; i < num_channels_plus_1; ++i) {
-    const int32_t* magnitudes = energy + *channel_frequency_starts++;
-    const int16_t* weights = state->weights + *channel_weight_starts;
-    const int16_t* unweights = state->unweights + *channel_weight_starts++;
-    const int width = *channel_widths++;
-    int j;
-    for (j = 0; j < width; ++j) {
-      weight_accumulator += *weights++ * ((uint64_t)*magnitudes);
-      unweight_accumulator += *unweights++ * ((uint64_t)*magnitudes);
-      ++magnitudes;
+    const int width = state->actual_channel_widths[i];
+    if (width > 0) {
+      const int weight_start = state->channel_weight_starts[i] + frequency -
+                               state->channel_frequency_starts[i];
+      const int16_t* weights = state->weights + weight_start;
+      const int16_t* unweights = state->unweights + weight_start;
+      const struct complex_int16_t* bins = fft_output + frequency;
+      int j;
+      for (j = 0; j < width; ++j) {
+        // A 32 by 32 bit multiplication with a 64 bit result.
+        const int64_t energy = Energy(bins++);
+        weight_accumulator += (uint64_t)(energy * *weights++);
+        unweight_accumulator += (uint64_t)(energy * *unweights++);
+      }
+      frequency += width;
     }
     *work++ = weight_accumulator;
     weight_accumulator = unweight_accumulator;
@@ -63,26 +107,64 @@ void FilterbankAccumulateChannels(struct FilterbankState* state,
   }
 }
 
+void FilterbankAccumulateEnergy(struct FilterbankState* state,
+                                const struct complex_int16_t* fft_output) {
+  if (state->accumulate_32_bit) {
+    AccumulateEnergy32(state, fft_output);
+  } else {
+    AccumulateEnergy64(state, fft_output);
+  }
+}
+
+// Square roots of the 32 bit numbers with one of their two most significant
+// bits set, by their upper 8 bits, i.e. round(sqrt((i + 64.5) * 2^24)) for
+// i = 0 to 191. They are within 2^-8 of the root of every such number.
+static const uint16_t kSqrtLut[192] = {
+    32896, 33150, 33402, 33652, 33900, 34147, 34392, 34635, 34876, 35116,
+    35354, 35590, 35825, 36059, 36291, 36521, 36750, 36978, 37204, 37429,
+    37652, 37874, 38095, 38315, 38533, 38750, 38966, 39181, 39394, 39606,
+    39818, 40028, 40237, 40445, 40652, 40857, 41062, 41266, 41469, 41671,
+    41871, 42071, 42270, 42468, 42665, 42861, 43057, 43251, 43445, 43637,
+    43829, 44020, 44210, 44400, 44588, 44776, 44963, 45149, 45334, 45519,
+    45703, 45886, 46069, 46250, 46431, 46612, 46791, 46970, 47149, 47326,
+    47503, 47679, 47855, 48030, 48204, 48378, 48551, 48723, 48895, 49067,
+    49237, 49407, 49577, 49746, 49914, 50082, 50249, 50416, 50582, 50747,
+    50912, 51077, 51241, 51404, 51567, 51730, 51892, 52053, 52214, 52374,
+    52534, 52694, 52853, 53011, 53169, 53327, 53484, 53640, 53797, 53952,
+    54108, 54262, 54417, 54571, 54724, 54877, 55030, 55182, 55334, 55485,
+    55636, 55787, 55937, 56087, 56236, 56385, 56534, 56682, 56830, 56977,
+    57124, 57271, 57417, 57563, 57709, 57854, 57999, 58143, 58287, 58431,
+    58574, 58717, 58860, 59002, 59144, 59286, 59427, 59568, 59709, 59849,
+    59989, 60129, 60268, 60407, 60546, 60684, 60822, 60960, 61098, 61235,
+    61372, 61508, 61644, 61780, 61916, 62051, 62186, 62321, 62456, 62590,
+    62724, 62857, 62991, 63124, 63256, 63389, 63521, 63653, 63785, 63916,
+    64047, 64178, 64309, 64439, 64569, 64699, 64828, 64957, 65086, 65215,
+    65344, 65472};
+
+// floor(sqrt(num)) for num > 0. The table gives the root of num shifted into
+// its range by an even number of bits to within 2^-8. From there, a single
+// Newton step gives the root or one more than it.
+static uint32_t FloorSqrt32(uint32_t num) {
+  const int shift = CountLeadingZeros32(num) & ~1;
+  const uint32_t estimate =
+      kSqrtLut[((num << shift) >> 24) - 64] >> (shift / 2);
+  uint32_t res = (estimate + num / estimate) >> 1;
+  if (res > 0xFFFF) {
+    res = 0xFFFF;
+  }
+  if (res * res > num) {
+    --res;
+  }
+  return res;
+}
+
 static uint16_t Sqrt32(uint32_t num) {
   if (num == 0) {
     return 0;
   }
-  uint32_t res = 0;
-  int max_bit_number = 32 - MostSignificantBit32(num);
-  max_bit_number |= 1;
-  uint32_t bit = 1U << (31 - max_bit_number);
-  int iterations = (31 - max_bit_number) / 2 + 1;
-  while (iterations--) {
-    if (num >= res + bit) {
-      num -= res + bit;
-      res = (res >> 1U) + bit;
-    } else {
-      res >>= 1U;
-    }
-    bit >>= 2U;
-  }
+  uint32_t res = FloorSqrt32(num);
   // Do rounding - if we have the bits.
-  if (num > res && res != 0xFFFF) {
+  if (num - res * res > res && res != 0xFFFF) {
     ++res;
   }
   return res;
@@ -95,22 +177,27 @@ static uint32_t Sqrt64(uint64_t num) {
   if ((num >> 32) == 0) {
     return Sqrt32((uint32_t)num);
   }
-  uint64_t res = 0;
-  int max_bit_number = 64 - MostSignificantBit64(num);
-  max_bit_number |= 1;
-  uint64_t bit = 1ULL << (63 - max_bit_number);
-  int iterations = (63 - max_bit_number) / 2 + 1;
-  while (iterations--) {
-    if (num >= res + bit) {
-      num -= res + bit;
-      res = (res >> 1U) + bit;
-    } else {
-      res >>= 1U;
-    }
-    bit >>= 2U;
+  // num shifted by an even number of bits into [2^62, 2^64) is a^2 + r, where
+  // a is the root of its upper word shifted up by 16 bits and
+  // r < (2 a + 2^16) 2^16 the remainder. One Newton step from a,
+  // a + floor(r / (2 a)), gives the root or one more than it. The division
+  // fits into 32 bits, as the lower 17 bits of r do not change its result.
+  const int shift = CountLeadingZeros64(num) & ~1;
+  const uint64_t normalized = num << shift;
+  const uint32_t upper = normalized >> 32;
+  const uint32_t upper_root = FloorSqrt32(upper);
+  const uint32_t remainder = ((upper - upper_root * upper_root) << 15) |
+                             ((uint32_t)normalized >> 17);
+  uint64_t res =
+      (((uint64_t)upper_root << 16) + remainder / upper_root) >> (shift / 2);
+  if (res > 0xFFFFFFFF) {
+    res = 0xFFFFFFFF;
+  }
+  if (res * res > num) {
+    --res;
   }
   // Do rounding - if we have the bits.
-  if (num > res && res != 0xFFFFFFFFLL) {
+  if (num - res * res > res && res != 0xFFFFFFFFLL) {
     ++res;
   }
   return res;
@@ -30,28 +30,27 @@ struct FilterbankState {
   int num_channels;
   int start_index;
   int end_index;
-  int16_t* channel_frequency_starts;
-  int16_t* channel_weight_starts;
-  int16_t* channel_widths;
-  int16_t* weights;
-  int16_t* unweights;
+  const int16_t* channel_frequency_starts;
+  const int16_t* channel_weight_starts;
+  const int16_t* channel_widths;
+  const int16_t* actual_channel_widths;
+  const int16_t* weights;
+  const int16_t* unweights;
+  // Whether FilterbankAccumulateEnergy() accumulates in 32 bits, on 32 bit
+  // targets if the weights are small enough, see FilterbankPopulateState().
+  int accumulate_32_bit;
   uint64_t* work;
 };
 
-// Converts the relevant complex values of an FFT output into energy (the
-// square magnitude).
-void FilterbankConvertFftComplexToEnergy(struct FilterbankState* state,
-                                         struct complex_int16_t* fft_output,
-                                         int32_t* energy);
-
-// Computes the mel-scale filterbank on the given energy array. Output is cached
-// internally - to fetch it, you need to call FilterbankSqrt.
-void FilterbankAccumulateChannels(struct FilterbankState* state,
-                                  const int32_t* energy);
+// Computes the energy (the square magnitude) of the relevant complex values of
+// an FFT output and the mel-scale filterbank on it, in a single pass. Output is
+// cached internally - to fetch it, you need to call FilterbankSqrt.
+void FilterbankAccumulateEnergy(struct FilterbankState* state,
+                                const struct complex_int16_t* fft_output);
 
 // Applies an integer square root to the 64 bit intermediate values of the
 // filterbank, and returns a pointer to them. Memory will be invalidated the
-// next time FilterbankAccumulateChannels is called.
+// next time FilterbankAccumulateEnergy is called.
 uint32_t* FilterbankSqrt(struct FilterbankState* state, int scale_down_shift);
 
 void FilterbankReset(struct FilterbankState* state);
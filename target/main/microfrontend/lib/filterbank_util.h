@@ -21,13 +21,27 @@ limitations under the License.
 extern "C" {
 #endif
 
+// Channel layout and weights of the filterbank, for a sample rate, a spectrum
+// size and band limits, see frontend_tables.h.
+struct FilterbankTables {
+  int start_index;
+  int end_index;
+  // num_channels + 1 entries each
+  const int16_t* channel_frequency_starts;
+  const int16_t* channel_weight_starts;
+  const int16_t* channel_widths;
+  // number of frequencies of each channel without the padding of
+  // channel_widths, starting at start_index
+  const int16_t* actual_channel_widths;
+  const int16_t* weights;
+  const int16_t* unweights;
+};
+
 struct FilterbankConfig {
   // number of frequency channel buckets for filterbank
   int num_channels;
-  // maximum frequency to include
-  float upper_band_limit;
-  // minimum frequency to include
-  float lower_band_limit;
+  // channel layout and weights for num_channels
+  const struct FilterbankTables* tables;
   // unused
   int output_scale_shift;
 };
@@ -37,8 +51,7 @@ void FilterbankFillConfigWithDefaults(struct FilterbankConfig* config);
 
 // Allocates any buffers.
 int FilterbankPopulateState(const struct FilterbankConfig* config,
-                            struct FilterbankState* state, int sample_rate,
-                            int spectrum_size);
+                            struct FilterbankState* state, int spectrum_size);
 
 // Frees any allocated buffers.
 void FilterbankFreeStateContents(struct FilterbankState* state);
@@ -15,6 +15,7 @@ limitations under the License.
 #include "microfrontend/lib/frontend.h"
 
 #include "microfrontend/lib/bits.h"
+#include "profiler.h"
 
 struct FrontendOutput FrontendProcessSamples(struct FrontendState* state,
                                              const int16_t* samples,
@@ -25,39 +26,46 @@ struct FrontendOutput FrontendProcessSamples(struct FrontendState* state,
   output.size = 0;
 
   // Try to apply the window - if it fails, return and wait for more data.
-  if (!WindowProcessSamples(&state->window, samples, num_samples,
-                            num_samples_read)) {
+  PROFILE_BEGIN(PROFILE_FRONTEND_WINDOW);
+  const int window_ready = WindowProcessSamples(&state->window, samples,
+                                                num_samples, num_samples_read);
+  PROFILE_END(PROFILE_FRONTEND_WINDOW);
+  if (!window_ready) {
     return output;
   }
 
   // Apply the FFT to the window's output (and scale it so that the fixed point
   // FFT can have as much resolution as possible).
+  PROFILE_BEGIN(PROFILE_FRONTEND_FFT);
   int input_shift =
       15 - MostSignificantBit32(state->window.max_abs_output_value);
   FftCompute(&state->fft, state->window.output, input_shift);
+  PROFILE_END(PROFILE_FRONTEND_FFT);
 
-  // We can re-ruse the fft's output buffer to hold the energy.
-  int32_t* energy = (int32_t*)state->fft.output;
-
-  FilterbankConvertFftComplexToEnergy(&state->filterbank, state->fft.output,
-                                      energy);
-
-  FilterbankAccumulateChannels(&state->filterbank, energy);
+  PROFILE_BEGIN(PROFILE_FRONTEND_FILTERBANK);
+  FilterbankAccumulateEnergy(&state->filterbank, state->fft.output);
   uint32_t* scaled_filterbank = FilterbankSqrt(&state->filterbank, input_shift);
+  PROFILE_END(PROFILE_FRONTEND_FILTERBANK);
 
   // Apply noise reduction.
+  PROFILE_BEGIN(PROFILE_FRONTEND_NOISE_REDUCTION);
   NoiseReductionApply(&state->noise_reduction, scaled_filterbank);
+  PROFILE_END(PROFILE_FRONTEND_NOISE_REDUCTION);
 
   if (state->pcan_gain_control.enable_pcan) {
+    PROFILE_BEGIN(PROFILE_FRONTEND_PCAN);
     PcanGainControlApply(&state->pcan_gain_control, scaled_filterbank);
+    PROFILE_END(PROFILE_FRONTEND_PCAN);
   }
 
   // Apply the log and scale.
+  PROFILE_BEGIN(PROFILE_FRONTEND_LOG_SCALE);
   int correction_bits =
       MostSignificantBit32(state->fft.fft_size) - 1 - (kFilterbankBits / 2);
   uint16_t* logged_filterbank =
       LogScaleApply(&state->log_scale, scaled_filterbank,
                     state->filterbank.num_channels, correction_bits);
+  PROFILE_END(PROFILE_FRONTEND_LOG_SCALE);
 
   output.size = state->filterbank.num_channels;
   output.values = logged_filterbank;
@@ -43,7 +43,7 @@ int FrontendPopulateState(const struct FrontendConfig* config,
   FftInit(&state->fft);
 
   if (!FilterbankPopulateState(&config->filterbank, &state->filterbank,
-                               sample_rate, state->fft.fft_size / 2 + 1)) {
+                               state->fft.fft_size / 2 + 1)) {
     fprintf(stderr, "Failed to populate filterbank state\n");
     return 0;
   }
@@ -60,7 +60,7 @@ int FrontendPopulateState(const struct FrontendConfig* config,
   if (!PcanGainControlPopulateState(
           &config->pcan_gain_control, &state->pcan_gain_control,
           state->noise_reduction.estimate, state->filterbank.num_channels,
-          state->noise_reduction.smoothing_bits, input_correction_bits)) {
+          input_correction_bits)) {
     fprintf(stderr, "Failed to populate pcan gain control state\n");
     return 0;
   }
@@ -81,5 +81,4 @@ void FrontendFreeStateContents(struct FrontendState* state) {
   FftFreeStateContents(&state->fft);
   FilterbankFreeStateContents(&state->filterbank);
   NoiseReductionFreeStateContents(&state->noise_reduction);
-  PcanGainControlFreeStateContents(&state->pcan_gain_control);
 }
@@ -30,7 +30,7 @@ struct PcanGainControlState {
   int enable_pcan;
   uint32_t* noise_estimate;
   int num_channels;
-  int16_t* gain_lut;
+  const int16_t* gain_lut;
   int32_t snr_shift;
 };
 
@@ -27,29 +27,22 @@ extern "C" {
 struct PcanGainControlConfig {
   // set to false (0) to disable this module
   int enable_pcan;
-  // gain normalization exponent (0.0 disables, 1.0 full strength)
-  float strength;
-  // positive value added in the normalization denominator
-  float offset;
   // number of fractional bits in the gain
   int gain_bits;
+  // gain lookup table of kWideDynamicFunctionLUTSize entries, see
+  // frontend_tables.h
+  const int16_t* gain_lut;
 };
 
 void PcanGainControlFillConfigWithDefaults(
     struct PcanGainControlConfig* config);
 
-int16_t PcanGainLookupFunction(const struct PcanGainControlConfig* config,
-                               int32_t input_bits, uint32_t x);
-
 int PcanGainControlPopulateState(const struct PcanGainControlConfig* config,
                                  struct PcanGainControlState* state,
                                  uint32_t* noise_estimate,
                                  const int num_channels,
-                                 const uint16_t smoothing_bits,
                                  const int32_t input_correction_bits);
 
-void PcanGainControlFreeStateContents(struct PcanGainControlState* state);
-
 #ifdef __cplusplus
 }  // extern "C"
 #endif
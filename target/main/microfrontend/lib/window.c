@@ -16,45 +16,150 @@ limitations under the License.
 
 #include <string.h>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define WINDOW_SIMD 1
+#endif
+
+// Multiplies `size` samples with the window coefficients and returns the
+// largest absolute output value, or `max_abs_output_value` if that is larger.
+// Just like the negation in the original loop, the absolute value of -32768
+// wraps around, so it never counts. Without the branch, the compiler turns the
+// loop into conditional moves.
+static int16_t ApplyWindowScalar(const int16_t* input,
+                                 const int16_t* coefficients, int16_t* output,
+                                 size_t size, int16_t max_abs_output_value) {
+  size_t i;
+  for (i = 0; i < size; ++i) {
+    const int16_t new_value =
+        (((int32_t)input[i]) * coefficients[i]) >> kFrontendWindowBits;
+    output[i] = new_value;
+    const int16_t sign = new_value >> 15;
+    const int16_t abs_value = (new_value ^ sign) - sign;
+    if (abs_value > max_abs_output_value) {
+      max_abs_output_value = abs_value;
+    }
+  }
+  return max_abs_output_value;
+}
+
+#ifdef WINDOW_SIMD
+// The same with GCC vector extensions, 8 samples at a time with SSE2 and 16
+// with AVX2. The window output consists of bits 12 to 27 of the 32 bit
+// products. They are put together from the low and high halves of the
+// products, from pmullw and pmulhw, so the samples never have to be widened to
+// 32 bits. GCC does not derive pmulhw from vector extensions, so it is the only
+// intrinsic. The absolute values and their maximum are computed right away
+// while the outputs are still in registers.
+#define DEFINE_APPLY_WINDOW_VECTOR(name, isa, vector_bytes, mulhi)             \
+  typedef int16_t name##_vector_t                                              \
+      __attribute__((vector_size(vector_bytes)));                              \
+  typedef uint16_t name##_uvector_t                                            \
+      __attribute__((vector_size(vector_bytes)));                              \
+  __attribute__((target(isa))) static int16_t name(                            \
+      const int16_t* input, const int16_t* coefficients, int16_t* output,      \
+      size_t size, int16_t max_abs_output_value) {                             \
+    const size_t lanes = vector_bytes / sizeof(int16_t);                       \
+    name##_vector_t max_abs = {0};                                             \
+    size_t i;                                                                  \
+    for (i = 0; i + lanes <= size; i += lanes) {                               \
+      name##_vector_t samples;                                                 \
+      name##_vector_t window;                                                  \
+      memcpy(&samples, &input[i], sizeof(samples));                            \
+      memcpy(&window, &coefficients[i], sizeof(window));                       \
+      const name##_vector_t low = samples * window;                            \
+      const name##_vector_t high = (name##_vector_t)mulhi(samples, window);    \
+      const name##_vector_t new_value =                                        \
+          (name##_vector_t)((name##_uvector_t)low >> kFrontendWindowBits) |    \
+          (high << (16 - kFrontendWindowBits));                                \
+      memcpy(&output[i], &new_value, sizeof(new_value));                       \
+      const name##_vector_t sign = new_value >> 15;                            \
+      const name##_vector_t abs_value = (new_value ^ sign) - sign;             \
+      const name##_vector_t larger = abs_value > max_abs;                      \
+      max_abs = (abs_value & larger) | (max_abs & ~larger);                    \
+    }                                                                          \
+    size_t lane;                                                               \
+    for (lane = 0; lane < lanes; ++lane) {                                     \
+      if (max_abs[lane] > max_abs_output_value) {                              \
+        max_abs_output_value = max_abs[lane];                                  \
+      }                                                                        \
+    }                                                                          \
+    return ApplyWindowScalar(&input[i], &coefficients[i], &output[i],          \
+                             size - i, max_abs_output_value);                  \
+  }
+
+#define WINDOW_MULHI_SSE2(a, b) _mm_mulhi_epi16((__m128i)(a), (__m128i)(b))
+#define WINDOW_MULHI_AVX2(a, b) _mm256_mulhi_epi16((__m256i)(a), (__m256i)(b))
+
+DEFINE_APPLY_WINDOW_VECTOR(ApplyWindowSse2, "sse2", 16, WINDOW_MULHI_SSE2)
+DEFINE_APPLY_WINDOW_VECTOR(ApplyWindowAvx2, "avx2", 32, WINDOW_MULHI_AVX2)
+#endif  // WINDOW_SIMD
+
+// The RV32IMC core of the ESP32-C3 has no packed multiplies, and two samples
+// packed into one register can not be multiplied without their products
+// overlapping. So it gets the scalar loop, which at least has the maximum
+// fused into it.
+static int16_t ApplyWindow(const int16_t* input, const int16_t* coefficients,
+                           int16_t* output, size_t size,
+                           int16_t max_abs_output_value) {
+#ifdef WINDOW_SIMD
+  if (__builtin_cpu_supports("avx2")) {
+    return ApplyWindowAvx2(input, coefficients, output, size,
+                           max_abs_output_value);
+  }
+  return ApplyWindowSse2(input, coefficients, output, size,
+                         max_abs_output_value);
+#else
+  return ApplyWindowScalar(input, coefficients, output, size,
+                           max_abs_output_value);
+#endif  // WINDOW_SIMD
+}
+
 int WindowProcessSamples(struct WindowState* state, const int16_t* samples,
                          size_t num_samples, size_t* num_samples_read) {
-  const int size = state->size;
+  const size_t size = state->size;
 
-  // Copy samples from the samples buffer over to our local input.
-  size_t max_samples_to_copy = state->size - state->input_used;
+  // Copy samples from the samples buffer over to our local input, behind the
+  // ones we already have. They might wrap around the end of the ring buffer.
+  size_t max_samples_to_copy = size - state->input_used;
   if (max_samples_to_copy > num_samples) {
     max_samples_to_copy = num_samples;
   }
-  memcpy(state->input + state->input_used, samples,
-         max_samples_to_copy * sizeof(*samples));
+  size_t input_end = state->input_start + state->input_used;
+  if (input_end >= size) {
+    input_end -= size;
+  }
+  size_t samples_to_end = size - input_end;
+  if (samples_to_end > max_samples_to_copy) {
+    samples_to_end = max_samples_to_copy;
+  }
+  memcpy(state->input + input_end, samples, samples_to_end * sizeof(*samples));
+  if (max_samples_to_copy > samples_to_end) {
+    memcpy(state->input, samples + samples_to_end,
+           (max_samples_to_copy - samples_to_end) * sizeof(*samples));
+  }
   *num_samples_read = max_samples_to_copy;
   state->input_used += max_samples_to_copy;
 
-  if (state->input_used < state->size) {
+  if (state->input_used < size) {
     // We don't have enough samples to compute a window.
     return 0;
   }
 
-  // Apply the window to the input.
-  const int16_t* coefficients = state->coefficients;
-  const int16_t* input = state->input;
-  int16_t* output = state->output;
-  int i;
-  int16_t max_abs_output_value = 0;
-  for (i = 0; i < size; ++i) {
-    int16_t new_value =
-        (((int32_t)*input++) * *coefficients++) >> kFrontendWindowBits;
-    *output++ = new_value;
-    if (new_value < 0) {
-      new_value = -new_value;
-    }
-    if (new_value > max_abs_output_value) {
-      max_abs_output_value = new_value;
-    }
+  // Apply the window to the input, in two parts if it wraps around.
+  const size_t head_size = size - state->input_start;
+  int16_t max_abs_output_value =
+      ApplyWindow(state->input + state->input_start, state->coefficients,
+                  state->output, head_size, 0);
+  max_abs_output_value = ApplyWindow(
+      state->input, state->coefficients + head_size,
+      state->output + head_size, state->input_start, max_abs_output_value);
+
+  // Step forward, and update how much we have used.
+  state->input_start += state->step;
+  if (state->input_start >= size) {
+    state->input_start -= size;
   }
-  // Shuffle the input down by the step size, and update how much we have used.
-  memmove(state->input, state->input + state->step,
-          sizeof(*state->input) * (state->size - state->step));
   state->input_used -= state->step;
   state->max_abs_output_value = max_abs_output_value;
 
@@ -65,6 +170,7 @@ int WindowProcessSamples(struct WindowState* state, const int16_t* samples,
 void WindowReset(struct WindowState* state) {
   memset(state->input, 0, state->size * sizeof(*state->input));
   memset(state->output, 0, state->size * sizeof(*state->output));
+  state->input_start = 0;
   state->input_used = 0;
   state->max_abs_output_value = 0;
 }
@@ -26,10 +26,14 @@ extern "C" {
 
 struct WindowState {
   size_t size;
-  int16_t* coefficients;
+  const int16_t* coefficients;
   size_t step;
 
+  // Ring buffer of `size` samples. The `input_used` samples of the next window
+  // start at `input_start` and wrap around the end, so that stepping forward
+  // does not have to move the samples.
   int16_t* input;
+  size_t input_start;
   size_t input_used;
   int16_t* output;
   int16_t max_abs_output_value;
@@ -14,19 +14,14 @@ limitations under the License.
 ==============================================================================*/
 #include "microfrontend/lib/window_util.h"
 
-#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-// Some platforms don't have M_PI
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
-
 void WindowFillConfigWithDefaults(struct WindowConfig* config) {
   config->size_ms = 25;
   config->step_size_ms = 10;
+  config->coefficients = NULL;
 }
 
 int WindowPopulateState(const struct WindowConfig* config,
@@ -34,22 +29,13 @@ int WindowPopulateState(const struct WindowConfig* config,
   state->size = config->size_ms * sample_rate / 1000;
   state->step = config->step_size_ms * sample_rate / 1000;
 
-  state->coefficients = malloc(state->size * sizeof(*state->coefficients));
+  state->coefficients = config->coefficients;
   if (state->coefficients == NULL) {
-    fprintf(stderr, "Failed to allocate window coefficients\n");
+    fprintf(stderr, "Missing window coefficients\n");
     return 0;
   }
 
-  // Populate the window values.
-  const float arg = M_PI * 2.0 / ((float)state->size);
-  int i;
-  for (i = 0; i < state->size; ++i) {
-    float float_value = 0.5 - (0.5 * cos(arg * (i + 0.5)));
-    // Scale it to fixed point and round it.
-    state->coefficients[i] =
-        floor(float_value * (1 << kFrontendWindowBits) + 0.5);
-  }
-
+  state->input_start = 0;
   state->input_used = 0;
   state->input = malloc(state->size * sizeof(*state->input));
   if (state->input == NULL) {
@@ -67,7 +53,6 @@ int WindowPopulateState(const struct WindowConfig* config,
 }
 
 void WindowFreeStateContents(struct WindowState* state) {
-  free(state->coefficients);
   free(state->input);
   free(state->output);
 }
@@ -26,6 +26,8 @@ struct WindowConfig {
   size_t size_ms;
   // length of step for next frame in milliseconds
   size_t step_size_ms;
+  // window coefficients for size_ms at the sample rate, see frontend_tables.h
+  const int16_t* coefficients;
 };
 
 // Populates the WindowConfig with "sane" default values.
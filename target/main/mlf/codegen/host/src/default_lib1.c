@@ -3,6 +3,9 @@
 #include "tvm/runtime/c_runtime_api.h"
 #include "tvm/runtime/c_backend_api.h"
 #include <math.h>
+#include <string.h>
+
+#include <tvmgen_default.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -1330,6 +1333,92 @@ TVM_DLL int32_t tvmgen_default_fused_reshape_layout_transform_cast_subtract_layo
   return 0;
 }
 
+// The following functions are not generated by TVM. They evaluate the first
+// convolution incrementally, see tvmgen_default_set_stream_position().
+//
+// Output row r of the convolution (stride 2, 5 kernel rows, 2 rows of zero
+// padding on either side) only depends on the input rows 2r-2..2r+2. If the
+// absolute index of the first input row is known, row r can therefore be keyed
+// by its center row position+2r and reused by later windows, as long as all 5
+// input rows lie inside the window. This holds for all rows except the first
+// and the last one, which also read the padding. As the window moves by one
+// slice at a time, both even and odd centers occur, so the cache has to hold
+// two rows per stride: 46 of its 64 entries are in use at any time.
+#define TVMGEN_DEFAULT_STREAM_ROWS 25
+#define TVMGEN_DEFAULT_STREAM_ROW_SIZE 80
+#define TVMGEN_DEFAULT_STREAM_CACHE_LENGTH 64
+
+static int8_t tvmgen_default_stream_cache[TVMGEN_DEFAULT_STREAM_CACHE_LENGTH][TVMGEN_DEFAULT_STREAM_ROW_SIZE];
+static uint32_t tvmgen_default_stream_cache_center[TVMGEN_DEFAULT_STREAM_CACHE_LENGTH];
+static uint32_t tvmgen_default_stream_position = 0;
+static int32_t tvmgen_default_stream_enabled = 0;
+
+void tvmgen_default_reset_stream(void) {
+  tvmgen_default_stream_enabled = 0;
+}
+
+void tvmgen_default_set_stream_position(uint32_t position) {
+  if (!tvmgen_default_stream_enabled) {
+    for (int32_t i = 0; i < TVMGEN_DEFAULT_STREAM_CACHE_LENGTH; ++i) {
+      // Lies before the centers of this and all following windows.
+      tvmgen_default_stream_cache_center[i] = position - 1;
+    }
+    tvmgen_default_stream_enabled = 1;
+  }
+  tvmgen_default_stream_position = position;
+}
+
+// Computes output row `row` of
+// tvmgen_default_fused_reshape_layout_transform_cast_subtract_layout_transform
+// followed by
+// tvmgen_default_fused_nn_contrib_conv2d_NCHWc_add_cast_multiply_add_right_shift_cast_add_clip_ca_41d3203833793a2a_
+// directly from the int8 input, with bit-exact results. The padding is skipped
+// instead of being materialized.
+static void tvmgen_default_stream_conv2d_row(const int8_t* placeholder, int32_t row, int8_t* compute) {
+  for (int32_t ow = 0; ow < 20; ++ow) {
+    int32_t acc[4] = {0, 0, 0, 0};
+    for (int32_t kh = 0; kh < 5; ++kh) {
+      const int32_t ih = ((row * 2) + kh) - 2;
+      if ((ih < 0) || (49 <= ih)) {
+        continue;
+      }
+      for (int32_t kw = 0; kw < 4; ++kw) {
+        const int32_t iw = ((ow * 2) + kw) - 1;
+        if ((iw < 0) || (40 <= iw)) {
+          continue;
+        }
+        const int32_t x = ((int32_t)placeholder[(ih * 40) + iw]) + 128;
+        for (int32_t oc = 0; oc < 4; ++oc) {
+          acc[oc] += x * ((int32_t)constant_0[((kh * 16) + (kw * 4)) + oc]);
+        }
+      }
+    }
+    for (int32_t oc = 0; oc < 4; ++oc) {
+      int32_t _1 = ((int32_t)((((((int64_t)acc[oc]) + ((int64_t)constant_1[oc])) * constant_2[oc]) + constant_3[oc]) >> constant_4[oc])) - 128;
+      int32_t _2 = (_1) < (127) ? (_1) : (127);
+      compute[(ow * 4) + oc] = (int8_t)((_2) > (-128) ? (_2) : (-128));
+    }
+  }
+}
+
+static int32_t tvmgen_default_stream_conv2d(int8_t* placeholder, int8_t* compute) {
+  for (int32_t row = 0; row < TVMGEN_DEFAULT_STREAM_ROWS; ++row) {
+    int8_t* compute_row = &(compute[row * TVMGEN_DEFAULT_STREAM_ROW_SIZE]);
+    if ((row == 0) || (row == (TVMGEN_DEFAULT_STREAM_ROWS - 1))) {
+      tvmgen_default_stream_conv2d_row(placeholder, row, compute_row);
+      continue;
+    }
+    const uint32_t center = tvmgen_default_stream_position + (uint32_t)(row * 2);
+    const uint32_t slot = center & (TVMGEN_DEFAULT_STREAM_CACHE_LENGTH - 1);
+    if (tvmgen_default_stream_cache_center[slot] != center) {
+      tvmgen_default_stream_conv2d_row(placeholder, row, tvmgen_default_stream_cache[slot]);
+      tvmgen_default_stream_cache_center[slot] = center;
+    }
+    memcpy(compute_row, tvmgen_default_stream_cache[slot], TVMGEN_DEFAULT_STREAM_ROW_SIZE);
+  }
+  return 0;
+}
+
 #ifdef __cplusplus
 extern "C"
 #endif
@@ -1338,8 +1427,12 @@ TVM_DLL int32_t tvmgen_default___tvm_main__(int8_t* serving_default_input_0_buff
   void* sid_4_let = (&(global_workspace_0_var[0]));
   void* sid_3_let = (&(global_workspace_0_var[0]));
   void* sid_1_let = (&(global_workspace_0_var[4464]));
-  if (tvmgen_default_fused_reshape_layout_transform_cast_subtract_layout_transform(serving_default_input_0_buffer_var, sid_1_let, global_workspace_0_var) != 0 ) return -1;
-  if (tvmgen_default_fused_nn_contrib_conv2d_NCHWc_add_cast_multiply_add_right_shift_cast_add_clip_ca_41d3203833793a2a_(sid_1_let, sid_2_let, global_workspace_0_var) != 0 ) return -1;
+  if (tvmgen_default_stream_enabled) {
+    if (tvmgen_default_stream_conv2d(serving_default_input_0_buffer_var, sid_2_let) != 0 ) return -1;
+  } else {
+    if (tvmgen_default_fused_reshape_layout_transform_cast_subtract_layout_transform(serving_default_input_0_buffer_var, sid_1_let, global_workspace_0_var) != 0 ) return -1;
+    if (tvmgen_default_fused_nn_contrib_conv2d_NCHWc_add_cast_multiply_add_right_shift_cast_add_clip_ca_41d3203833793a2a_(sid_1_let, sid_2_let, global_workspace_0_var) != 0 ) return -1;
+  }
   if (tvmgen_default_fused_layout_transform_layout_transform_reshape_cast_subtract(sid_2_let, sid_3_let, global_workspace_0_var) != 0 ) return -1;
   if (tvmgen_default_fused_nn_contrib_dense_pack_add_fixed_point_multiply_add_clip_cast_cast_subtract_b438993967aa395c_(sid_3_let, sid_4_let, global_workspace_0_var) != 0 ) return -1;
   if (tvmgen_default_fused_nn_softmax_divide_add_clip_round_cast(sid_4_let, StatefulPartitionedCall_0_buffer_var, global_workspace_0_var) != 0 ) return -1;
@@ -0,0 +1,38 @@
+#[[
+Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+
+This file is part of MLonMCU.
+See https://github.com/tum-ei-eda/mlonmcu.git for further info.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+]]
+
+# Reads the memory requirements of the model's main function from the metadata.json of an MLF and passes them to the
+# sources of TARGET as MICRO_KWS_MLF_WORKSPACE_SIZE and MICRO_KWS_MLF_CONSTANTS_SIZE, see memory_report.cc. A relative
+# MLF_DIR is resolved from the directory of the calling CMakeLists.txt. The file is small and written by TVM with sorted
+# keys, so a regular expression is sufficient and works with any CMake version.
+function(micro_kws_add_mlf_memory TARGET MLF_DIR)
+    get_filename_component(METADATA_FILE ${MLF_DIR}/metadata.json ABSOLUTE BASE_DIR ${CMAKE_CURRENT_LIST_DIR})
+    file(READ ${METADATA_FILE} METADATA)
+    set(DEFINITIONS "")
+    foreach(FIELD workspace constants)
+        if(NOT METADATA MATCHES "\"main\": *\\[[^]]*\"${FIELD}_size_bytes\": *([0-9]+)")
+            message(FATAL_ERROR "Could not find ${FIELD}_size_bytes of the main function in ${METADATA_FILE}")
+        endif()
+        string(TOUPPER ${FIELD} NAME)
+        set(${NAME}_SIZE ${CMAKE_MATCH_1})
+        list(APPEND DEFINITIONS MICRO_KWS_MLF_${NAME}_SIZE=${CMAKE_MATCH_1})
+    endforeach()
+    message(STATUS "MicroKWS MLF memory: workspace ${WORKSPACE_SIZE}, constants ${CONSTANTS_SIZE} bytes")
+    target_compile_definitions(${TARGET} PRIVATE ${DEFINITIONS})
+endfunction()
@@ -34,6 +34,34 @@ int32_t tvmgen_default_run(
  */
 #define TVMGEN_DEFAULT_WORKSPACE_SIZE 8384
 
+/*!
+ * \brief Defined if the module supports the incremental evaluation of the first
+ * convolution. Not generated by TVM, see default_lib1.c.
+ */
+#define TVMGEN_DEFAULT_HAS_STREAM 1
+
+/*!
+ * \brief Static memory used by the incremental evaluation in bytes, i.e. 64
+ * cached rows of 80 bytes plus their input positions.
+ */
+#define TVMGEN_DEFAULT_STREAM_CACHE_SIZE 5376
+
+/*!
+ * \brief Announces that the input of the next run is the window starting at
+ * the absolute input row \p position. Rows of the first convolution whose input
+ * rows were already part of a previous window are taken from a cache instead of
+ * being recomputed, so the input rows have to stay the same for a given
+ * absolute index. Has to be called before every run.
+ * \param position Absolute index of the first input row
+ */
+void tvmgen_default_set_stream_position(uint32_t position);
+
+/*!
+ * \brief Drops the cached rows and evaluates the full model again until the
+ * next call of tvmgen_default_set_stream_position().
+ */
+void tvmgen_default_reset_stream(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -21,16 +21,30 @@
 #ifndef MODEL_SETTINGS_H
 #define MODEL_SETTINGS_H
 
+#include <cstddef>
 #include <cstdint>
 
 #include "sdkconfig.h"
 
+// Sample rate of the frontend, 16 kHz or 8 kHz in the low power mode.
+constexpr int32_t audio_sample_frequency =
+    CONFIG_MICRO_KWS_AUDIO_SAMPLE_FREQUENCY;
 // The size of the input time series data we pass to the FFT to produce the
 // frequency information. This has to be a power of two, and since we're dealing
 // with 30ms of 16KHz inputs, which means 480 samples, this is the next larger
-// value, i.e. 512.
-constexpr int32_t max_audio_sample_size = 512;
-constexpr int32_t audio_sample_frequency = 16000;
+// value, i.e. 512. At 8KHz, it is 256 for 240 samples.
+constexpr int32_t max_audio_sample_size = audio_sample_frequency / 1000 * 32;
+// Sample rate of the audio source. The capture task resamples it to
+// audio_sample_frequency if they differ, see resampler.h.
+constexpr int32_t audio_capture_frequency =
+    CONFIG_MICRO_KWS_AUDIO_CAPTURE_FREQUENCY;
+// Number of microphones the audio source reads, and the number of channels
+// that are processed separately by the frontend and the model. With two
+// microphones and one processed channel, the capture task combines them with
+// a beamformer, see beamformer.h.
+constexpr size_t audio_capture_channels =
+    CONFIG_MICRO_KWS_AUDIO_CAPTURE_CHANNELS;
+constexpr size_t audio_channels = CONFIG_MICRO_KWS_AUDIO_CHANNELS;
 
 // The feature (powerspectrum image) on which the convolutional neural network
 // operates on has 49 slices, each containing 40 grayscale pixels. So basically
@@ -42,6 +56,9 @@ constexpr int32_t feature_element_count =
 
 constexpr int32_t feature_slice_stride_ms = CONFIG_MICRO_KWS_STRIDE_SIZE_MS;
 constexpr int32_t feature_slice_duration_ms = CONFIG_MICRO_KWS_WINDOW_SIZE_MS;
+// Number of new audio samples needed for every new slice.
+constexpr int32_t feature_slice_stride_samples =
+    audio_sample_frequency * feature_slice_stride_ms / 1000;
 
 constexpr int32_t category_count = CONFIG_MICRO_KWS_NUM_CLASSES;
 extern const char* category_labels[category_count];
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pipeline_stats.h"
+
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+
+// Every counter is only ever written by one of the two stages, so plain atomic
+// loads and stores are sufficient. The relaxed ordering is fine as the counters
+// are only informative and do not guard any other data.
+static std::atomic<uint32_t> slices_produced{0};
+static std::atomic<uint32_t> queue_full_count{0};
+static std::atomic<uint32_t> frontend_us{0};
+static std::atomic<uint32_t> frontend_us_max{0};
+
+static std::atomic<uint32_t> slices_consumed{0};
+static std::atomic<uint32_t> queue_depth{0};
+static std::atomic<uint32_t> queue_depth_max{0};
+static std::atomic<uint32_t> inferences_run{0};
+static std::atomic<uint32_t> inferences_skipped{0};
+static std::atomic<uint32_t> inference_us{0};
+static std::atomic<uint32_t> inference_us_max{0};
+static std::atomic<uint32_t> slice_latency_us{0};
+static std::atomic<uint32_t> slice_latency_us_max{0};
+
+static void StoreWithMax(std::atomic<uint32_t>* value,
+                         std::atomic<uint32_t>* max, uint32_t new_value) {
+  value->store(new_value, std::memory_order_relaxed);
+  if (new_value > max->load(std::memory_order_relaxed)) {
+    max->store(new_value, std::memory_order_relaxed);
+  }
+}
+
+void RecordFrontendStage(uint32_t num_slices, uint32_t duration_us,
+                         bool queue_full) {
+  if (queue_full) {
+    queue_full_count.store(
+        queue_full_count.load(std::memory_order_relaxed) + 1,
+        std::memory_order_relaxed);
+  }
+  if (num_slices == 0) {
+    return;
+  }
+  slices_produced.store(
+      slices_produced.load(std::memory_order_relaxed) + num_slices,
+      std::memory_order_relaxed);
+  StoreWithMax(&frontend_us, &frontend_us_max, duration_us / num_slices);
+}
+
+void RecordInferenceStage(uint32_t num_slices, uint32_t latency_us,
+                          uint32_t duration_us) {
+  slices_consumed.store(
+      slices_consumed.load(std::memory_order_relaxed) + num_slices,
+      std::memory_order_relaxed);
+  StoreWithMax(&queue_depth, &queue_depth_max, num_slices);
+  inferences_run.store(inferences_run.load(std::memory_order_relaxed) + 1,
+                       std::memory_order_relaxed);
+  StoreWithMax(&slice_latency_us, &slice_latency_us_max, latency_us);
+  StoreWithMax(&inference_us, &inference_us_max, duration_us);
+}
+
+void RecordSkippedInference(uint32_t num_slices) {
+  slices_consumed.store(
+      slices_consumed.load(std::memory_order_relaxed) + num_slices,
+      std::memory_order_relaxed);
+  StoreWithMax(&queue_depth, &queue_depth_max, num_slices);
+  inferences_skipped.store(
+      inferences_skipped.load(std::memory_order_relaxed) + 1,
+      std::memory_order_relaxed);
+}
+
+pipeline_stats_t GetPipelineStats() {
+  pipeline_stats_t stats;
+  stats.slices_produced = slices_produced.load(std::memory_order_relaxed);
+  stats.slices_consumed = slices_consumed.load(std::memory_order_relaxed);
+  stats.queue_full_count = queue_full_count.load(std::memory_order_relaxed);
+  stats.queue_depth = queue_depth.load(std::memory_order_relaxed);
+  stats.queue_depth_max = queue_depth_max.load(std::memory_order_relaxed);
+  stats.inferences_run = inferences_run.load(std::memory_order_relaxed);
+  stats.inferences_skipped =
+      inferences_skipped.load(std::memory_order_relaxed);
+  stats.frontend_us = frontend_us.load(std::memory_order_relaxed);
+  stats.frontend_us_max = frontend_us_max.load(std::memory_order_relaxed);
+  stats.inference_us = inference_us.load(std::memory_order_relaxed);
+  stats.inference_us_max = inference_us_max.load(std::memory_order_relaxed);
+  stats.slice_latency_us = slice_latency_us.load(std::memory_order_relaxed);
+  stats.slice_latency_us_max =
+      slice_latency_us_max.load(std::memory_order_relaxed);
+  return stats;
+}
+
+esp_err_t PrintPipelineStats() {
+  const pipeline_stats_t stats = GetPipelineStats();
+  printf("Pipeline: slices %" PRIu32 "/%" PRIu32
+         " (produced/consumed), queue depth %" PRIu32 " (max %" PRIu32
+         "), queue full %" PRIu32 "\n",
+         stats.slices_produced, stats.slices_consumed, stats.queue_depth,
+         stats.queue_depth_max, stats.queue_full_count);
+  printf("Pipeline: inferences %" PRIu32 "/%" PRIu32 " (run/skipped)\n",
+         stats.inferences_run, stats.inferences_skipped);
+  printf("Pipeline: frontend %" PRIu32 "us/slice (max %" PRIu32
+         "), inference %" PRIu32 "us (max %" PRIu32 "), slice latency %" PRIu32
+         "us (max %" PRIu32 ")\n",
+         stats.frontend_us, stats.frontend_us_max, stats.inference_us,
+         stats.inference_us_max, stats.slice_latency_us,
+         stats.slice_latency_us_max);
+  return ESP_OK;
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PIPELINE_STATS_H
+#define PIPELINE_STATS_H
+
+#include <cstdint>
+
+#include "esp_err.h"
+
+// Counters describing the flow of feature slices from the frontend stage to the
+// inference stage. All durations are in microseconds.
+typedef struct {
+  // Total number of slices generated by the frontend stage.
+  uint32_t slices_produced;
+  // Total number of slices taken from the queue by the inference stage.
+  uint32_t slices_consumed;
+  // How often the frontend stage had to stop because the queue was full. In
+  // this case the audio data stays in the audio queue for now.
+  uint32_t queue_full_count;
+  // Number of queued slices found by the last inference and the maximum so
+  // far. Anything above one means that the inference stage falls behind.
+  uint32_t queue_depth;
+  uint32_t queue_depth_max;
+  // Number of inferences run and skipped because of the voice activity
+  // detection.
+  uint32_t inferences_run;
+  uint32_t inferences_skipped;
+  // Time spent in the frontend per slice.
+  uint32_t frontend_us;
+  uint32_t frontend_us_max;
+  // Time spent in model_invoke().
+  uint32_t inference_us;
+  uint32_t inference_us_max;
+  // Age of the newest slice when the inference using it started.
+  uint32_t slice_latency_us;
+  uint32_t slice_latency_us_max;
+} pipeline_stats_t;
+
+// Called by the frontend stage after generating `num_slices` new slices in
+// `duration_us`.
+void RecordFrontendStage(uint32_t num_slices, uint32_t duration_us,
+                         bool queue_full);
+
+// Called by the inference stage after taking all `num_slices` queued slices and
+// running the model.
+void RecordInferenceStage(uint32_t num_slices, uint32_t slice_latency_us,
+                          uint32_t duration_us);
+
+// Called by the inference stage instead of RecordInferenceStage() if it took
+// the `num_slices` queued slices but skipped the model.
+void RecordSkippedInference(uint32_t num_slices);
+
+// Returns a snapshot of the current counters.
+pipeline_stats_t GetPipelineStats();
+
+esp_err_t PrintPipelineStats();
+
+#endif  // PIPELINE_STATS_H
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "profiler.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+#ifdef CONFIG_MICRO_KWS_PROFILE
+
+#if CONFIG_IDF_TARGET_LINUX
+// The esp_cpu_get_ccount() of the host build counts nanoseconds.
+constexpr uint32_t cycles_per_us = 1000;
+#elif CONFIG_IDF_TARGET_ESP32C3
+constexpr uint32_t cycles_per_us = CONFIG_ESP32C3_DEFAULT_CPU_FREQ_MHZ;
+#elif CONFIG_IDF_TARGET_ESP32
+constexpr uint32_t cycles_per_us = CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ;
+#else
+#error "ESP-IDF target not supported by the profiler."
+#endif
+
+static const char* probe_names[PROFILE_PROBE_COUNT] = {
+    "audio_receive",
+    "audio_resample",
+    "audio_channels",
+    "frontend",
+    "frontend_window",
+    "frontend_fft",
+    "frontend_filterbank",
+    "frontend_noise",
+    "frontend_pcan",
+    "frontend_log",
+    "feature_window",
+    "model_invoke",
+    "posteriors",
+    "keyword_audio",
+    "debug_run",
+};
+
+// Every power of two is split into four buckets, so the percentiles are off by
+// at most 12.5%. Values below four cycles get a bucket each.
+constexpr size_t sub_bucket_bits = 2;
+constexpr size_t sub_bucket_count = 1 << sub_bucket_bits;
+constexpr size_t bucket_count = (32 - sub_bucket_bits + 1) * sub_bucket_count;
+
+typedef struct {
+  uint32_t count;
+  uint32_t max;
+  uint64_t sum;
+  uint32_t buckets[bucket_count];
+} histogram_t;
+
+// Each probe is only ever hit by one task. Printing from another task might
+// see a histogram in the middle of an update, which is fine for statistics.
+static histogram_t histograms[PROFILE_PROBE_COUNT];
+
+static size_t BucketIndex(uint32_t cycles) {
+  if (cycles < sub_bucket_count) {
+    return cycles;
+  }
+  const size_t msb = 31 - __builtin_clz(cycles);
+  const size_t sub_bucket =
+      (cycles >> (msb - sub_bucket_bits)) & (sub_bucket_count - 1);
+  return (msb - sub_bucket_bits + 1) * sub_bucket_count + sub_bucket;
+}
+
+// Value in the middle of bucket `index`.
+static uint32_t BucketValue(size_t index) {
+  if (index < sub_bucket_count) {
+    return index;
+  }
+  const size_t msb = index / sub_bucket_count + sub_bucket_bits - 1;
+  const uint64_t sub_bucket = index % sub_bucket_count;
+  const uint64_t lower = (sub_bucket_count + sub_bucket)
+                         << (msb - sub_bucket_bits);
+  const uint64_t width = (uint64_t)1 << (msb - sub_bucket_bits);
+  return (uint32_t)(lower + width / 2);
+}
+
+static uint32_t Percentile(const histogram_t* histogram, uint32_t percent) {
+  // Rank of the requested value, rounded up.
+  const uint64_t rank = ((uint64_t)histogram->count * percent + 99) / 100;
+  uint64_t seen = 0;
+  for (size_t i = 0; i < bucket_count; i++) {
+    seen += histogram->buckets[i];
+    if (seen >= rank) {
+      const uint32_t value = BucketValue(i);
+      return value < histogram->max ? value : histogram->max;
+    }
+  }
+  return histogram->max;
+}
+
+// Prints `cycles` in microseconds with two decimal places, as the newlib nano
+// printf does not support floats.
+static void PrintMicroseconds(uint64_t cycles) {
+  const uint64_t hundredths = cycles * 100 / cycles_per_us;
+  printf(" %6" PRIu32 ".%02" PRIu32, (uint32_t)(hundredths / 100),
+         (uint32_t)(hundredths % 100));
+}
+
+void ProfilerRecord(profile_probe_t probe, uint32_t cycles) {
+  histogram_t* histogram = &histograms[probe];
+  histogram->count++;
+  histogram->sum += cycles;
+  if (cycles > histogram->max) {
+    histogram->max = cycles;
+  }
+  histogram->buckets[BucketIndex(cycles)]++;
+}
+
+esp_err_t PrintProfile() {
+  printf("Profile (us)                 count       mean        p50        p95"
+         "        p99        max\n");
+  for (size_t i = 0; i < PROFILE_PROBE_COUNT; i++) {
+    const histogram_t* histogram = &histograms[i];
+    if (histogram->count == 0) {
+      continue;
+    }
+    printf("  %-20s %10" PRIu32, probe_names[i], histogram->count);
+    PrintMicroseconds(histogram->sum / histogram->count);
+    PrintMicroseconds(Percentile(histogram, 50));
+    PrintMicroseconds(Percentile(histogram, 95));
+    PrintMicroseconds(Percentile(histogram, 99));
+    PrintMicroseconds(histogram->max);
+    printf("\n");
+  }
+  return ESP_OK;
+}
+
+esp_err_t ResetProfile() {
+  memset(histograms, 0, sizeof(histograms));
+  return ESP_OK;
+}
+
+#else  // CONFIG_MICRO_KWS_PROFILE
+
+esp_err_t PrintProfile() { return ESP_OK; }
+
+esp_err_t ResetProfile() { return ESP_OK; }
+
+#endif  // CONFIG_MICRO_KWS_PROFILE
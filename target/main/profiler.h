@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Lightweight latency probes based on the CPU cycle counter. Every probe owns a
+// histogram from which the median, 95th and 99th percentile are printed.
+//
+// The probes are only compiled in with CONFIG_MICRO_KWS_PROFILE, otherwise all
+// PROFILE_* macros expand to nothing. This header is also used by the C sources
+// of the microfrontend.
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#ifdef CONFIG_MICRO_KWS_PROFILE
+#include "esp_cpu.h"
+#endif  // CONFIG_MICRO_KWS_PROFILE
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Probe identifiers. Keep in sync with the names in profiler.cc.
+typedef enum {
+  PROFILE_AUDIO_RECEIVE,
+  PROFILE_AUDIO_RESAMPLE,
+  PROFILE_AUDIO_CHANNELS,
+  PROFILE_FRONTEND,
+  PROFILE_FRONTEND_WINDOW,
+  PROFILE_FRONTEND_FFT,
+  PROFILE_FRONTEND_FILTERBANK,
+  PROFILE_FRONTEND_NOISE_REDUCTION,
+  PROFILE_FRONTEND_PCAN,
+  PROFILE_FRONTEND_LOG_SCALE,
+  PROFILE_FEATURE_WINDOW,
+  PROFILE_MODEL_INVOKE,
+  PROFILE_POSTERIORS,
+  PROFILE_KEYWORD_AUDIO,
+  PROFILE_DEBUG_RUN,
+  PROFILE_PROBE_COUNT
+} profile_probe_t;
+
+#ifdef CONFIG_MICRO_KWS_PROFILE
+
+// Adds one measurement of `cycles` to the histogram of `probe`.
+void ProfilerRecord(profile_probe_t probe, uint32_t cycles);
+
+// Starts and stops a measurement within the same scope. Measurements that are
+// started but not stopped, e.g. because of an early return, are dropped.
+#define PROFILE_BEGIN(probe) \
+  const uint32_t profile_start_##probe = esp_cpu_get_ccount()
+#define PROFILE_END(probe) \
+  ProfilerRecord(probe, esp_cpu_get_ccount() - profile_start_##probe)
+
+#else  // CONFIG_MICRO_KWS_PROFILE
+
+#define PROFILE_BEGIN(probe) \
+  do {                       \
+  } while (0)
+#define PROFILE_END(probe) \
+  do {                     \
+  } while (0)
+
+#endif  // CONFIG_MICRO_KWS_PROFILE
+
+// Prints count, mean, percentiles and maximum of every probe that was hit so
+// far. Does nothing if the profiler is disabled.
+esp_err_t PrintProfile(void);
+
+// Clears all histograms.
+esp_err_t ResetProfile(void);
+
+#ifdef __cplusplus
+}
+
+#ifdef CONFIG_MICRO_KWS_PROFILE
+// Measures the time until the end of the enclosing scope.
+class ProfileScope {
+ public:
+  explicit ProfileScope(profile_probe_t probe)
+      : probe_(probe), start_(esp_cpu_get_ccount()) {}
+  ~ProfileScope() { ProfilerRecord(probe_, esp_cpu_get_ccount() - start_); }
+
+ private:
+  const profile_probe_t probe_;
+  const uint32_t start_;
+};
+
+#define PROFILE_SCOPE(probe) ProfileScope profile_scope_##probe(probe)
+#else  // CONFIG_MICRO_KWS_PROFILE
+#define PROFILE_SCOPE(probe) \
+  do {                       \
+  } while (0)
+#endif  // CONFIG_MICRO_KWS_PROFILE
+
+#endif  // __cplusplus
+
+#endif  // PROFILER_H
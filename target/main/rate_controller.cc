@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rate_controller.h"
+
+// The intervals are multiples of the tick period, as the main loop waits with
+// vTaskDelayUntil(). Never go below one tick, otherwise the loop would run the
+// model on the same feature window over and over.
+static TickType_t MsToIntervalTicks(uint32_t ms) {
+  const TickType_t ticks = ms / portTICK_PERIOD_MS;
+  return ticks > 0 ? ticks : 1;
+}
+
+static TickType_t min_interval_ticks = 0;
+static TickType_t interval_ticks = 0;
+
+#ifdef CONFIG_MICRO_KWS_ADAPTIVE_RATE
+static TickType_t max_interval_ticks = 0;
+// Average duration of model_invoke().
+static uint32_t inference_us_avg = 0;
+// Time since the last posterior above the threshold.
+static uint32_t quiet_ms = 0;
+#endif  // CONFIG_MICRO_KWS_ADAPTIVE_RATE
+
+esp_err_t InitializeRateController() {
+  min_interval_ticks = MsToIntervalTicks(1000 / CONFIG_MICRO_KWS_MAX_RATE);
+  interval_ticks = min_interval_ticks;
+#ifdef CONFIG_MICRO_KWS_ADAPTIVE_RATE
+  max_interval_ticks = MsToIntervalTicks(1000 / CONFIG_MICRO_KWS_MIN_RATE);
+  if (max_interval_ticks < min_interval_ticks) {
+    max_interval_ticks = min_interval_ticks;
+  }
+  inference_us_avg = 0;
+  quiet_ms = 0;
+#endif  // CONFIG_MICRO_KWS_ADAPTIVE_RATE
+  return ESP_OK;
+}
+
+void UpdateRateController(uint32_t inference_us,
+                          const uint8_t posteriors[category_count]) {
+#ifdef CONFIG_MICRO_KWS_ADAPTIVE_RATE
+  // Exponential moving average over roughly the last 8 inferences, so that a
+  // single slow inference (e.g. interrupted by another task) does not matter.
+  if (inference_us_avg == 0) {
+    inference_us_avg = inference_us;
+  } else {
+    inference_us_avg -= inference_us_avg / 8;
+    inference_us_avg += inference_us / 8;
+  }
+
+  // Category 0 is silence, everything else means that something is going on.
+  bool rising = false;
+  for (size_t i = 1; i < category_count; i++) {
+    if (posteriors[i] >= CONFIG_MICRO_KWS_ADAPTIVE_RATE_THRESHOLD) {
+      rising = true;
+    }
+  }
+
+  TickType_t new_interval_ticks = interval_ticks;
+  if (rising) {
+    quiet_ms = 0;
+    new_interval_ticks = min_interval_ticks;
+  } else {
+    quiet_ms += interval_ticks * portTICK_PERIOD_MS;
+    if (quiet_ms >= CONFIG_MICRO_KWS_ADAPTIVE_RATE_HOLD_MS) {
+      quiet_ms = 0;
+      new_interval_ticks = 2 * interval_ticks;
+    }
+  }
+
+  // Leave enough CPU time for the frontend and the other tasks. Round up, so
+  // that the load stays below the limit.
+  const uint32_t load_interval_ms =
+      inference_us_avg / (10 * CONFIG_MICRO_KWS_ADAPTIVE_RATE_MAX_LOAD);
+  const TickType_t load_interval_ticks =
+      (load_interval_ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS;
+  if (new_interval_ticks < load_interval_ticks) {
+    new_interval_ticks = load_interval_ticks;
+  }
+
+  if (new_interval_ticks < min_interval_ticks) {
+    new_interval_ticks = min_interval_ticks;
+  } else if (new_interval_ticks > max_interval_ticks) {
+    new_interval_ticks = max_interval_ticks;
+  }
+  interval_ticks = new_interval_ticks;
+#endif  // CONFIG_MICRO_KWS_ADAPTIVE_RATE
+}
+
+TickType_t GetInferenceIntervalTicks() { return interval_ticks; }
+
+uint32_t GetInferenceIntervalMs() {
+  return interval_ticks * portTICK_PERIOD_MS;
+}
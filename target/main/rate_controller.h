@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RATE_CONTROLLER_H
+#define RATE_CONTROLLER_H
+
+#include <cstdint>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "model_settings.h"
+
+// Chooses the time between two inferences. Without
+// CONFIG_MICRO_KWS_ADAPTIVE_RATE this is simply 1/CONFIG_MICRO_KWS_MAX_RATE.
+//
+// Otherwise the rate starts at CONFIG_MICRO_KWS_MAX_RATE and is halved for
+// every CONFIG_MICRO_KWS_ADAPTIVE_RATE_HOLD_MS without any non-silence
+// posterior above CONFIG_MICRO_KWS_ADAPTIVE_RATE_THRESHOLD, down to
+// CONFIG_MICRO_KWS_MIN_RATE. As soon as such a posterior shows up, it jumps
+// back to the maximum. Independent of that, the rate is limited such that the
+// model uses at most CONFIG_MICRO_KWS_ADAPTIVE_RATE_MAX_LOAD percent of the CPU
+// time, based on the measured model latency.
+
+esp_err_t InitializeRateController();
+
+// Updates the controller with the duration of the last model_invoke() and the
+// resulting posteriors.
+void UpdateRateController(uint32_t inference_us,
+                          const uint8_t posteriors[category_count]);
+
+// Current time between two inferences, in ticks and in ms.
+TickType_t GetInferenceIntervalTicks();
+uint32_t GetInferenceIntervalMs();
+
+#endif  // RATE_CONTROLLER_H
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "resampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+
+#include "esp_log.h"
+
+// Zeroth order modified Bessel function of the first kind, for the Kaiser
+// window.
+static double BesselI0(double x) {
+  double sum = 1.0;
+  double term = 1.0;
+  for (int k = 1; k < 50 && term > 1e-12 * sum; k++) {
+    const double factor = x / (2 * k);
+    term *= factor * factor;
+    sum += term;
+  }
+  return sum;
+}
+
+// Fills in the coefficients of all phases. The prototype filter runs at `up`
+// times the input rate and has `up * taps` coefficients, the phase p consists
+// of every up-th of them, starting at p.
+static esp_err_t DesignFilter(resampler_t* resampler, uint32_t input_rate,
+                              uint32_t output_rate) {
+  const uint32_t up = resampler->up;
+  const uint32_t taps = resampler->taps;
+  const uint32_t length = up * taps;
+  const double prototype_rate = (double)input_rate * up;
+  const double low_rate = std::min(input_rate, output_rate);
+  const double pass = low_rate * 7 / 16;
+  const double stop = low_rate * 9 / 16;
+  const double cutoff = (pass + stop) / 2 / prototype_rate;
+
+  // Kaiser's formulas for the attenuation reachable with this length and
+  // transition width, and the window shape that reaches it.
+  const double transition = 2 * M_PI * (stop - pass) / prototype_rate;
+  const double attenuation = 2.285 * (length - 1) * transition + 8;
+  double beta = 0.0;
+  if (attenuation > 50) {
+    beta = 0.1102 * (attenuation - 8.7);
+  } else if (attenuation > 21) {
+    beta = 0.5842 * pow(attenuation - 21, 0.4) +
+           0.07886 * (attenuation - 21);
+  }
+
+  double* prototype = (double*)malloc(length * sizeof(double));
+  if (prototype == NULL) {
+    ESP_LOGE(__FILE__, "ERROR: In DesignFilter() at malloc().");
+    return ESP_ERR_NO_MEM;
+  }
+  const double center = (length - 1) / 2.0;
+  for (uint32_t k = 0; k < length; k++) {
+    const double t = k - center;
+    const double sinc =
+        t == 0 ? 1.0 : sin(2 * M_PI * cutoff * t) / (2 * M_PI * cutoff * t);
+    const double r = t / center;
+    prototype[k] = sinc * BesselI0(beta * sqrt(1 - r * r));
+  }
+
+  // Every phase gets a DC gain of exactly one, which keeps the quantization of
+  // the coefficients from modulating the signal with the phase.
+  for (uint32_t phase = 0; phase < up; phase++) {
+    double sum = 0.0;
+    for (uint32_t j = 0; j < taps; j++) {
+      sum += prototype[phase + j * up];
+    }
+    int16_t* coeffs = &resampler->coeffs[phase * taps];
+    for (uint32_t j = 0; j < taps; j++) {
+      const long value = lround(prototype[phase + j * up] / sum * 32768);
+      coeffs[taps - 1 - j] = (int16_t)std::clamp<long>(value, -32768, 32767);
+    }
+  }
+
+  free(prototype);
+  return ESP_OK;
+}
+
+esp_err_t InitializeResampler(resampler_t* resampler, uint32_t input_rate,
+                              uint32_t output_rate, uint32_t taps) {
+  if (input_rate == 0 || output_rate == 0 || taps == 0) {
+    ESP_LOGE(__FILE__, "ERROR: In InitializeResampler(). Invalid arguments.");
+    return ESP_ERR_INVALID_ARG;
+  }
+  const uint32_t divisor = std::gcd(input_rate, output_rate);
+  resampler->up = output_rate / divisor;
+  resampler->down = input_rate / divisor;
+  resampler->taps = (taps + 3) & ~3;
+  resampler->coeffs = (int16_t*)malloc(resampler->up * resampler->taps *
+                                       sizeof(int16_t));
+  resampler->history =
+      (int16_t*)malloc(2 * resampler->taps * sizeof(int16_t));
+  if (resampler->coeffs == NULL || resampler->history == NULL) {
+    ESP_LOGE(__FILE__, "ERROR: In InitializeResampler() at malloc().");
+    FreeResampler(resampler);
+    return ESP_ERR_NO_MEM;
+  }
+
+  esp_err_t ret = DesignFilter(resampler, input_rate, output_rate);
+  if (ret != ESP_OK) {
+    ESP_LOGE(__FILE__, "ERROR: In InitializeResampler() at DesignFilter().");
+    FreeResampler(resampler);
+    return ret;
+  }
+  return ResetResampler(resampler);
+}
+
+void FreeResampler(resampler_t* resampler) {
+  free(resampler->coeffs);
+  free(resampler->history);
+  resampler->coeffs = NULL;
+  resampler->history = NULL;
+}
+
+esp_err_t ResetResampler(resampler_t* resampler) {
+  memset(resampler->history, 0, 2 * resampler->taps * sizeof(int16_t));
+  resampler->history_pos = 0;
+  resampler->phase = 0;
+  resampler->input_needed = 1;
+  return ESP_OK;
+}
+
+size_t GetResamplerSize(const resampler_t* resampler) {
+  return (resampler->up + 2) * resampler->taps * sizeof(int16_t);
+}
+
+// The number of coefficients is a multiple of four. Two independent sums of
+// two products each leave the compiler free to use packed instructions.
+static int32_t DotProduct(const int16_t* __restrict a,
+                          const int16_t* __restrict b, uint32_t n) {
+  int32_t sum0 = 0;
+  int32_t sum1 = 0;
+  for (uint32_t i = 0; i < n; i += 4) {
+    sum0 += a[i] * b[i] + a[i + 1] * b[i + 1];
+    sum1 += a[i + 2] * b[i + 2] + a[i + 3] * b[i + 3];
+  }
+  return sum0 + sum1;
+}
+
+esp_err_t Resample(resampler_t* resampler, const int16_t* input,
+                   size_t input_size, size_t* input_read, int16_t* output,
+                   size_t output_size, size_t* output_written) {
+  const uint32_t taps = resampler->taps;
+  int16_t* history = resampler->history;
+  size_t num_read = 0;
+  size_t num_written = 0;
+
+  while (true) {
+    // Take the input samples up to the one the next output sample is centered
+    // on.
+    while (resampler->input_needed > 0 && num_read < input_size) {
+      const int16_t sample = input[num_read++];
+      history[resampler->history_pos] = sample;
+      history[resampler->history_pos + taps] = sample;
+      resampler->history_pos++;
+      if (resampler->history_pos == taps) {
+        resampler->history_pos = 0;
+      }
+      resampler->input_needed--;
+    }
+    if (resampler->input_needed > 0 || num_written == output_size) {
+      break;
+    }
+
+    // The sum of the absolute values of each phase stays below two, so the
+    // sum can not overflow.
+    const int32_t sum =
+        DotProduct(&resampler->coeffs[resampler->phase * taps],
+                   &history[resampler->history_pos], taps);
+    output[num_written++] =
+        (int16_t)std::clamp<int32_t>((sum + (1 << 14)) >> 15, -32768, 32767);
+
+    resampler->phase += resampler->down;
+    resampler->input_needed = resampler->phase / resampler->up;
+    resampler->phase %= resampler->up;
+  }
+
+  *input_read = num_read;
+  *output_written = num_written;
+  return ESP_OK;
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+
+// Streaming fixed-point polyphase resampler for 16 bit mono audio. The input
+// rate is converted to the output rate by the rational factor up / down, e.g.
+// 1 / 3 for 48 kHz to 16 kHz and 160 / 441 for 44.1 kHz to 16 kHz.
+//
+// The anti-aliasing filter is a Kaiser windowed sinc, designed once when the
+// resampler is initialized. It is split into `up` phases of `taps`
+// coefficients each, so every output sample costs `taps` multiply-accumulates,
+// no matter the ratio. Each phase and the input history are stored as
+// contiguous int16_t arrays, so that the dot product maps onto packed 16 bit
+// multiply-accumulate instructions where available.
+typedef struct {
+  uint32_t up;
+  uint32_t down;
+  // Coefficients per phase, rounded up to a multiple of four.
+  uint32_t taps;
+  // The Q15 coefficients of all phases, reversed so that they line up with
+  // the history from the oldest to the newest sample.
+  int16_t* coeffs;
+  // The last `taps` input samples, stored twice so that they are always
+  // contiguous, starting at `history[history_pos]`.
+  int16_t* history;
+  uint32_t history_pos;
+  // Phase of the next output sample and the number of input samples to take
+  // before it can be computed.
+  uint32_t phase;
+  uint32_t input_needed;
+} resampler_t;
+
+// Designs the filter for converting `input_rate` to `output_rate` with at
+// least `taps` coefficients per phase. The passband extends to 7/16 of the
+// lower rate and the stopband starts at 9/16 of it, so aliases only fall
+// above the passband. The filter and history are allocated on the heap.
+esp_err_t InitializeResampler(resampler_t* resampler, uint32_t input_rate,
+                              uint32_t output_rate, uint32_t taps);
+
+void FreeResampler(resampler_t* resampler);
+
+// Forgets all previous input samples.
+esp_err_t ResetResampler(resampler_t* resampler);
+
+// Number of bytes allocated by InitializeResampler().
+size_t GetResamplerSize(const resampler_t* resampler);
+
+// Takes up to `input_size` samples from `input` and writes up to `output_size`
+// samples to `output`. Stops as soon as either the input is used up or the
+// output is full, the remaining input has to be passed again in the next
+// call.
+esp_err_t Resample(resampler_t* resampler, const int16_t* input,
+                   size_t input_size, size_t* input_read, int16_t* output,
+                   size_t output_size, size_t* output_written);
+
+#endif  // RESAMPLER_H
@@ -0,0 +1,68 @@
+#[[
+Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+
+This file is part of MLonMCU.
+See https://github.com/tum-ei-eda/mlonmcu.git for further info.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+]]
+
+# Sources shared by the ESP-IDF component (CMakeLists.txt) and the host build (../host/CMakeLists.txt), relative to this
+# directory.
+
+set(MICROFRONTEND_DIR microfrontend)
+
+set(MICROFRONTEND_SRCS
+    ${MICROFRONTEND_DIR}/lib/fft.cc
+    ${MICROFRONTEND_DIR}/lib/fft_util.cc
+    ${MICROFRONTEND_DIR}/lib/filterbank.c
+    ${MICROFRONTEND_DIR}/lib/filterbank_util.c
+    ${MICROFRONTEND_DIR}/lib/frontend.c
+    ${MICROFRONTEND_DIR}/lib/frontend_util.c
+    ${MICROFRONTEND_DIR}/lib/log_lut.c
+    ${MICROFRONTEND_DIR}/lib/log_scale.c
+    ${MICROFRONTEND_DIR}/lib/log_scale_util.c
+    ${MICROFRONTEND_DIR}/lib/noise_reduction.c
+    ${MICROFRONTEND_DIR}/lib/noise_reduction_util.c
+    ${MICROFRONTEND_DIR}/lib/pcan_gain_control_util.c
+    ${MICROFRONTEND_DIR}/lib/pcan_gain_control.c
+    ${MICROFRONTEND_DIR}/lib/window.c
+    ${MICROFRONTEND_DIR}/lib/window_util.c
+)
+
+set(MICRO_KWS_SRCS
+    adpcm.cc
+    audio.cc
+    audio_convert.cc
+    audio_pacing.cc
+    audio_source_i2s.cc
+    audio_source_pcm.cc
+    audio_source_stream.cc
+    audio_source_synth.cc
+    backend.cc
+    beamformer.cc
+    debug.cc
+    feature_window.cc
+    frontend.cc
+    frontend_tables.cc
+    gpio.cc
+    keyword_audio.cc
+    memory_report.cc
+    model_settings.cc
+    pipeline_stats.cc
+    profiler.cc
+    rate_controller.cc
+    resampler.cc
+    tvm_wrapper.cc
+    vad.cc
+)
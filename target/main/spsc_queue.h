@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded lock-free queue for exactly one producer and one consumer task.
+//
+// Items are written and read in place: the producer fills the slot returned by
+// AcquireWrite() and publishes it with CommitWrite(), the consumer reads the
+// slot returned by Peek() and frees it with Release(). Only plain atomic loads
+// and stores are used (no read-modify-write operations), so this also works on
+// cores without atomic instructions, like the RV32IMC core of the ESP32-C3.
+//
+// With a history of H items, the last H released items stay in their slots
+// until H more items have been released, so they can still be looked at, see
+// Hold(). Their slots are not available to the producer, so the queue itself
+// only holds N - H items.
+//
+// N does not have to be a power of two, so that a history does not round the
+// queue up to the next one. Then the counters wrap around at a multiple of N
+// instead of at SIZE_MAX, see Advance(), which costs a compare per step and a
+// division by a constant per access.
+template <typename T, size_t N, size_t H = 0>
+class SpscQueue {
+  static_assert(N > 0, "SpscQueue length has to be positive.");
+  static_assert(H < N, "SpscQueue history has to be shorter than the queue.");
+
+ public:
+  // Returns the next free slot or NULL if the queue is full. Producer only.
+  T* AcquireWrite() {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (Distance(head, tail_.load(std::memory_order_acquire)) >= N - H) {
+      return NULL;
+    }
+    if (H > 0 && held_.load() && Distance(head, hold_.load()) >= N) {
+      return NULL;
+    }
+    return &items_[SlotOfNumber(head)];
+  }
+
+  // Publishes the slot returned by AcquireWrite(). Producer only.
+  void CommitWrite() {
+    head_.store(Advance(head_.load(std::memory_order_relaxed), 1),
+                std::memory_order_release);
+  }
+
+  // Returns the oldest item or NULL if the queue is empty. Consumer only.
+  T* Peek() { return PeekAt(0); }
+
+  // Returns the `index`-th oldest item or NULL if there are not that many.
+  // Consumer only.
+  T* PeekAt(size_t index) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (Distance(head_.load(std::memory_order_acquire), tail) <= index) {
+      return NULL;
+    }
+    // There are less than N items, so the slot wraps around at most once.
+    const size_t slot = SlotOfNumber(tail) + index;
+    return &items_[slot < N ? slot : slot - N];
+  }
+
+  // Frees the slot returned by Peek(). Consumer only.
+  void Release() {
+    tail_.store(Advance(tail_.load(std::memory_order_relaxed), 1),
+                std::memory_order_release);
+  }
+
+  // Number of items currently in the queue. Can be called from both sides, but
+  // is only a snapshot as the other side might be running concurrently.
+  size_t Size() const {
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    return Distance(head_.load(std::memory_order_acquire), tail);
+  }
+
+  size_t Free() const { return Capacity() - Size(); }
+
+  static constexpr size_t Capacity() { return N - H; }
+
+  // Position of `item` in the storage of the queue, e.g. for keeping more data
+  // per slot in a separate array. The slots lie back to back, so consecutive
+  // items are adjacent in memory, except where the queue wraps around from the
+  // last slot to the first one.
+  size_t SlotOf(const T* item) const { return item - items_; }
+
+  // The item at position `slot` of the storage, see SlotOf().
+  T* AtSlot(size_t slot) { return &items_[slot]; }
+
+  // Keeps the producer from overwriting the items of the history and the
+  // queue until Unhold(), e.g. while another task than the consumer reads
+  // them. Once there are N items from the oldest held one on, the queue counts
+  // as full. Items are numbered in the order they were written in, and all
+  // items from the returned number up to End() stay valid, see ItemAt() and
+  // Next(). Can be called by one task besides the producer, which may also be
+  // the consumer.
+  size_t Hold() {
+    const size_t tail = tail_.load();
+    // Right after the counters wrapped around, which takes years, the history
+    // is shorter for a moment.
+    size_t first = tail - std::min(tail, H);
+    hold_.store(first);
+    held_.store(true);
+    // The producer might have acquired a slot before it saw the hold. That
+    // slot can only be the one of the next item, so the items up to N before
+    // it are safe.
+    const size_t head = head_.load();
+    if (Distance(head, first) >= N) {
+      first = Retreat(head, N - 1);
+      hold_.store(first);
+    }
+    return first;
+  }
+
+  void Unhold() { held_.store(false); }
+
+  // Number of the next item the producer writes, see Hold().
+  size_t End() const { return head_.load(std::memory_order_acquire); }
+
+  // The item numbered `number`, see Hold().
+  T* ItemAt(size_t number) { return &items_[SlotOfNumber(number)]; }
+
+  // Number of the item after the one numbered `number`, see Hold().
+  static size_t Next(size_t number) { return Advance(number, 1); }
+
+ private:
+  // Items are numbered by the head and tail counters. With a power of two N,
+  // they simply overflow and their lower bits are the slot. Otherwise they run
+  // through [0, wrap_), the largest multiple of N, so that the slot stays the
+  // remainder by N when they wrap around.
+  static constexpr bool power_of_two_ = (N & (N - 1)) == 0;
+  static constexpr size_t wrap_ = N * (SIZE_MAX / N);
+
+  static size_t Advance(size_t number, size_t count) {
+    if (power_of_two_) {
+      return number + count;
+    }
+    return number >= wrap_ - count ? number - (wrap_ - count) : number + count;
+  }
+
+  static size_t Retreat(size_t number, size_t count) {
+    if (power_of_two_) {
+      return number - count;
+    }
+    return number >= count ? number - count : number + (wrap_ - count);
+  }
+
+  // Number of items from `from` up to `to`.
+  static size_t Distance(size_t to, size_t from) {
+    if (power_of_two_ || to >= from) {
+      return to - from;
+    }
+    return to + (wrap_ - from);
+  }
+
+  static size_t SlotOfNumber(size_t number) {
+    return power_of_two_ ? number & (N - 1) : number % N;
+  }
+
+  T items_[N];
+  std::atomic<size_t> head_{0};
+  std::atomic<size_t> tail_{0};
+  // Number of the oldest item the producer must not overwrite while held.
+  std::atomic<size_t> hold_{0};
+  std::atomic<bool> held_{false};
+};
+
+#endif  // SPSC_QUEUE_H
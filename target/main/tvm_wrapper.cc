@@ -35,10 +35,15 @@
 #define DBGPRINTF(format, ...)
 #endif
 
-// Define data for input and output tensors
-char input0_data[1960];
-void* inputs[] = {input0_data};
-struct tvmgen_default_inputs tvmgen_default_inputs = {input0_data};
+#if defined(CONFIG_MICRO_KWS_STREAM) && !defined(TVMGEN_DEFAULT_HAS_STREAM)
+#error "CONFIG_MICRO_KWS_STREAM is not supported by the selected MLF."
+#endif
+
+// Define data for input and output tensors. The input tensor has no buffer of
+// its own, as the model reads the features directly from the feature window.
+// See model_set_input_ptr().
+void* inputs[] = {NULL};
+struct tvmgen_default_inputs tvmgen_default_inputs = {NULL};
 char output0_data[CONFIG_MICRO_KWS_NUM_CLASSES];
 void* outputs[] = {output0_data};
 struct tvmgen_default_outputs tvmgen_default_outputs = {output0_data};
@@ -65,8 +70,33 @@ void __attribute__((noreturn)) TVMPlatformAbort(tvm_crt_error_t code) {
 
 void* model_input_ptr(size_t index) { return inputs[index]; }
 
+esp_err_t model_set_input_ptr(size_t index, void* data) {
+  if (index >= sizeof(inputs) / sizeof(inputs[0])) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  inputs[index] = data;
+  tvmgen_default_inputs.serving_default_input_0 = data;
+  return ESP_OK;
+}
+
+esp_err_t model_set_input_position(uint32_t position) {
+#ifdef CONFIG_MICRO_KWS_STREAM
+  tvmgen_default_set_stream_position(position);
+#endif
+  return ESP_OK;
+}
+
+esp_err_t model_reset_input_position() {
+#ifdef CONFIG_MICRO_KWS_STREAM
+  tvmgen_default_reset_stream();
+#endif
+  return ESP_OK;
+}
+
 void* model_output_ptr(size_t index) { return outputs[index]; }
 
+size_t model_output_size(size_t index) { return sizeof(output0_data); }
+
 esp_err_t model_invoke() {
   if (tvmgen_default_run(&tvmgen_default_inputs, &tvmgen_default_outputs)) {
     TVMPlatformAbort(kTvmErrorPlatformCheckFailure);
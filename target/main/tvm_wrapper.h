@@ -27,8 +27,25 @@
 
 void* model_input_ptr(size_t index);
 
+// Lets the model read input `index` directly from `data` instead of from a
+// separate input buffer. The memory has to stay valid during model_invoke().
+esp_err_t model_set_input_ptr(size_t index, void* data);
+
+// Tells the model that the next input is the feature window starting at the
+// absolute slice index `position` (see GetFeatureWindowPosition()). With
+// CONFIG_MICRO_KWS_STREAM the model then reuses the results of its first layer
+// for the slices it has already seen. Does nothing otherwise.
+esp_err_t model_set_input_position(uint32_t position);
+
+// Makes the model forget all previously seen slices, e.g. after the feature
+// window has been cleared.
+esp_err_t model_reset_input_position();
+
 void* model_output_ptr(size_t index);
 
+// Size in bytes of output `index`.
+size_t model_output_size(size_t index);
+
 esp_err_t model_invoke();
 
 #endif  // TVM_WRAPPER_H
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vad.h"
+
+#include "model_settings.h"
+
+#ifdef CONFIG_MICRO_KWS_VAD
+constexpr uint32_t vad_hangover_slices =
+    CONFIG_MICRO_KWS_VAD_HANGOVER_MS / feature_slice_stride_ms;
+#else   // CONFIG_MICRO_KWS_VAD
+constexpr uint32_t vad_hangover_slices = 0;
+#endif  // CONFIG_MICRO_KWS_VAD
+
+// Number of slices left until the VAD becomes inactive, including the current
+// one.
+static uint32_t hangover_slices_left = 0;
+
+esp_err_t InitializeVad() {
+  // Start active, the noise estimate of the frontend needs some time to settle
+  // anyway.
+  hangover_slices_left = vad_hangover_slices + 1;
+  return ESP_OK;
+}
+
+#ifdef CONFIG_MICRO_KWS_VAD
+// Whether enough of the filterbank channels of `slice` are above the threshold.
+static bool IsSpeechLike(const int8_t* slice) {
+  size_t active_channels = 0;
+  for (size_t i = 0; i < feature_slice_size; i++) {
+    if (slice[i] >= CONFIG_MICRO_KWS_VAD_THRESHOLD) {
+      active_channels++;
+    }
+  }
+  return active_channels >= CONFIG_MICRO_KWS_VAD_MIN_CHANNELS;
+}
+#endif  // CONFIG_MICRO_KWS_VAD
+
+bool VadProcessSlice(const int8_t* slices, size_t num_channels) {
+#ifdef CONFIG_MICRO_KWS_VAD
+  for (size_t channel = 0; channel < num_channels; channel++) {
+    if (IsSpeechLike(&slices[channel * feature_slice_size])) {
+      hangover_slices_left = vad_hangover_slices + 1;
+      return true;
+    }
+  }
+  if (hangover_slices_left > 0) {
+    hangover_slices_left--;
+  }
+  return false;
+#else   // CONFIG_MICRO_KWS_VAD
+  return true;
+#endif  // CONFIG_MICRO_KWS_VAD
+}
+
+bool VadIsActive() {
+#ifdef CONFIG_MICRO_KWS_VAD
+  return hangover_slices_left > 0;
+#else   // CONFIG_MICRO_KWS_VAD
+  return true;
+#endif  // CONFIG_MICRO_KWS_VAD
+}
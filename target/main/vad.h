@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2022 TUM Department of Electrical and Computer Engineering.
+ *
+ * This file is part of the MicroKWS project.
+ * See https://gitlab.lrz.de/de-tum-ei-eda-esl/ESD4ML/micro-kws for further
+ * info.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VAD_H
+#define VAD_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+
+// Energy based voice activity detection on the feature slices. A slice is
+// speech-like if enough of its channels are above a threshold. The features
+// are the log of the gain controlled SNR computed by the frontend's noise
+// reduction and PCAN, so steady background noise ends up close to the minimum.
+//
+// After the last speech-like slice, the VAD stays active for a hangover time.
+// There is no need for a separate pre-roll, as the feature window is updated
+// with every slice and already contains the onset when the VAD becomes active.
+
+esp_err_t InitializeVad();
+
+// Updates the VAD with the next feature slice, given as the slices of
+// `num_channels` audio channels back to back. Returns whether the slice itself
+// is speech-like, i.e. whether the slice of any of the channels is.
+bool VadProcessSlice(const int8_t* slices, size_t num_channels);
+
+// Whether there was speech-like energy within the hangover time.
+bool VadIsActive();
+
+#endif  // VAD_H